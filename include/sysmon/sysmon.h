@@ -38,22 +38,35 @@ typedef struct sysmon_metric {
     uint64_t u64;
     const char *str;
   } value;
+  uint64_t sample_ns; /* monotonic capture time of the module refresh that produced the value */
 } sysmon_metric_t;
 
 typedef struct sysmon_create_options {
   const char *ini_path;
+  const char *proc_root; /* default: "/proc" */
+  const char *sys_root;  /* default: "/sys" */
 } sysmon_create_options_t;
 
 sysmon_result_t sysmon_create(const sysmon_create_options_t *options, sysmon_t **out_sysmon);
 void sysmon_destroy(sysmon_t *sysmon);
 
 sysmon_result_t sysmon_poll(sysmon_t *sysmon, sysmon_snapshot_t **out_snapshot);
+/* Sleeps up to timeout_ms, returning early when a module receives a kernel event
+ * (PSI trigger, uevent, mount change...). *out_changed (may be NULL) is set when one of
+ * those events changes what the module reports; call sysmon_poll then, otherwise wait
+ * again for the rest of the interval. */
+sysmon_result_t sysmon_wait(sysmon_t *sysmon, uint32_t timeout_ms, bool *out_changed);
 void sysmon_snapshot_destroy(sysmon_snapshot_t *snapshot);
 
 size_t sysmon_snapshot_metric_count(const sysmon_snapshot_t *snapshot);
 const sysmon_metric_t *sysmon_snapshot_metric_at(const sysmon_snapshot_t *snapshot, size_t index);
+const sysmon_metric_t *sysmon_snapshot_metrics(const sysmon_snapshot_t *snapshot, size_t *out_count);
 const sysmon_metric_t *sysmon_snapshot_find(const sysmon_snapshot_t *snapshot, const char *name);
 
+uint64_t sysmon_snapshot_timestamp_ns(const sysmon_snapshot_t *snapshot);
+uint64_t sysmon_snapshot_metric_age_ns(const sysmon_snapshot_t *snapshot,
+                                       const sysmon_metric_t *metric);
+
 uint32_t sysmon_interval_ms(const sysmon_t *sysmon);
 const char *sysmon_last_error(const sysmon_t *sysmon);
 
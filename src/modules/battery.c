@@ -12,12 +12,24 @@
 #include <IOKit/ps/IOPSKeys.h>
 #elif defined(__linux__)
 #include <dirent.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #endif
 
+#define SYSMON_BATTERY_DEFAULT_FALLBACK_MS 60000u
+
 typedef struct battery_state {
 #if defined(__linux__)
-  char base_path[256];
+  char supply_root[SYSMON_PATH_LEN];
+  char base_path[SYSMON_PATH_LEN + 64];
+  char supply_name[SYSMON_PATH_LEN + 64];
+  int uevent_fd;
+  uint32_t fallback_ms;
+  uint64_t last_sysfs_ns;
+  bool needs_rescan;
 #endif
   double last_percent;
   int64_t last_is_charging;
@@ -31,25 +43,38 @@ static void set_default_status(battery_state_t *st) {
   snprintf(st->last_status, sizeof(st->last_status), "%s", "unknown");
 }
 
+static sysmon_result_t add_battery_metrics(const battery_state_t *st,
+                                           sysmon_snapshot_builder_t *builder) {
+  sysmon_result_t rc = sysmon_snapshot_builder_add_double(builder, "battery.percent", "%", st->last_percent);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_i64(builder, "battery.is_charging", NULL, st->last_is_charging);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_string(builder, "battery.status", NULL, st->last_status);
+  if (rc != SYSMON_OK) return rc;
+  return SYSMON_OK;
+}
+
 #if defined(__linux__)
 static bool file_exists(const char *path) {
   struct stat st;
   return stat(path, &st) == 0;
 }
 
-static bool detect_battery_path(char *out_base_path, size_t out_len, char **out_error) {
-  const char *root = "/sys/class/power_supply";
+static bool detect_battery_path(const char *root, char *out_base_path, size_t out_len,
+                                char **out_error) {
   DIR *d = opendir(root);
   if (!d) {
-    sysmon_set_error(out_error, "failed to open /sys/class/power_supply");
+    char buf[SYSMON_PATH_LEN + 32];
+    snprintf(buf, sizeof(buf), "failed to open %s", root);
+    sysmon_set_error(out_error, buf);
     return false;
   }
   struct dirent *de = NULL;
   while ((de = readdir(d)) != NULL) {
     if (strncmp(de->d_name, "BAT", 3) != 0) continue;
-    char candidate[256];
+    char candidate[SYSMON_PATH_LEN + 64];
     snprintf(candidate, sizeof(candidate), "%s/%s", root, de->d_name);
-    char cap[320];
+    char cap[SYSMON_PATH_LEN + 128];
     snprintf(cap, sizeof(cap), "%s/capacity", candidate);
     if (file_exists(cap)) {
       snprintf(out_base_path, out_len, "%s", candidate);
@@ -58,7 +83,9 @@ static bool detect_battery_path(char *out_base_path, size_t out_len, char **out_
     }
   }
   closedir(d);
-  sysmon_set_error(out_error, "no battery found under /sys/class/power_supply");
+  char buf[SYSMON_PATH_LEN + 32];
+  snprintf(buf, sizeof(buf), "no battery found under %s", root);
+  sysmon_set_error(out_error, buf);
   return false;
 }
 
@@ -85,27 +112,196 @@ static bool read_string_file(const char *path, char *out, size_t out_len) {
   while (n > 0 && (out[n - 1] == '\n' || out[n - 1] == '\r')) out[--n] = '\0';
   return true;
 }
+
+static void set_supply_name(battery_state_t *st) {
+  const char *slash = strrchr(st->base_path, '/');
+  snprintf(st->supply_name, sizeof(st->supply_name), "%s", slash ? slash + 1 : st->base_path);
+}
+
+static bool read_battery_sysfs(battery_state_t *st, char **out_error) {
+  char cap_path[SYSMON_PATH_LEN + 128];
+  snprintf(cap_path, sizeof(cap_path), "%s/capacity", st->base_path);
+  uint32_t cap = 0;
+  if (!read_u32_file(cap_path, &cap)) {
+    sysmon_set_error(out_error, "failed to read battery capacity");
+    return false;
+  }
+  st->last_percent = (double)cap;
+
+  char status_path[SYSMON_PATH_LEN + 128];
+  snprintf(status_path, sizeof(status_path), "%s/status", st->base_path);
+  char status[32] = "unknown";
+  if (read_string_file(status_path, status, sizeof(status))) {
+    snprintf(st->last_status, sizeof(st->last_status), "%s", status);
+  }
+  st->last_is_charging = (strcasecmp(st->last_status, "Charging") == 0) ? 1 : 0;
+  return true;
+}
+
+static int open_uevent_socket(void) {
+  int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+  if (fd < 0) return -1;
+  struct sockaddr_nl addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = 1;
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/* Kernel uevents are "ACTION@DEVPATH" followed by NUL-separated KEY=VALUE pairs. The socket
+ * receives every subsystem's uevents; only power_supply ones for our supply (or a supply
+ * appearing) count as changes. */
+static bool apply_uevent(battery_state_t *st, const char *msg, size_t len) {
+  const char *at = memchr(msg, '@', len);
+  if (!at) return false;
+  const size_t action_len = (size_t)(at - msg);
+
+  const char *subsystem = NULL, *name = NULL, *capacity = NULL, *status = NULL;
+  const char *end = msg + len;
+  for (const char *p = msg + strnlen(msg, len) + 1; p < end; p += strnlen(p, (size_t)(end - p)) + 1) {
+    if (strncmp(p, "SUBSYSTEM=", 10) == 0) subsystem = p + 10;
+    else if (strncmp(p, "POWER_SUPPLY_NAME=", 18) == 0) name = p + 18;
+    else if (strncmp(p, "POWER_SUPPLY_CAPACITY=", 22) == 0) capacity = p + 22;
+    else if (strncmp(p, "POWER_SUPPLY_STATUS=", 20) == 0) status = p + 20;
+  }
+  if (!subsystem || strcmp(subsystem, "power_supply") != 0) return false;
+
+  if ((action_len == 3 && strncmp(msg, "add", 3) == 0) ||
+      (action_len == 6 && strncmp(msg, "remove", 6) == 0)) {
+    st->needs_rescan = true;
+    return true;
+  }
+  if (!name || strcmp(name, st->supply_name) != 0) {
+    if (!st->base_path[0] && name && strncmp(name, "BAT", 3) == 0) st->needs_rescan = true;
+    return st->needs_rescan;
+  }
+  if (capacity) st->last_percent = (double)strtoul(capacity, NULL, 10);
+  if (status) {
+    snprintf(st->last_status, sizeof(st->last_status), "%s", status);
+    st->last_is_charging = (strcasecmp(st->last_status, "Charging") == 0) ? 1 : 0;
+  }
+  return true;
+}
+
+static bool drain_uevents(battery_state_t *st) {
+  char buf[8192];
+  bool changed = false;
+  for (;;) {
+    struct sockaddr_nl from;
+    socklen_t from_len = sizeof(from);
+    ssize_t n = recvfrom(st->uevent_fd, buf, sizeof(buf) - 1, 0, (struct sockaddr *)&from, &from_len);
+    if (n < 0) {
+      if (errno == ENOBUFS) {
+        st->needs_rescan = true;
+        changed = true;
+        continue;
+      }
+      return changed;
+    }
+    if (from.nl_pid != 0) continue;
+    buf[n] = '\0';
+    if (apply_uevent(st, buf, (size_t)n)) changed = true;
+  }
+}
+
+static size_t battery_event_sources(void *state, sysmon_event_source_t *out, size_t max) {
+  battery_state_t *st = (battery_state_t *)state;
+  if (!st || st->uevent_fd < 0) return 0;
+  if (out && max > 0) {
+    out[0].fd = st->uevent_fd;
+    out[0].events = POLLIN;
+    out[0].revents = 0;
+  }
+  return 1;
+}
+
+static bool battery_on_event(void *state, const sysmon_event_source_t *source) {
+  battery_state_t *st = (battery_state_t *)state;
+  return st && (source->revents & POLLIN) && drain_uevents(st);
+}
+
+static sysmon_result_t battery_poll_uevent(battery_state_t *st, uint64_t now_ns,
+                                           sysmon_snapshot_builder_t *builder, char **out_error) {
+  drain_uevents(st);
+  if (st->needs_rescan) {
+    char *err = NULL;
+    if (!detect_battery_path(st->supply_root, st->base_path, sizeof(st->base_path), &err))
+      st->base_path[0] = '\0';
+    free(err);
+    set_supply_name(st);
+    st->needs_rescan = false;
+    st->has_data = false;
+  }
+  if (!st->base_path[0]) return SYSMON_OK;
+
+  /* Values between sysfs reads are kept current by uevents. */
+  sysmon_snapshot_builder_set_sample_ns(builder, now_ns);
+  const uint64_t fallback_ns = (uint64_t)st->fallback_ms * SYSMON_NS_PER_MS;
+  if (!st->has_data || now_ns - st->last_sysfs_ns >= fallback_ns) {
+    if (!read_battery_sysfs(st, out_error)) return SYSMON_ERR_IO;
+    st->last_sysfs_ns = now_ns;
+    st->has_data = true;
+  }
+  return add_battery_metrics(st, builder);
+}
+#endif
+
+static void battery_destroy(void *state) {
+  battery_state_t *st = (battery_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  if (st->uevent_fd >= 0) close(st->uevent_fd);
 #endif
+  free(st);
+}
 
-static sysmon_result_t battery_create(const sysmon_ini_t *ini, const char *section, void **out_state,
-                                      char **out_error) {
-  (void)ini;
-  (void)section;
+static sysmon_result_t battery_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                      const char *section, void **out_state, char **out_error) {
   if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
 
+  const char *mode = sysmon_ini_get(ini, section, "mode");
+  if (mode && *mode && strcmp(mode, "poll") != 0 && strcmp(mode, "uevent") != 0) {
+    sysmon_set_error(out_error, "invalid battery mode (must be poll or uevent)");
+    return SYSMON_ERR_PARSE;
+  }
+  const bool want_uevent = mode && strcmp(mode, "uevent") == 0;
+
+  bool ok = true;
+  const uint32_t fallback_ms = sysmon_ini_get_u32(ini, section, "fallback_refresh_ms",
+                                                  SYSMON_BATTERY_DEFAULT_FALLBACK_MS, &ok);
+  if (!ok) {
+    sysmon_set_error(out_error, "invalid fallback_refresh_ms (must be uint32)");
+    return SYSMON_ERR_PARSE;
+  }
+
   battery_state_t *st = (battery_state_t *)calloc(1, sizeof(*st));
   if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
   set_default_status(st);
 
 #if defined(__linux__)
+  sysmon_sys_path(paths, "class/power_supply", st->supply_root, sizeof(st->supply_root));
+  st->uevent_fd = want_uevent ? open_uevent_socket() : -1;
+  st->fallback_ms = fallback_ms;
   char *err = NULL;
-  if (!detect_battery_path(st->base_path, sizeof(st->base_path), &err)) {
-    sysmon_set_error(out_error, err ? err : "battery not detected");
-    free(err);
-    free(st);
-    return SYSMON_ERR_NOT_SUPPORTED;
+  if (!detect_battery_path(st->supply_root, st->base_path, sizeof(st->base_path), &err)) {
+    if (st->uevent_fd < 0) {
+      sysmon_set_error(out_error, err ? err : "battery not detected");
+      free(err);
+      battery_destroy(st);
+      return SYSMON_ERR_NOT_SUPPORTED;
+    }
+    st->base_path[0] = '\0';
   }
   free(err);
+  set_supply_name(st);
+#else
+  (void)paths;
+  (void)want_uevent;
+  (void)fallback_ms;
 #endif
 
 #if defined(__APPLE__)
@@ -131,14 +327,20 @@ static sysmon_result_t battery_create(const sysmon_ini_t *ini, const char *secti
   return SYSMON_OK;
 }
 
-static sysmon_result_t battery_poll(void *state, uint64_t now_ms, bool refresh_now,
+static sysmon_result_t battery_poll(void *state, uint64_t now_ns, bool refresh_now,
                                     sysmon_snapshot_builder_t *builder, char **out_error) {
-  (void)now_ms;
+#if !defined(__APPLE__) && !defined(__linux__)
+  (void)now_ns;
+#endif
   battery_state_t *st = (battery_state_t *)state;
   if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
 
+#if defined(__linux__)
+  if (st->uevent_fd >= 0) return battery_poll_uevent(st, now_ns, builder, out_error);
+#endif
+
 #if defined(__APPLE__) || defined(__linux__)
-  if (refresh_now || !st->has_data) {
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
 #if defined(__APPLE__)
   CFTypeRef info = IOPSCopyPowerSourcesInfo();
   if (!info) {
@@ -191,22 +393,7 @@ static sysmon_result_t battery_poll(void *state, uint64_t now_ms, bool refresh_n
   }
 
 #elif defined(__linux__)
-  char cap_path[320];
-  snprintf(cap_path, sizeof(cap_path), "%s/capacity", st->base_path);
-  uint32_t cap = 0;
-  if (!read_u32_file(cap_path, &cap)) {
-    sysmon_set_error(out_error, "failed to read battery capacity");
-    return SYSMON_ERR_NOT_SUPPORTED;
-  }
-  st->last_percent = (double)cap;
-
-  char status_path[320];
-  snprintf(status_path, sizeof(status_path), "%s/status", st->base_path);
-  char status[32] = "unknown";
-  if (read_string_file(status_path, status, sizeof(status))) {
-    snprintf(st->last_status, sizeof(st->last_status), "%s", status);
-  }
-  st->last_is_charging = (strcasecmp(st->last_status, "Charging") == 0) ? 1 : 0;
+  if (!read_battery_sysfs(st, out_error)) return SYSMON_ERR_NOT_SUPPORTED;
 #else
   (void)out_error;
   return SYSMON_ERR_NOT_SUPPORTED;
@@ -215,19 +402,19 @@ static sysmon_result_t battery_poll(void *state, uint64_t now_ms, bool refresh_n
   st->has_data = true;
   }
 #endif
-  sysmon_result_t rc = sysmon_snapshot_builder_add_double(builder, "battery.percent", "%", st->last_percent);
-  if (rc != SYSMON_OK) return rc;
-  rc = sysmon_snapshot_builder_add_i64(builder, "battery.is_charging", NULL, st->last_is_charging);
-  if (rc != SYSMON_OK) return rc;
-  rc = sysmon_snapshot_builder_add_string(builder, "battery.status", NULL, st->last_status);
-  if (rc != SYSMON_OK) return rc;
-  return SYSMON_OK;
+  return add_battery_metrics(st, builder);
 }
 
-static void battery_destroy(void *state) { free(state); }
-
 const sysmon_module_vtable_t *sysmon_battery_module(void) {
   static const sysmon_module_vtable_t vtable = {
-      .name = "battery", .create = battery_create, .poll = battery_poll, .destroy = battery_destroy};
+      .name = "battery",
+      .create = battery_create,
+      .poll = battery_poll,
+      .destroy = battery_destroy,
+#if defined(__linux__)
+      .event_sources = battery_event_sources,
+      .on_event = battery_on_event,
+#endif
+  };
   return &vtable;
 }
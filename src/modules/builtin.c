@@ -5,18 +5,41 @@ const sysmon_module_vtable_t *sysmon_ram_module(void);
 const sysmon_module_vtable_t *sysmon_battery_module(void);
 const sysmon_module_vtable_t *sysmon_network_module(void);
 const sysmon_module_vtable_t *sysmon_storage_module(void);
+const sysmon_module_vtable_t *sysmon_psi_module(void);
+const sysmon_module_vtable_t *sysmon_process_module(void);
+const sysmon_module_vtable_t *sysmon_cgroup_module(void);
+const sysmon_module_vtable_t *sysmon_disk_module(void);
+const sysmon_module_vtable_t *sysmon_sockets_module(void);
+const sysmon_module_vtable_t *sysmon_perf_module(void);
+const sysmon_module_vtable_t *sysmon_irq_module(void);
+const sysmon_module_vtable_t *sysmon_numa_module(void);
+const sysmon_module_vtable_t *sysmon_vmstat_module(void);
+const sysmon_module_vtable_t *sysmon_schedstat_module(void);
+const sysmon_module_vtable_t *sysmon_thermal_module(void);
+const sysmon_module_vtable_t *sysmon_watch_module(void);
+const sysmon_module_vtable_t *sysmon_kernel_module(void);
+const sysmon_module_vtable_t *sysmon_memdetail_module(void);
+const sysmon_module_vtable_t *sysmon_netstat_module(void);
+const sysmon_module_vtable_t *sysmon_self_module(void);
+
+static const sysmon_module_vtable_t *(*const builtin_getters[])(void) = {
+    sysmon_cpu_module,     sysmon_ram_module, sysmon_battery_module, sysmon_network_module,
+    sysmon_storage_module, sysmon_psi_module, sysmon_process_module, sysmon_cgroup_module,
+    sysmon_disk_module,    sysmon_sockets_module, sysmon_perf_module,    sysmon_irq_module,
+    sysmon_numa_module,    sysmon_vmstat_module,  sysmon_schedstat_module,
+    sysmon_thermal_module, sysmon_watch_module, sysmon_kernel_module, sysmon_memdetail_module,
+    sysmon_netstat_module, sysmon_self_module,
+};
+
+#define SYSMON_BUILTIN_COUNT (sizeof(builtin_getters) / sizeof(builtin_getters[0]))
 
 const sysmon_module_vtable_t *sysmon_builtin_modules(size_t *out_count) {
-  static sysmon_module_vtable_t modules[5];
+  static sysmon_module_vtable_t modules[SYSMON_BUILTIN_COUNT];
   static bool initialized = false;
   if (!initialized) {
-    modules[0] = *sysmon_cpu_module();
-    modules[1] = *sysmon_ram_module();
-    modules[2] = *sysmon_battery_module();
-    modules[3] = *sysmon_network_module();
-    modules[4] = *sysmon_storage_module();
+    for (size_t i = 0; i < SYSMON_BUILTIN_COUNT; i++) modules[i] = *builtin_getters[i]();
     initialized = true;
   }
-  if (out_count) *out_count = 5;
+  if (out_count) *out_count = SYSMON_BUILTIN_COUNT;
   return modules;
 }
@@ -0,0 +1,558 @@
+#include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+enum {
+  CG_CPU_STAT,
+  CG_MEMORY_CURRENT,
+  CG_MEMORY_STAT,
+  CG_IO_STAT,
+  CG_EVENTS,
+  CG_FILE_COUNT,
+};
+
+static const char *const cgroup_file_names[CG_FILE_COUNT] = {
+    "cpu.stat", "memory.current", "memory.stat", "io.stat", "cgroup.events"};
+
+typedef struct cgroup_node {
+  char *path; /* "/" for the root, "/a/b" below it */
+  int wd;
+  int events_wd; /* watch on cgroup.events alone, -1 for the root */
+  unsigned depth;
+  bool reported;
+  bool cached;
+  int dir_fd;
+  int fds[CG_FILE_COUNT];
+  unsigned missing;
+  bool events_dirty;
+  bool populated;
+
+  uint64_t usage_usec;
+  uint64_t user_usec;
+  uint64_t system_usec;
+  uint64_t nr_throttled;
+  uint64_t throttled_usec;
+  uint64_t memory_current;
+  uint64_t memory_anon;
+  uint64_t memory_file;
+  uint64_t memory_slab;
+  uint64_t io_rbytes;
+  uint64_t io_wbytes;
+  uint64_t io_rios;
+  uint64_t io_wios;
+
+  uint64_t prev_usage_usec;
+  uint64_t prev_io_rbytes;
+  uint64_t prev_io_wbytes;
+  uint64_t last_ns;
+  bool has_prev;
+  double cpu_percent;
+  double read_rate;
+  double write_rate;
+} cgroup_node_t;
+
+typedef struct cgroup_state {
+  char root_path[SYSMON_PATH_LEN];
+  int root_fd;
+  int inotify_fd;
+  cgroup_node_t *nodes;
+  size_t count;
+  size_t cap;
+  sysmon_u64map_t by_wd;
+  unsigned max_depth;
+  size_t max_cgroups;
+  size_t open_fds;
+  size_t fd_budget;
+  char *include;
+  char *exclude;
+  bool rebuild;
+  bool has_data;
+} cgroup_state_t;
+
+#if defined(__linux__)
+/* IN_MODIFY on a directory would also report every memory.events / pids.events bump, so
+ * it is only requested on cgroup.events itself. */
+#define CGROUP_WATCH_MASK (IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_ONLYDIR)
+#define CGROUP_FDS_PER_NODE (1 + CG_FILE_COUNT)
+
+static bool path_selected(const cgroup_state_t *st, const char *path) {
+  if (st->include && !sysmon_glob_list_match(st->include, path, FNM_PATHNAME)) return false;
+  return !st->exclude || !sysmon_glob_list_match(st->exclude, path, FNM_PATHNAME);
+}
+
+static void full_path(const cgroup_state_t *st, const char *path, char *out, size_t len) {
+  snprintf(out, len, "%s%s", st->root_path, strcmp(path, "/") == 0 ? "" : path);
+}
+
+static void release_node(cgroup_state_t *st, cgroup_node_t *n) {
+  for (size_t f = 0; f < CG_FILE_COUNT; f++) {
+    if (n->fds[f] >= 0) close(n->fds[f]);
+  }
+  if (n->dir_fd >= 0) close(n->dir_fd);
+  if (n->cached) st->open_fds -= CGROUP_FDS_PER_NODE;
+  free(n->path);
+}
+
+static void remove_node(cgroup_state_t *st, size_t i) {
+  sysmon_u64map_remove(&st->by_wd, (uint64_t)st->nodes[i].wd);
+  if (st->nodes[i].events_wd >= 0)
+    sysmon_u64map_remove(&st->by_wd, (uint64_t)st->nodes[i].events_wd);
+  release_node(st, &st->nodes[i]);
+  if (i + 1 != st->count) {
+    st->nodes[i] = st->nodes[st->count - 1];
+    sysmon_u64map_put(&st->by_wd, (uint64_t)st->nodes[i].wd, (uint32_t)i);
+    if (st->nodes[i].events_wd >= 0)
+      sysmon_u64map_put(&st->by_wd, (uint64_t)st->nodes[i].events_wd, (uint32_t)i);
+  }
+  st->count--;
+}
+
+/* A cached dir fd pins the inode, so rmdir is seen as IN_DELETE on the parent rather than
+ * IN_DELETE_SELF on the cgroup itself. */
+static void remove_path(cgroup_state_t *st, const char *path) {
+  for (size_t i = 0; i < st->count; i++) {
+    if (strcmp(st->nodes[i].path, path) != 0) continue;
+    inotify_rm_watch(st->inotify_fd, st->nodes[i].wd);
+    if (st->nodes[i].events_wd >= 0) inotify_rm_watch(st->inotify_fd, st->nodes[i].events_wd);
+    remove_node(st, i);
+    return;
+  }
+}
+
+static bool add_subtree(cgroup_state_t *st, const char *path, unsigned depth) {
+  if (st->count >= st->max_cgroups) return true;
+  char dir[SYSMON_PATH_LEN];
+  full_path(st, path, dir, sizeof(dir));
+  const int wd = inotify_add_watch(st->inotify_fd, dir, CGROUP_WATCH_MASK);
+  if (wd < 0) return errno == ENOENT; /* raced with rmdir */
+  if (sysmon_u64map_get(&st->by_wd, (uint64_t)wd, NULL)) return true;
+
+  if (st->count == st->cap) {
+    const size_t cap = st->cap ? st->cap * 2 : 64;
+    cgroup_node_t *p = (cgroup_node_t *)realloc(st->nodes, cap * sizeof(*p));
+    if (!p) return false;
+    st->nodes = p;
+    st->cap = cap;
+  }
+  char *copy = sysmon_strdup(path);
+  if (!copy || !sysmon_u64map_put(&st->by_wd, (uint64_t)wd, (uint32_t)st->count)) {
+    free(copy);
+    return false;
+  }
+  cgroup_node_t *n = &st->nodes[st->count++];
+  memset(n, 0, sizeof(*n));
+  n->path = copy;
+  n->wd = wd;
+  n->depth = depth;
+  n->dir_fd = -1;
+  for (size_t f = 0; f < CG_FILE_COUNT; f++) n->fds[f] = -1;
+  char events[SYSMON_PATH_LEN + 16];
+  snprintf(events, sizeof(events), "%s/cgroup.events", dir);
+  n->events_wd = inotify_add_watch(st->inotify_fd, events, IN_MODIFY);
+  if (n->events_wd >= 0 &&
+      !sysmon_u64map_put(&st->by_wd, (uint64_t)n->events_wd, (uint32_t)(st->count - 1)))
+    return false;
+  n->reported = path_selected(st, path);
+  n->events_dirty = true;
+  if (n->reported && st->open_fds + CGROUP_FDS_PER_NODE <= st->fd_budget) {
+    n->dir_fd = open(dir, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    n->cached = n->dir_fd >= 0;
+    if (n->cached) st->open_fds += CGROUP_FDS_PER_NODE;
+  }
+  if (depth >= st->max_depth) return true;
+
+  DIR *d = opendir(dir);
+  if (!d) return true;
+  bool ok = true;
+  char child[SYSMON_PATH_LEN];
+  for (struct dirent *e; ok && (e = readdir(d)) != NULL;) {
+    if (e->d_type != DT_DIR || e->d_name[0] == '.') continue;
+    snprintf(child, sizeof(child), "%s/%s", strcmp(path, "/") == 0 ? "" : path, e->d_name);
+    ok = add_subtree(st, child, depth + 1);
+  }
+  closedir(d);
+  return ok;
+}
+
+static bool build_tree(cgroup_state_t *st) {
+  while (st->count > 0) remove_node(st, st->count - 1);
+  if (st->inotify_fd >= 0) close(st->inotify_fd);
+  st->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  st->rebuild = false;
+  return st->inotify_fd >= 0 && add_subtree(st, "/", 0);
+}
+
+/* Enabling a controller in the parent's cgroup.subtree_control creates its files in every
+ * child, disabling it removes them; either way the node's missing bit follows. */
+static bool apply_file_event(cgroup_node_t *n, const char *name, bool created) {
+  for (size_t f = 0; f < CG_FILE_COUNT; f++) {
+    if (strcmp(name, cgroup_file_names[f]) != 0) continue;
+    if (created) {
+      n->missing &= ~(1u << f);
+    } else {
+      sysmon_close_fd(&n->fds[f]);
+      n->missing |= 1u << f;
+    }
+    return true;
+  }
+  return false;
+}
+
+/* Applies queued hierarchy changes; stat files are never walked to discover them. Sets
+ * *changed when a cgroup appeared, vanished or flipped its cgroup.events state. */
+static bool drain_events(cgroup_state_t *st, bool *changed) {
+  _Alignas(struct inotify_event) char buf[16384];
+  for (;;) {
+    const ssize_t len = read(st->inotify_fd, buf, sizeof(buf));
+    if (len < 0 && errno == EINTR) continue;
+    if (len <= 0) break;
+    for (ssize_t off = 0; off < len;) {
+      const struct inotify_event *ev = (const struct inotify_event *)(buf + off);
+      off += (ssize_t)(sizeof(*ev) + ev->len);
+      if (ev->mask & IN_Q_OVERFLOW) {
+        st->rebuild = true;
+        *changed = true;
+        continue;
+      }
+      uint32_t idx = 0;
+      if (!sysmon_u64map_get(&st->by_wd, (uint64_t)ev->wd, &idx)) continue;
+      if (ev->wd == st->nodes[idx].events_wd) {
+        if (ev->mask & IN_MODIFY) {
+          st->nodes[idx].events_dirty = true;
+          *changed = true;
+        }
+      } else if (ev->mask & (IN_DELETE_SELF | IN_IGNORED)) {
+        remove_node(st, idx);
+        *changed = true;
+      } else if ((ev->mask & (IN_CREATE | IN_DELETE)) && !(ev->mask & IN_ISDIR) && ev->len > 0) {
+        if (apply_file_event(&st->nodes[idx], ev->name, (ev->mask & IN_CREATE) != 0))
+          *changed = true;
+      } else if ((ev->mask & (IN_CREATE | IN_DELETE)) && (ev->mask & IN_ISDIR) && ev->len > 0) {
+        *changed = true;
+        const cgroup_node_t *parent = &st->nodes[idx];
+        if (parent->depth >= st->max_depth) continue;
+        char child[SYSMON_PATH_LEN];
+        snprintf(child, sizeof(child), "%s/%s", strcmp(parent->path, "/") == 0 ? "" : parent->path,
+                 ev->name);
+        if (ev->mask & IN_CREATE) {
+          if (!add_subtree(st, child, parent->depth + 1)) return false;
+        } else {
+          remove_path(st, child);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+static ssize_t read_node_file(const cgroup_state_t *st, cgroup_node_t *n, size_t which, char *buf,
+                              size_t cap) {
+  if (n->missing & (1u << which)) return -1;
+  int fd = n->fds[which];
+  if (fd < 0) {
+    if (n->cached) {
+      fd = openat(n->dir_fd, cgroup_file_names[which], O_RDONLY | O_CLOEXEC);
+    } else {
+      char rel[SYSMON_PATH_LEN];
+      const bool root = strcmp(n->path, "/") == 0;
+      snprintf(rel, sizeof(rel), "%s%s%s", root ? "" : n->path + 1, root ? "" : "/",
+               cgroup_file_names[which]);
+      fd = openat(st->root_fd, rel, O_RDONLY | O_CLOEXEC);
+    }
+    if (fd < 0) {
+      if (errno == ENOENT) n->missing |= 1u << which; /* controller not enabled here */
+      return -1;
+    }
+  }
+  ssize_t len;
+  do {
+    len = pread(fd, buf, cap - SYSMON_PARSE_PADDING - 1, 0);
+  } while (len < 0 && errno == EINTR);
+  if (len >= 0) memset(buf + len, 0, SYSMON_PARSE_PADDING + 1);
+  if (n->cached) n->fds[which] = fd;
+  else close(fd);
+  return len;
+}
+
+static void parse_keyed(const char *p, const char *const *keys, uint64_t *const *outs, size_t n) {
+  for (; *p; p = sysmon_next_line(p)) {
+    for (size_t k = 0; k < n; k++) {
+      const size_t klen = strlen(keys[k]);
+      if (strncmp(p, keys[k], klen) != 0 || p[klen] != ' ') continue;
+      const char *v = p + klen + 1;
+      sysmon_parse_u64(&v, outs[k]);
+      break;
+    }
+  }
+}
+
+/* "8:0 rbytes=1 wbytes=2 rios=3 wios=4 dbytes=0 dios=0", one line per device. */
+static void parse_io_stat(cgroup_node_t *n, const char *p) {
+  n->io_rbytes = n->io_wbytes = n->io_rios = n->io_wios = 0;
+  for (; *p; p = sysmon_next_line(p)) {
+    while (*p && *p != ' ' && *p != '\n') p++;
+    while (*p == ' ') {
+      p++;
+      uint64_t *out = NULL;
+      if (strncmp(p, "rbytes=", 7) == 0) out = &n->io_rbytes, p += 7;
+      else if (strncmp(p, "wbytes=", 7) == 0) out = &n->io_wbytes, p += 7;
+      else if (strncmp(p, "rios=", 5) == 0) out = &n->io_rios, p += 5;
+      else if (strncmp(p, "wios=", 5) == 0) out = &n->io_wios, p += 5;
+      uint64_t v = 0;
+      if (out && sysmon_parse_u64(&p, &v)) *out += v;
+      while (*p && *p != ' ' && *p != '\n') p++;
+    }
+  }
+}
+
+static void sample_node(const cgroup_state_t *st, cgroup_node_t *n, uint64_t now_ns) {
+  char buf[8192];
+  if (read_node_file(st, n, CG_CPU_STAT, buf, sizeof(buf)) > 0) {
+    static const char *const keys[] = {"usage_usec", "user_usec", "system_usec", "nr_throttled",
+                                       "throttled_usec"};
+    uint64_t *const outs[] = {&n->usage_usec, &n->user_usec, &n->system_usec, &n->nr_throttled,
+                              &n->throttled_usec};
+    parse_keyed(buf, keys, outs, 5);
+  }
+  if (read_node_file(st, n, CG_MEMORY_CURRENT, buf, sizeof(buf)) > 0) {
+    const char *p = buf;
+    sysmon_parse_u64(&p, &n->memory_current);
+  }
+  if (read_node_file(st, n, CG_MEMORY_STAT, buf, sizeof(buf)) > 0) {
+    static const char *const keys[] = {"anon", "file", "slab"};
+    uint64_t *const outs[] = {&n->memory_anon, &n->memory_file, &n->memory_slab};
+    parse_keyed(buf, keys, outs, 3);
+  }
+  if (read_node_file(st, n, CG_IO_STAT, buf, sizeof(buf)) >= 0) parse_io_stat(n, buf);
+  if (n->events_dirty && read_node_file(st, n, CG_EVENTS, buf, sizeof(buf)) > 0) {
+    uint64_t populated = 0;
+    static const char *const keys[] = {"populated"};
+    uint64_t *const outs[] = {&populated};
+    parse_keyed(buf, keys, outs, 1);
+    n->populated = populated != 0;
+    n->events_dirty = false;
+  }
+
+  if (n->has_prev && now_ns > n->last_ns) {
+    const double elapsed_s = (double)(now_ns - n->last_ns) / 1e9;
+    const uint64_t cpu = n->usage_usec >= n->prev_usage_usec ? n->usage_usec - n->prev_usage_usec : 0;
+    n->cpu_percent = (double)cpu / (elapsed_s * 1e6) * 100.0;
+    n->read_rate = n->io_rbytes >= n->prev_io_rbytes
+                       ? (double)(n->io_rbytes - n->prev_io_rbytes) / elapsed_s
+                       : 0.0;
+    n->write_rate = n->io_wbytes >= n->prev_io_wbytes
+                        ? (double)(n->io_wbytes - n->prev_io_wbytes) / elapsed_s
+                        : 0.0;
+  }
+  n->prev_usage_usec = n->usage_usec;
+  n->prev_io_rbytes = n->io_rbytes;
+  n->prev_io_wbytes = n->io_wbytes;
+  n->last_ns = now_ns;
+  n->has_prev = true;
+}
+
+static sysmon_result_t add_node_metrics(sysmon_snapshot_builder_t *builder,
+                                        const cgroup_node_t *n) {
+  char name[SYSMON_PATH_LEN + 64];
+#define CG_ADD(kind, metric, unit, value)                                                   \
+  do {                                                                                      \
+    snprintf(name, sizeof(name), "cgroup.%s.%s", n->path, metric);                          \
+    sysmon_result_t rc_ = sysmon_snapshot_builder_add_##kind(builder, name, unit, (value)); \
+    if (rc_ != SYSMON_OK) return rc_;                                                       \
+  } while (0)
+
+  if (!(n->missing & (1u << CG_EVENTS))) CG_ADD(i64, "populated", NULL, n->populated ? 1 : 0);
+  if (!(n->missing & (1u << CG_CPU_STAT))) {
+    CG_ADD(double, "cpu_usage_percent", "%", n->cpu_percent);
+    CG_ADD(u64, "cpu_usage_usec", "us", n->usage_usec);
+    CG_ADD(u64, "cpu_user_usec", "us", n->user_usec);
+    CG_ADD(u64, "cpu_system_usec", "us", n->system_usec);
+    CG_ADD(u64, "cpu_nr_throttled", NULL, n->nr_throttled);
+    CG_ADD(u64, "cpu_throttled_usec", "us", n->throttled_usec);
+  }
+  if (!(n->missing & (1u << CG_MEMORY_CURRENT)))
+    CG_ADD(u64, "memory_current_bytes", "B", n->memory_current);
+  if (!(n->missing & (1u << CG_MEMORY_STAT))) {
+    CG_ADD(u64, "memory_anon_bytes", "B", n->memory_anon);
+    CG_ADD(u64, "memory_file_bytes", "B", n->memory_file);
+    CG_ADD(u64, "memory_slab_bytes", "B", n->memory_slab);
+  }
+  if (!(n->missing & (1u << CG_IO_STAT))) {
+    CG_ADD(u64, "io_read_bytes", "B", n->io_rbytes);
+    CG_ADD(u64, "io_write_bytes", "B", n->io_wbytes);
+    CG_ADD(u64, "io_read_ops", NULL, n->io_rios);
+    CG_ADD(u64, "io_write_ops", NULL, n->io_wios);
+    CG_ADD(double, "io_read_bytes_per_sec", "B/s", n->read_rate);
+    CG_ADD(double, "io_write_bytes_per_sec", "B/s", n->write_rate);
+  }
+#undef CG_ADD
+  return SYSMON_OK;
+}
+
+static size_t cgroup_event_sources(void *state, sysmon_event_source_t *out, size_t max) {
+  cgroup_state_t *st = (cgroup_state_t *)state;
+  if (!st || st->inotify_fd < 0) return 0;
+  if (out && max > 0) {
+    out[0].fd = st->inotify_fd;
+    out[0].events = POLLIN;
+    out[0].revents = 0;
+  }
+  return 1;
+}
+
+static bool cgroup_on_event(void *state, const sysmon_event_source_t *source) {
+  cgroup_state_t *st = (cgroup_state_t *)state;
+  bool changed = false;
+  if (!st || !(source->revents & POLLIN)) return false;
+  if (!drain_events(st, &changed)) st->rebuild = true;
+  return changed || st->rebuild;
+}
+#endif
+
+static void cgroup_destroy(void *state) {
+  cgroup_state_t *st = (cgroup_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  for (size_t i = 0; i < st->count; i++) release_node(st, &st->nodes[i]);
+  if (st->inotify_fd >= 0) close(st->inotify_fd);
+  if (st->root_fd >= 0) close(st->root_fd);
+#endif
+  sysmon_u64map_destroy(&st->by_wd);
+  free(st->nodes);
+  free(st->include);
+  free(st->exclude);
+  free(st);
+}
+
+#if defined(__linux__)
+static char *dup_nonempty(const char *s) { return s && *s ? sysmon_strdup(s) : NULL; }
+#endif
+
+static sysmon_result_t cgroup_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                     const char *section, void **out_state, char **out_error) {
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  bool ok = true;
+  const uint32_t max_depth = sysmon_ini_get_u32(ini, section, "max_depth", 3, &ok);
+  if (!ok) {
+    sysmon_set_error(out_error, "invalid max_depth (must be an integer)");
+    return SYSMON_ERR_PARSE;
+  }
+  const uint32_t max_cgroups = sysmon_ini_get_u32(ini, section, "max_cgroups", 1024, &ok);
+  if (!ok || max_cgroups == 0) {
+    sysmon_set_error(out_error, "invalid max_cgroups (must be > 0)");
+    return SYSMON_ERR_PARSE;
+  }
+  const uint32_t fd_budget = sysmon_ini_get_u32(ini, section, "fd_budget", 4096, &ok);
+  if (!ok) {
+    sysmon_set_error(out_error, "invalid fd_budget (must be an integer)");
+    return SYSMON_ERR_PARSE;
+  }
+
+  cgroup_state_t *st = (cgroup_state_t *)calloc(1, sizeof(*st));
+  if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+  st->root_fd = -1;
+  st->inotify_fd = -1;
+  st->max_depth = max_depth;
+  st->max_cgroups = max_cgroups;
+  st->fd_budget = sysmon_fd_budget(fd_budget);
+  st->include = dup_nonempty(sysmon_ini_get(ini, section, "include"));
+  st->exclude = dup_nonempty(sysmon_ini_get(ini, section, "exclude"));
+  if (!sysmon_u64map_init(&st->by_wd, 256)) {
+    cgroup_destroy(st);
+    return SYSMON_ERR_OUT_OF_MEMORY;
+  }
+
+  /* Unified hierarchy at fs/cgroup, or fs/cgroup/unified on hybrid v1/v2 hosts. */
+  static const char *const candidates[] = {"fs/cgroup", "fs/cgroup/unified"};
+  for (size_t i = 0; i < 2 && st->root_fd < 0; i++) {
+    char probe[SYSMON_PATH_LEN + 32];
+    sysmon_sys_path(paths, candidates[i], st->root_path, sizeof(st->root_path));
+    snprintf(probe, sizeof(probe), "%s/cgroup.controllers", st->root_path);
+    if (access(probe, R_OK) == 0)
+      st->root_fd = open(st->root_path, O_PATH | O_DIRECTORY | O_CLOEXEC);
+  }
+  if (st->root_fd < 0) {
+    sysmon_set_error(out_error, "cgroup v2 hierarchy not found");
+    cgroup_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+  if (!build_tree(st)) {
+    sysmon_set_error(out_error, "failed to watch cgroup hierarchy");
+    cgroup_destroy(st);
+    return SYSMON_ERR_IO;
+  }
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)paths;
+  (void)ini;
+  (void)section;
+  sysmon_set_error(out_error, "cgroup module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static sysmon_result_t cgroup_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                   sysmon_snapshot_builder_t *builder, char **out_error) {
+  cgroup_state_t *st = (cgroup_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+
+#if defined(__linux__)
+  bool changed = false;
+  if (!drain_events(st, &changed)) st->rebuild = true;
+  if (st->rebuild && !build_tree(st)) {
+    sysmon_set_error(out_error, "failed to watch cgroup hierarchy");
+    return SYSMON_ERR_IO;
+  }
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
+    for (size_t i = 0; i < st->count; i++) {
+      if (st->nodes[i].reported) sample_node(st, &st->nodes[i], now_ns);
+    }
+    st->has_data = true;
+  }
+
+  uint64_t reported = 0;
+  for (size_t i = 0; i < st->count; i++) {
+    const cgroup_node_t *n = &st->nodes[i];
+    if (!n->reported || !n->has_prev) continue;
+    sysmon_result_t rc = add_node_metrics(builder, n);
+    if (rc != SYSMON_OK) return rc;
+    reported++;
+  }
+  return sysmon_snapshot_builder_add_u64(builder, "cgroup.count", NULL, reported);
+#else
+  (void)now_ns;
+  (void)refresh_now;
+  sysmon_set_error(out_error, "cgroup module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_cgroup_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "cgroup",
+      .create = cgroup_create,
+      .poll = cgroup_poll,
+      .destroy = cgroup_destroy,
+#if defined(__linux__)
+      .event_sources = cgroup_event_sources,
+      .on_event = cgroup_on_event,
+#endif
+      .opt_in = true,
+  };
+  return &vtable;
+}
@@ -1,7 +1,9 @@
 #include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #if defined(__APPLE__)
 #include <mach/mach.h>
@@ -10,7 +12,71 @@
 #include <unistd.h>
 #endif
 
+#define SYSMON_CPU_DEFAULT_HOT_PERCENT 90u
+
+/* /proc/stat tick columns, in file order. */
+enum {
+  CPU_TICK_USER,
+  CPU_TICK_NICE,
+  CPU_TICK_SYSTEM,
+  CPU_TICK_IDLE,
+  CPU_TICK_IOWAIT,
+  CPU_TICK_IRQ,
+  CPU_TICK_SOFTIRQ,
+  CPU_TICK_STEAL,
+  CPU_TICK_COUNT
+};
+
+/* Derived percentages, one contiguous row per field. */
+enum {
+  CPU_PCT_USAGE,
+  CPU_PCT_USER,
+  CPU_PCT_SYSTEM,
+  CPU_PCT_IOWAIT,
+  CPU_PCT_IRQ,
+  CPU_PCT_SOFTIRQ,
+  CPU_PCT_STEAL,
+  CPU_PCT_COUNT
+};
+
+static const char *const cpu_pct_names[CPU_PCT_COUNT] = {
+    "usage_percent", "user_percent",    "system_percent", "iowait_percent",
+    "irq_percent",   "softirq_percent", "steal_percent",
+};
+
 typedef struct cpu_state {
+#if defined(__linux__)
+  sysmon_file_t stat_file;
+  /* Row 0 is the aggregate "cpu" line, row i + 1 is cpu<i>. Arrays are laid out as
+   * [field][row] with a stride of row_cap so each field is contiguous across cores. */
+  size_t row_cap;
+  size_t row_count;
+  uint64_t *ticks;
+  uint64_t *prev_ticks;
+  double *pct;
+  unsigned char *present;
+  unsigned char *row_valid;
+  unsigned char *pct_valid;
+  bool per_core;
+  uint32_t hot_percent;
+  uint32_t online_count;
+  double core_max_percent;
+  uint64_t core_max_index;
+  uint64_t cores_above;
+  double core_imbalance;
+  /* container mode: usage against the cgroup's cpu.max quota */
+  bool container;
+  sysmon_cgroup_limit_t cg_limit;
+  sysmon_file_t cg_stat;
+  double limit_cores;
+  uint64_t cg_usage_usec;
+  uint64_t cg_periods;
+  uint64_t cg_throttled;
+  uint64_t cg_throttled_usec;
+  uint64_t cg_last_ns;
+  double cg_usage_percent;
+  double cg_throttled_percent;
+#endif
   uint64_t last_total;
   uint64_t last_idle;
   double last_usage_percent;
@@ -32,8 +98,268 @@ static uint32_t detect_core_count(void) {
 #endif
 }
 
-static bool read_cpu_ticks(uint64_t *out_total, uint64_t *out_idle, char **out_error) {
+#if defined(__linux__)
+static bool grow_rows(cpu_state_t *st, size_t rows) {
+  if (rows <= st->row_cap) return true;
+  size_t cap = st->row_cap ? st->row_cap : 16;
+  while (cap < rows) cap *= 2;
+
+  uint64_t *ticks = (uint64_t *)calloc(cap * CPU_TICK_COUNT, sizeof(*ticks));
+  uint64_t *prev = (uint64_t *)calloc(cap * CPU_TICK_COUNT, sizeof(*prev));
+  double *pct = (double *)calloc(cap * CPU_PCT_COUNT, sizeof(*pct));
+  unsigned char *present = (unsigned char *)calloc(cap, 1);
+  unsigned char *row_valid = (unsigned char *)calloc(cap, 1);
+  unsigned char *pct_valid = (unsigned char *)calloc(cap, 1);
+  if (!ticks || !prev || !pct || !present || !row_valid || !pct_valid) {
+    free(ticks);
+    free(prev);
+    free(pct);
+    free(present);
+    free(row_valid);
+    free(pct_valid);
+    return false;
+  }
+  for (size_t f = 0; f < CPU_TICK_COUNT && st->row_cap; f++) {
+    memcpy(ticks + f * cap, st->ticks + f * st->row_cap, st->row_cap * sizeof(*ticks));
+    memcpy(prev + f * cap, st->prev_ticks + f * st->row_cap, st->row_cap * sizeof(*prev));
+  }
+  if (st->row_cap) {
+    memcpy(present, st->present, st->row_cap);
+    memcpy(row_valid, st->row_valid, st->row_cap);
+    memcpy(pct_valid, st->pct_valid, st->row_cap);
+  }
+  free(st->ticks);
+  free(st->prev_ticks);
+  free(st->pct);
+  free(st->present);
+  free(st->row_valid);
+  free(st->pct_valid);
+  st->ticks = ticks;
+  st->prev_ticks = prev;
+  st->pct = pct;
+  st->present = present;
+  st->row_valid = row_valid;
+  st->pct_valid = pct_valid;
+  st->row_cap = cap;
+  return true;
+}
+
+/* Parses the leading "cpu"/"cpuN" lines of /proc/stat into the tick arrays and stops at
+ * the first other line, so the large intr/softirq lines are never scanned. */
+static bool parse_proc_stat(cpu_state_t *st, char **out_error) {
+  if (!sysmon_file_read(&st->stat_file)) {
+    sysmon_set_path_error(out_error, "failed to read", st->stat_file.path);
+    return false;
+  }
+  memset(st->present, 0, st->row_cap);
+  st->online_count = 0;
+
+  const char *p = st->stat_file.buf;
+  while (p[0] == 'c' && p[1] == 'p' && p[2] == 'u') {
+    p += 3;
+    size_t row = 0;
+    if (*p != ' ') {
+      uint64_t id = 0;
+      if (!sysmon_parse_u64(&p, &id) || id > (1u << 20)) break;
+      row = (size_t)id + 1;
+      if (!grow_rows(st, row + 1)) {
+        sysmon_set_error(out_error, "out of memory while growing cpu arrays");
+        return false;
+      }
+      st->online_count++;
+    }
+
+    uint64_t v[CPU_TICK_COUNT] = {0};
+    int n = 0;
+    while (n < CPU_TICK_COUNT && sysmon_parse_u64(&p, &v[n])) n++;
+    if (n >= 4) {
+      for (int f = 0; f < CPU_TICK_COUNT; f++) st->ticks[(size_t)f * st->row_cap + row] = v[f];
+      st->present[row] = 1;
+      if (row + 1 > st->row_count) st->row_count = row + 1;
+    }
+    p = sysmon_next_line(p);
+  }
+
+  if (!st->present[0]) {
+    sysmon_set_path_error(out_error, "unexpected format in", st->stat_file.path);
+    return false;
+  }
+  return true;
+}
+
+static inline double tick_delta(uint64_t cur, uint64_t prev) {
+  return (double)(cur > prev ? cur - prev : 0);
+}
+
+/* One branch-free pass over all rows: tick deltas to percentages. iowait can go backwards
+ * (see proc(5)), so every field delta is clamped at 0. Rows without a previous sample or
+ * without any elapsed tick are flagged in pct_valid and masked out afterwards. */
+static void compute_percentages(cpu_state_t *st) {
+  const size_t rows = st->row_count, stride = st->row_cap;
+  const uint64_t *cur = st->ticks, *prev = st->prev_ticks;
+  double *pct = st->pct;
+
+#define CPU_DELTA(field) tick_delta(cur[(field) * stride + r], prev[(field) * stride + r])
+  for (size_t r = 0; r < rows; r++) {
+    const double user = CPU_DELTA(CPU_TICK_USER) + CPU_DELTA(CPU_TICK_NICE);
+    const double system = CPU_DELTA(CPU_TICK_SYSTEM);
+    const double idle = CPU_DELTA(CPU_TICK_IDLE);
+    const double iowait = CPU_DELTA(CPU_TICK_IOWAIT);
+    const double irq = CPU_DELTA(CPU_TICK_IRQ);
+    const double softirq = CPU_DELTA(CPU_TICK_SOFTIRQ);
+    const double steal = CPU_DELTA(CPU_TICK_STEAL);
+    const double total = user + system + idle + iowait + irq + softirq + steal;
+    const double scale = total > 0.0 ? 100.0 / total : 0.0;
+    st->pct_valid[r] = (unsigned char)(st->present[r] & st->row_valid[r] & (total > 0.0));
+
+    pct[CPU_PCT_USAGE * stride + r] = (total - idle - iowait) * scale;
+    pct[CPU_PCT_USER * stride + r] = user * scale;
+    pct[CPU_PCT_SYSTEM * stride + r] = system * scale;
+    pct[CPU_PCT_IOWAIT * stride + r] = iowait * scale;
+    pct[CPU_PCT_IRQ * stride + r] = irq * scale;
+    pct[CPU_PCT_SOFTIRQ * stride + r] = softirq * scale;
+    pct[CPU_PCT_STEAL * stride + r] = steal * scale;
+  }
+#undef CPU_DELTA
+}
+
+static void compute_summaries(cpu_state_t *st) {
+  const double *usage = st->pct + CPU_PCT_USAGE * st->row_cap;
+  double max = 0.0, sum = 0.0;
+  uint64_t max_index = 0, above = 0, n = 0;
+  for (size_t r = 1; r < st->row_count; r++) {
+    if (!st->pct_valid[r]) continue;
+    const double u = usage[r];
+    if (n == 0 || u > max) {
+      max = u;
+      max_index = (uint64_t)(r - 1);
+    }
+    if (u >= (double)st->hot_percent) above++;
+    sum += u;
+    n++;
+  }
+  st->core_max_percent = max;
+  st->core_max_index = max_index;
+  st->cores_above = above;
+  st->core_imbalance = n > 0 ? max - sum / (double)n : 0.0;
+}
+
+static bool sample_cpu_linux(cpu_state_t *st, char **out_error) {
+  if (!parse_proc_stat(st, out_error)) return false;
+  compute_percentages(st);
+  for (size_t r = 0; r < st->row_count; r++) {
+    if (st->pct_valid[r]) continue;
+    for (size_t f = 0; f < CPU_PCT_COUNT; f++) st->pct[f * st->row_cap + r] = 0.0;
+  }
+  compute_summaries(st);
+
+  if (st->pct_valid[0]) st->last_usage_percent = st->pct[CPU_PCT_USAGE * st->row_cap];
+  memcpy(st->prev_ticks, st->ticks, st->row_cap * CPU_TICK_COUNT * sizeof(*st->ticks));
+  for (size_t r = 0; r < st->row_count; r++) st->row_valid[r] = st->present[r];
+  if (st->online_count > 0) st->core_count = st->online_count;
+  return true;
+}
+
+/* "50000 100000" -> 0.5 cores; "max 100000" sets no limit. */
+static double parse_cpu_max(const char *text) {
+  uint64_t quota = 0, period = 0;
+  if (!sysmon_parse_u64(&text, &quota) || !sysmon_parse_u64(&text, &period) || period == 0)
+    return -1.0;
+  return (double)quota / (double)period;
+}
+
+static bool sample_cgroup(cpu_state_t *st, uint64_t now_ns, char **out_error) {
+  if (sysmon_cgroup_limit_changed(&st->cg_limit)) {
+    double cores = 0.0;
+    const double online = (double)(st->core_count ? st->core_count : 1);
+    st->limit_cores = sysmon_cgroup_limit_read(&st->cg_limit, parse_cpu_max, &cores) &&
+                              cores < online
+                          ? cores
+                          : online;
+  }
+  if (!sysmon_file_read(&st->cg_stat)) {
+    sysmon_set_error(out_error, "failed to read cgroup cpu.stat");
+    return false;
+  }
+  uint64_t usage = 0, periods = 0, throttled = 0, throttled_usec = 0;
+  for (const char *p = st->cg_stat.buf; *p; p = sysmon_next_line(p)) {
+    const char *v = strchr(p, ' ');
+    if (!v) break;
+    uint64_t *dst = NULL;
+    if (strncmp(p, "usage_usec ", 11) == 0) dst = &usage;
+    else if (strncmp(p, "nr_periods ", 11) == 0) dst = &periods;
+    else if (strncmp(p, "nr_throttled ", 13) == 0) dst = &throttled;
+    else if (strncmp(p, "throttled_usec ", 15) == 0) dst = &throttled_usec;
+    if (dst) sysmon_parse_u64(&v, dst);
+  }
+  if (st->cg_last_ns && now_ns > st->cg_last_ns && usage >= st->cg_usage_usec) {
+    const double elapsed_usec = (double)(now_ns - st->cg_last_ns) / 1000.0;
+    st->cg_usage_percent =
+        (double)(usage - st->cg_usage_usec) * 100.0 / (elapsed_usec * st->limit_cores);
+    st->cg_throttled_percent =
+        periods > st->cg_periods && throttled >= st->cg_throttled
+            ? (double)(throttled - st->cg_throttled) * 100.0 / (double)(periods - st->cg_periods)
+            : 0.0;
+  }
+  st->cg_usage_usec = usage;
+  st->cg_periods = periods;
+  st->cg_throttled = throttled;
+  st->cg_throttled_usec = throttled_usec;
+  st->cg_last_ns = now_ns;
+  st->last_usage_percent = st->cg_usage_percent;
+  return true;
+}
+
+static sysmon_result_t add_linux_metrics(const cpu_state_t *st, sysmon_snapshot_builder_t *builder) {
+  sysmon_result_t rc = SYSMON_OK;
+  char name[96];
+  for (size_t f = CPU_PCT_USER; f < CPU_PCT_COUNT && st->pct_valid[0] && rc == SYSMON_OK; f++) {
+    snprintf(name, sizeof(name), "cpu.%s", cpu_pct_names[f]);
+    rc = sysmon_snapshot_builder_add_double(builder, name, "%", st->pct[f * st->row_cap]);
+  }
+  if (rc != SYSMON_OK) return rc;
+
+  rc = sysmon_snapshot_builder_add_double(builder, "cpu.core_max_percent", "%", st->core_max_percent);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_u64(builder, "cpu.core_max_index", NULL, st->core_max_index);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_u64(builder, "cpu.cores_above_threshold", NULL, st->cores_above);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "cpu.core_imbalance_percent", "%",
+                                          st->core_imbalance);
+  if (rc != SYSMON_OK) return rc;
+
+  if (st->container) {
+    /* Host usage comes from this refresh's /proc/stat delta only; none yet, no metric. */
+    if (st->pct_valid[0]) {
+      rc = sysmon_snapshot_builder_add_double(builder, "cpu.host_usage_percent", "%",
+                                              st->pct[CPU_PCT_USAGE * st->row_cap]);
+      if (rc != SYSMON_OK) return rc;
+    }
+    rc = sysmon_snapshot_builder_add_double(builder, "cpu.limit_cores", NULL, st->limit_cores);
+    if (rc != SYSMON_OK) return rc;
+    rc = sysmon_snapshot_builder_add_double(builder, "cpu.throttled_percent", "%",
+                                            st->cg_throttled_percent);
+    if (rc != SYSMON_OK) return rc;
+    rc = sysmon_snapshot_builder_add_u64(builder, "cpu.throttled_usec", "us", st->cg_throttled_usec);
+    if (rc != SYSMON_OK) return rc;
+  }
+
+  if (!st->per_core) return SYSMON_OK;
+  for (size_t r = 1; r < st->row_count; r++) {
+    if (!st->pct_valid[r]) continue;
+    for (size_t f = 0; f < CPU_PCT_COUNT; f++) {
+      snprintf(name, sizeof(name), "cpu.core.%zu.%s", r - 1, cpu_pct_names[f]);
+      rc = sysmon_snapshot_builder_add_double(builder, name, "%", st->pct[f * st->row_cap + r]);
+      if (rc != SYSMON_OK) return rc;
+    }
+  }
+  return SYSMON_OK;
+}
+#endif
+
 #if defined(__APPLE__)
+static bool read_cpu_ticks(uint64_t *out_total, uint64_t *out_idle, char **out_error) {
   host_cpu_load_info_data_t load = {0};
   mach_msg_type_number_t count = HOST_CPU_LOAD_INFO_COUNT;
   kern_return_t kr =
@@ -49,84 +375,121 @@ static bool read_cpu_ticks(uint64_t *out_total, uint64_t *out_idle, char **out_e
   *out_idle = idle;
   *out_total = user + sys + idle + nice;
   return true;
-#elif defined(__linux__)
-  FILE *f = fopen("/proc/stat", "r");
-  if (!f) {
-    sysmon_set_error(out_error, "failed to open /proc/stat");
-    return false;
-  }
-  char buf[512];
-  if (!fgets(buf, (int)sizeof(buf), f)) {
-    fclose(f);
-    sysmon_set_error(out_error, "failed to read /proc/stat");
-    return false;
-  }
-  fclose(f);
+}
 
-  unsigned long long user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0,
-                     steal = 0;
-  int scanned = sscanf(buf, "cpu %llu %llu %llu %llu %llu %llu %llu %llu", &user, &nice, &system,
-                       &idle, &iowait, &irq, &softirq, &steal);
-  if (scanned < 4) {
-    sysmon_set_error(out_error, "unexpected /proc/stat format");
-    return false;
+static bool sample_cpu_apple(cpu_state_t *st, char **out_error) {
+  uint64_t total = 0, idle = 0;
+  if (!read_cpu_ticks(&total, &idle, out_error)) return false;
+  if (st->has_prev) {
+    const uint64_t total_delta = total - st->last_total;
+    const uint64_t idle_delta = idle - st->last_idle;
+    if (total_delta > 0 && idle_delta <= total_delta) {
+      st->last_usage_percent = (double)(total_delta - idle_delta) * 100.0 / (double)total_delta;
+    }
   }
-  const uint64_t idle_all = (uint64_t)idle + (uint64_t)iowait;
-  const uint64_t total = (uint64_t)user + (uint64_t)nice + (uint64_t)system + (uint64_t)idle +
-                         (uint64_t)iowait + (uint64_t)irq + (uint64_t)softirq + (uint64_t)steal;
-  *out_idle = idle_all;
-  *out_total = total;
+  st->last_total = total;
+  st->last_idle = idle;
   return true;
-#else
-  (void)out_total;
-  (void)out_idle;
-  sysmon_set_error(out_error, "cpu module not supported on this platform");
-  return false;
+}
+#endif
+
+static void cpu_destroy(void *state) {
+  cpu_state_t *st = (cpu_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  sysmon_file_close(&st->stat_file);
+  sysmon_file_close(&st->cg_stat);
+  if (st->container) sysmon_cgroup_limit_close(&st->cg_limit);
+  free(st->ticks);
+  free(st->prev_ticks);
+  free(st->pct);
+  free(st->present);
+  free(st->row_valid);
+  free(st->pct_valid);
 #endif
+  free(st);
 }
 
-static sysmon_result_t cpu_create(const sysmon_ini_t *ini, const char *section, void **out_state,
-                                  char **out_error) {
-  (void)ini;
-  (void)section;
+static sysmon_result_t cpu_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                  const char *section, void **out_state, char **out_error) {
   if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
 
   cpu_state_t *st = (cpu_state_t *)calloc(1, sizeof(*st));
   if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
   st->core_count = detect_core_count();
   st->last_usage_percent = 0.0;
-  *out_state = st;
+
+#if defined(__linux__)
+  bool ok = true;
+  st->per_core = sysmon_ini_get_bool(ini, section, "per_core", false);
+  st->hot_percent =
+      sysmon_ini_get_u32(ini, section, "hot_core_percent", SYSMON_CPU_DEFAULT_HOT_PERCENT, &ok);
+  if (!ok || st->hot_percent > 100) {
+    sysmon_set_error(out_error, "invalid hot_core_percent (must be 0..100)");
+    cpu_destroy(st);
+    return SYSMON_ERR_PARSE;
+  }
+
+  char stat_path[SYSMON_PATH_LEN];
+  sysmon_proc_path(paths, "stat", stat_path, sizeof(stat_path));
+  sysmon_file_init(&st->stat_file);
+  sysmon_file_init(&st->cg_stat);
+  if (!sysmon_file_open(&st->stat_file, stat_path)) {
+    sysmon_set_path_error(out_error, "failed to open", stat_path);
+    cpu_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+  if (sysmon_ini_get_bool(ini, section, "container", false)) {
+    st->container = true;
+    char path[SYSMON_PATH_LEN + 16] = "";
+    if (sysmon_cgroup_limit_open(&st->cg_limit, paths, "cpu.max"))
+      snprintf(path, sizeof(path), "%s/cpu.stat", st->cg_limit.dir);
+    if (st->cg_limit.inotify_fd < 0 || !sysmon_file_open(&st->cg_stat, path)) {
+      sysmon_set_error(out_error, "container mode needs the cgroup v2 cpu.stat of this process");
+      cpu_destroy(st);
+      return SYSMON_ERR_NOT_SUPPORTED;
+    }
+  }
+  const long conf = sysconf(_SC_NPROCESSORS_CONF);
+  if (!grow_rows(st, conf > 0 ? (size_t)conf + 1 : 1)) {
+    cpu_destroy(st);
+    return SYSMON_ERR_OUT_OF_MEMORY;
+  }
+#else
+  (void)paths;
+  (void)ini;
+  (void)section;
   (void)out_error;
+#endif
+  *out_state = st;
   return SYSMON_OK;
 }
 
-static sysmon_result_t cpu_poll(void *state, uint64_t now_ms, bool refresh_now,
+static sysmon_result_t cpu_poll(void *state, uint64_t now_ns, bool refresh_now,
                                 sysmon_snapshot_builder_t *builder, char **out_error) {
-  (void)now_ms;
   cpu_state_t *st = (cpu_state_t *)state;
   if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
 
-  if (refresh_now || !st->has_prev) {
-    uint64_t total = 0, idle = 0;
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_prev)) {
     char *err = NULL;
-    if (!read_cpu_ticks(&total, &idle, &err)) {
+#if defined(__linux__)
+    const bool ok =
+        sample_cpu_linux(st, &err) && (!st->container || sample_cgroup(st, now_ns, &err));
+#elif defined(__APPLE__)
+    (void)now_ns;
+    const bool ok = sample_cpu_apple(st, &err);
+#else
+    (void)now_ns;
+    const bool ok = false;
+    sysmon_set_error(&err, "cpu module not supported on this platform");
+#endif
+    if (!ok) {
       sysmon_set_error(out_error, err ? err : "failed to read cpu ticks");
       free(err);
       return SYSMON_ERR_NOT_SUPPORTED;
     }
     free(err);
-
-    if (st->has_prev) {
-      const uint64_t total_delta = total - st->last_total;
-      const uint64_t idle_delta = idle - st->last_idle;
-      if (total_delta > 0 && idle_delta <= total_delta) {
-        st->last_usage_percent = (double)(total_delta - idle_delta) * 100.0 / (double)total_delta;
-      }
-    } else {
-      st->has_prev = true;
-    }
-    st->last_total = total;
-    st->last_idle = idle;
+    st->has_prev = true;
   }
 
   sysmon_result_t rc =
@@ -136,11 +499,13 @@ static sysmon_result_t cpu_poll(void *state, uint64_t now_ms, bool refresh_now,
     rc = sysmon_snapshot_builder_add_u64(builder, "cpu.core_count", NULL, st->core_count);
     if (rc != SYSMON_OK) return rc;
   }
+#if defined(__linux__)
+  rc = add_linux_metrics(st, builder);
+  if (rc != SYSMON_OK) return rc;
+#endif
   return SYSMON_OK;
 }
 
-static void cpu_destroy(void *state) { free(state); }
-
 const sysmon_module_vtable_t *sysmon_cpu_module(void) {
   static const sysmon_module_vtable_t vtable = {
       .name = "cpu", .create = cpu_create, .poll = cpu_poll, .destroy = cpu_destroy};
@@ -0,0 +1,298 @@
+#include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#define DISK_NAME_LEN 32
+#define DISK_SECTOR_BYTES 512u
+
+/* Leading /proc/diskstats columns after the device name (kernel iostats.rst order). */
+enum {
+  DISK_READS,
+  DISK_READS_MERGED,
+  DISK_READ_SECTORS,
+  DISK_READ_MS,
+  DISK_WRITES,
+  DISK_WRITES_MERGED,
+  DISK_WRITE_SECTORS,
+  DISK_WRITE_MS,
+  DISK_IN_FLIGHT,
+  DISK_IO_MS,
+  DISK_FIELDS,
+};
+
+typedef struct disk_device {
+  uint64_t key;
+  char name[DISK_NAME_LEN];
+  bool included;
+  bool has_prev;
+  uint32_t seen_gen;
+  uint64_t cur[DISK_FIELDS];
+  uint64_t prev[DISK_FIELDS];
+  double read_iops;
+  double write_iops;
+  double read_bytes_per_sec;
+  double write_bytes_per_sec;
+  double read_await_ms;
+  double write_await_ms;
+  double await_ms;
+  double util_percent;
+} disk_device_t;
+
+typedef struct disk_state {
+  sysmon_paths_t paths;
+  sysmon_file_t file;
+  disk_device_t *devices;
+  size_t count;
+  size_t cap;
+  sysmon_u64map_t by_dev;
+  uint32_t gen;
+  char *include;
+  char *exclude;
+  bool partitions;
+  uint64_t last_ns;
+  bool has_data;
+} disk_state_t;
+
+#if defined(__linux__)
+static bool is_partition(const disk_state_t *st, const char *name) {
+  char sysfs_name[DISK_NAME_LEN], rel[SYSMON_PATH_LEN], path[SYSMON_PATH_LEN];
+  size_t i = 0;
+  for (; name[i] && i + 1 < sizeof(sysfs_name); i++) {
+    sysfs_name[i] = name[i] == '/' ? '!' : name[i]; /* cciss/c0d0 -> cciss!c0d0 */
+  }
+  sysfs_name[i] = '\0';
+  snprintf(rel, sizeof(rel), "class/block/%s/partition", sysfs_name);
+  sysmon_sys_path(&st->paths, rel, path, sizeof(path));
+  return access(path, F_OK) == 0;
+}
+
+static bool device_included(const disk_state_t *st, const char *name) {
+  if (st->include && !sysmon_glob_list_match(st->include, name, 0)) return false;
+  if (st->exclude && sysmon_glob_list_match(st->exclude, name, 0)) return false;
+  return st->partitions || !is_partition(st, name);
+}
+
+static disk_device_t *lookup_device(disk_state_t *st, uint64_t key, const char *name,
+                                    size_t name_len) {
+  uint32_t idx = 0;
+  if (sysmon_u64map_get(&st->by_dev, key, &idx)) return &st->devices[idx];
+  if (st->count == st->cap) {
+    const size_t cap = st->cap ? st->cap * 2 : 32;
+    disk_device_t *p = (disk_device_t *)realloc(st->devices, cap * sizeof(*p));
+    if (!p) return NULL;
+    st->devices = p;
+    st->cap = cap;
+  }
+  if (!sysmon_u64map_put(&st->by_dev, key, (uint32_t)st->count)) return NULL;
+  disk_device_t *d = &st->devices[st->count++];
+  memset(d, 0, sizeof(*d));
+  d->key = key;
+  if (name_len >= sizeof(d->name)) name_len = sizeof(d->name) - 1;
+  memcpy(d->name, name, name_len);
+  d->name[name_len] = '\0';
+  /* Filters (and the sysfs partition probe) run once per major:minor, not per refresh. */
+  d->included = device_included(st, d->name);
+  return d;
+}
+
+static void compute_rates(disk_device_t *d, double elapsed_s) {
+#define DISK_DELTA(f) (d->cur[f] >= d->prev[f] ? d->cur[f] - d->prev[f] : 0)
+  const uint64_t reads = DISK_DELTA(DISK_READS), writes = DISK_DELTA(DISK_WRITES);
+  const uint64_t read_ms = DISK_DELTA(DISK_READ_MS), write_ms = DISK_DELTA(DISK_WRITE_MS);
+  d->read_iops = (double)reads / elapsed_s;
+  d->write_iops = (double)writes / elapsed_s;
+  d->read_bytes_per_sec = (double)DISK_DELTA(DISK_READ_SECTORS) * DISK_SECTOR_BYTES / elapsed_s;
+  d->write_bytes_per_sec = (double)DISK_DELTA(DISK_WRITE_SECTORS) * DISK_SECTOR_BYTES / elapsed_s;
+  d->read_await_ms = reads ? (double)read_ms / (double)reads : 0.0;
+  d->write_await_ms = writes ? (double)write_ms / (double)writes : 0.0;
+  d->await_ms = reads + writes ? (double)(read_ms + write_ms) / (double)(reads + writes) : 0.0;
+  d->util_percent = (double)DISK_DELTA(DISK_IO_MS) / (elapsed_s * 10.0);
+  if (d->util_percent > 100.0) d->util_percent = 100.0;
+#undef DISK_DELTA
+}
+
+/* "   8       0 sda 1234 0 5678 ..." */
+static bool refresh(disk_state_t *st, uint64_t now_ns, char **out_error) {
+  if (!sysmon_file_read(&st->file)) {
+    sysmon_set_error(out_error, "failed to read diskstats");
+    return false;
+  }
+  const double elapsed_s =
+      st->has_data && now_ns > st->last_ns ? (double)(now_ns - st->last_ns) / 1e9 : 0.0;
+  st->gen++;
+  for (const char *p = st->file.buf; *p; p = sysmon_next_line(p)) {
+    uint64_t major = 0, minor = 0;
+    p = sysmon_skip_blanks(p);
+    if (!sysmon_parse_u64(&p, &major)) continue;
+    p = sysmon_skip_blanks(p);
+    if (!sysmon_parse_u64(&p, &minor)) continue;
+    p = sysmon_skip_blanks(p);
+    const char *name = p;
+    while (*p && *p != ' ' && *p != '\n') p++;
+
+    disk_device_t *d = lookup_device(st, major << 32 | minor, name, (size_t)(p - name));
+    if (!d) {
+      sysmon_set_error(out_error, "out of memory tracking disks");
+      return false;
+    }
+    d->seen_gen = st->gen;
+    if (!d->included) continue;
+
+    for (size_t f = 0; f < DISK_FIELDS; f++) {
+      p = sysmon_skip_blanks(p);
+      if (!sysmon_parse_u64(&p, &d->cur[f])) d->cur[f] = 0;
+    }
+    if (d->has_prev && elapsed_s > 0.0) compute_rates(d, elapsed_s);
+    memcpy(d->prev, d->cur, sizeof(d->prev));
+    d->has_prev = true;
+  }
+
+  for (size_t i = 0; i < st->count;) {
+    if (st->devices[i].seen_gen == st->gen) {
+      i++;
+      continue;
+    }
+    sysmon_u64map_remove(&st->by_dev, st->devices[i].key);
+    if (i + 1 != st->count) {
+      st->devices[i] = st->devices[st->count - 1];
+      sysmon_u64map_put(&st->by_dev, st->devices[i].key, (uint32_t)i);
+    }
+    st->count--;
+  }
+  st->last_ns = now_ns;
+  st->has_data = true;
+  return true;
+}
+
+static sysmon_result_t add_device_metrics(sysmon_snapshot_builder_t *builder,
+                                          const disk_device_t *d) {
+  char name[96];
+#define DISK_ADD(kind, metric, unit, value)                                                  \
+  do {                                                                                       \
+    snprintf(name, sizeof(name), "disk.%s.%s", d->name, metric);                             \
+    sysmon_result_t rc_ = sysmon_snapshot_builder_add_##kind(builder, name, unit, (value)); \
+    if (rc_ != SYSMON_OK) return rc_;                                                        \
+  } while (0)
+
+  DISK_ADD(double, "read_iops", "ops/s", d->read_iops);
+  DISK_ADD(double, "write_iops", "ops/s", d->write_iops);
+  DISK_ADD(double, "read_bytes_per_sec", "B/s", d->read_bytes_per_sec);
+  DISK_ADD(double, "write_bytes_per_sec", "B/s", d->write_bytes_per_sec);
+  DISK_ADD(double, "read_await_ms", "ms", d->read_await_ms);
+  DISK_ADD(double, "write_await_ms", "ms", d->write_await_ms);
+  DISK_ADD(double, "await_ms", "ms", d->await_ms);
+  DISK_ADD(double, "util_percent", "%", d->util_percent);
+  DISK_ADD(u64, "in_flight", NULL, d->cur[DISK_IN_FLIGHT]);
+#undef DISK_ADD
+  return SYSMON_OK;
+}
+#endif
+
+static void disk_destroy(void *state) {
+  disk_state_t *st = (disk_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  sysmon_file_close(&st->file);
+#endif
+  sysmon_u64map_destroy(&st->by_dev);
+  free(st->devices);
+  free(st->include);
+  free(st->exclude);
+  free(st);
+}
+
+static sysmon_result_t disk_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                   const char *section, void **out_state, char **out_error) {
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  disk_state_t *st = (disk_state_t *)calloc(1, sizeof(*st));
+  if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+  st->paths = *paths;
+  sysmon_file_init(&st->file);
+
+  const char *include = sysmon_ini_get(ini, section, "include");
+  const char *exclude = sysmon_ini_get(ini, section, "exclude");
+  if (!exclude) exclude = "loop*,ram*";
+  st->include = include && *include ? sysmon_strdup(include) : NULL;
+  st->exclude = *exclude ? sysmon_strdup(exclude) : NULL;
+  st->partitions = sysmon_ini_get_bool(ini, section, "partitions", false);
+  if ((include && *include && !st->include) || (*exclude && !st->exclude) ||
+      !sysmon_u64map_init(&st->by_dev, 64)) {
+    disk_destroy(st);
+    return SYSMON_ERR_OUT_OF_MEMORY;
+  }
+
+  char path[SYSMON_PATH_LEN];
+  sysmon_proc_path(paths, "diskstats", path, sizeof(path));
+  if (!sysmon_file_open(&st->file, path)) {
+    sysmon_set_error(out_error, "failed to open diskstats");
+    disk_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)paths;
+  (void)ini;
+  (void)section;
+  sysmon_set_error(out_error, "disk module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static sysmon_result_t disk_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                 sysmon_snapshot_builder_t *builder, char **out_error) {
+  disk_state_t *st = (disk_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+
+#if defined(__linux__)
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data) &&
+      !refresh(st, now_ns, out_error))
+    return SYSMON_ERR_IO;
+
+  uint64_t devices = 0;
+  double read_iops = 0.0, write_iops = 0.0, read_bps = 0.0, write_bps = 0.0;
+  for (size_t i = 0; i < st->count; i++) {
+    const disk_device_t *d = &st->devices[i];
+    if (!d->included) continue;
+    sysmon_result_t rc = add_device_metrics(builder, d);
+    if (rc != SYSMON_OK) return rc;
+    devices++;
+    read_iops += d->read_iops;
+    write_iops += d->write_iops;
+    read_bps += d->read_bytes_per_sec;
+    write_bps += d->write_bytes_per_sec;
+  }
+  sysmon_result_t rc = sysmon_snapshot_builder_add_u64(builder, "disk.device_count", NULL, devices);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "disk.read_iops", "ops/s", read_iops);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "disk.write_iops", "ops/s", write_iops);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "disk.read_bytes_per_sec", "B/s", read_bps);
+  if (rc != SYSMON_OK) return rc;
+  return sysmon_snapshot_builder_add_double(builder, "disk.write_bytes_per_sec", "B/s", write_bps);
+#else
+  (void)now_ns;
+  (void)refresh_now;
+  sysmon_set_error(out_error, "disk module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_disk_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "disk",
+      .create = disk_create,
+      .poll = disk_poll,
+      .destroy = disk_destroy,
+  };
+  return &vtable;
+}
@@ -0,0 +1,359 @@
+#include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IRQ_LABEL_LEN 16
+#define IRQ_NAME_LEN 48
+
+typedef struct irq_row {
+  char label[IRQ_LABEL_LEN];
+  char name[IRQ_NAME_LEN];
+} irq_row_t;
+
+/* One /proc/interrupts-style matrix: rows x CPU columns of monotonic counters. */
+typedef struct irq_table {
+  sysmon_file_t file;
+  irq_row_t *rows;
+  size_t row_count;
+  size_t row_cap;
+  int *cpu_ids;
+  size_t cpu_count;
+  size_t cpu_cap;
+  uint64_t *cur; /* [row][cpu] */
+  uint64_t *prev;
+  double *rate; /* [row][cpu], events per second */
+  bool has_prev;
+} irq_table_t;
+
+typedef struct irq_state {
+  irq_table_t hard;
+  irq_table_t soft;
+  bool has_soft;
+  bool per_cpu;
+  sysmon_topk_t top;
+  double total_rate;
+  uint64_t last_ts_ns;
+  bool has_data;
+} irq_state_t;
+
+#if defined(__linux__)
+static void table_free(irq_table_t *t) {
+  sysmon_file_close(&t->file);
+  free(t->rows);
+  free(t->cpu_ids);
+  free(t->cur);
+  free(t->prev);
+  free(t->rate);
+}
+
+static bool table_reserve(irq_table_t *t, size_t rows, size_t cpus) {
+  if (rows > t->row_cap) {
+    size_t cap = t->row_cap ? t->row_cap : 64;
+    while (cap < rows) cap *= 2;
+    irq_row_t *grown = (irq_row_t *)realloc(t->rows, cap * sizeof(*grown));
+    if (!grown) return false;
+    t->rows = grown;
+    t->row_cap = cap;
+  }
+  if (cpus > t->cpu_cap) {
+    int *grown = (int *)realloc(t->cpu_ids, cpus * sizeof(*grown));
+    if (!grown) return false;
+    t->cpu_ids = grown;
+    t->cpu_cap = cpus;
+  }
+  const size_t cells = t->row_cap * t->cpu_cap;
+  uint64_t *cur = (uint64_t *)realloc(t->cur, cells * sizeof(*cur));
+  if (!cur) return false;
+  t->cur = cur;
+  uint64_t *prev = (uint64_t *)realloc(t->prev, cells * sizeof(*prev));
+  if (!prev) return false;
+  t->prev = prev;
+  double *rate = (double *)realloc(t->rate, cells * sizeof(*rate));
+  if (!rate) return false;
+  t->rate = rate;
+  return true;
+}
+
+/* Header: "           CPU0       CPU1 ...". Returns false if the column set changed. */
+static const char *parse_header(irq_table_t *t, const char *p, bool *changed, bool *ok) {
+  size_t n = 0;
+  *ok = true;
+  for (;;) {
+    p = sysmon_skip_spaces_wide(p);
+    if (strncmp(p, "CPU", 3) != 0) break;
+    p += 3;
+    uint64_t id = 0;
+    if (!sysmon_parse_u64(&p, &id)) break;
+    if (n >= t->cpu_cap && !table_reserve(t, t->row_cap, n + 64)) {
+      *ok = false;
+      return p;
+    }
+    if (n >= t->cpu_count || t->cpu_ids[n] != (int)id) *changed = true;
+    t->cpu_ids[n++] = (int)id;
+  }
+  if (n != t->cpu_count) *changed = true;
+  t->cpu_count = n;
+  return sysmon_next_line(p);
+}
+
+static void copy_name(irq_row_t *row, const char *desc, const char *end, bool numeric) {
+  while (end > desc && (end[-1] == ' ' || end[-1] == '\t')) end--;
+  if (numeric) {
+    /* "IO-APIC   5-edge      ACPI:Ged" -> the device is the last token */
+    const char *start = end;
+    while (start > desc && start[-1] != ' ' && start[-1] != '\t') start--;
+    desc = start;
+  }
+  size_t len = (size_t)(end - desc);
+  if (len >= IRQ_NAME_LEN) len = IRQ_NAME_LEN - 1;
+  memcpy(row->name, desc, len);
+  row->name[len] = '\0';
+}
+
+/* Fills t->cur straight from the text; labels are compared in place and names are only
+ * re-extracted when the row layout differs from the previous sample. */
+static bool table_read(irq_table_t *t) {
+  if (!sysmon_file_read(&t->file)) return false;
+  bool changed = false, ok = true;
+  const char *p = parse_header(t, t->file.buf, &changed, &ok);
+  if (!ok) return false;
+
+  const size_t cpus = t->cpu_count;
+  size_t r = 0;
+  while (*p) {
+    p = sysmon_skip_spaces_wide(p);
+    const char *label = p;
+    while (*p && *p != ':' && *p != '\n') p++;
+    if (*p != ':') {
+      p = sysmon_next_line(p);
+      continue;
+    }
+    size_t label_len = (size_t)(p - label);
+    if (label_len >= IRQ_LABEL_LEN) label_len = IRQ_LABEL_LEN - 1;
+    p++;
+
+    if (r >= t->row_cap && !table_reserve(t, r + 1, t->cpu_cap)) return false;
+    irq_row_t *row = &t->rows[r];
+    const bool same = r < t->row_count && strncmp(row->label, label, label_len) == 0 &&
+                      row->label[label_len] == '\0';
+
+    uint64_t *cells = t->cur + r * t->cpu_cap;
+    size_t c = 0;
+    for (; c < cpus; c++) {
+      p = sysmon_skip_spaces_wide(p);
+      if (!sysmon_parse_u64(&p, &cells[c])) break;
+    }
+    for (size_t i = c; i < cpus; i++) cells[i] = 0;
+
+    const char *line_end = p;
+    while (*line_end && *line_end != '\n') line_end++;
+    if (!same) {
+      changed = true;
+      memcpy(row->label, label, label_len);
+      row->label[label_len] = '\0';
+      copy_name(row, sysmon_skip_blanks(p), line_end, isdigit((unsigned char)label[0]) != 0);
+    }
+    p = *line_end ? line_end + 1 : line_end;
+    r++;
+  }
+  if (r != t->row_count) changed = true;
+  t->row_count = r;
+  if (changed) t->has_prev = false;
+  return true;
+}
+
+static void table_update(irq_table_t *t, double seconds) {
+  const size_t cells = t->row_cap * t->cpu_cap;
+  if (t->has_prev && seconds > 0.0) {
+    for (size_t r = 0; r < t->row_count; r++) {
+      const uint64_t *cur = t->cur + r * t->cpu_cap, *prev = t->prev + r * t->cpu_cap;
+      double *rate = t->rate + r * t->cpu_cap;
+      for (size_t c = 0; c < t->cpu_count; c++)
+        rate[c] = cur[c] >= prev[c] ? (double)(cur[c] - prev[c]) / seconds : 0.0;
+    }
+  } else {
+    memset(t->rate, 0, cells * sizeof(*t->rate));
+  }
+  uint64_t *tmp = t->prev;
+  t->prev = t->cur;
+  t->cur = tmp;
+  t->has_prev = true;
+}
+
+static double row_rate(const irq_table_t *t, size_t r, size_t *out_busiest) {
+  const double *rate = t->rate + r * t->cpu_cap;
+  double sum = 0.0, max = -1.0;
+  for (size_t c = 0; c < t->cpu_count; c++) {
+    sum += rate[c];
+    if (rate[c] > max) {
+      max = rate[c];
+      if (out_busiest) *out_busiest = c;
+    }
+  }
+  return sum;
+}
+
+static bool table_open(irq_table_t *t, const sysmon_paths_t *paths, const char *rel) {
+  char path[SYSMON_PATH_LEN];
+  sysmon_proc_path(paths, rel, path, sizeof(path));
+  return sysmon_file_open(&t->file, path) && table_reserve(t, 64, 64);
+}
+#endif
+
+static void irq_destroy(void *state) {
+  irq_state_t *st = (irq_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  table_free(&st->hard);
+  table_free(&st->soft);
+#endif
+  sysmon_topk_destroy(&st->top);
+  free(st);
+}
+
+static sysmon_result_t irq_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                  const char *section, void **out_state, char **out_error) {
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  bool ok = true;
+  const uint32_t top_n = sysmon_ini_get_u32(ini, section, "top_n", 5, &ok);
+  if (!ok || top_n == 0 || top_n > 64) {
+    sysmon_set_error(out_error, "invalid top_n (must be 1..64)");
+    return SYSMON_ERR_PARSE;
+  }
+  irq_state_t *st = (irq_state_t *)calloc(1, sizeof(*st));
+  if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+  sysmon_file_init(&st->hard.file);
+  sysmon_file_init(&st->soft.file);
+  st->per_cpu = sysmon_ini_get_bool(ini, section, "per_cpu", true);
+  if (!sysmon_topk_init(&st->top, top_n)) {
+    irq_destroy(st);
+    return SYSMON_ERR_OUT_OF_MEMORY;
+  }
+  if (!table_open(&st->hard, paths, "interrupts")) {
+    sysmon_set_path_error(out_error, "cannot open", st->hard.file.path);
+    irq_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+  st->has_soft = table_open(&st->soft, paths, "softirqs");
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)paths;
+  (void)ini;
+  (void)section;
+  sysmon_set_error(out_error, "irq module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+#if defined(__linux__)
+static sysmon_result_t add_softirqs(irq_state_t *st, sysmon_snapshot_builder_t *builder) {
+  const irq_table_t *t = &st->soft;
+  char name[96];
+  sysmon_result_t rc;
+  for (size_t r = 0; r < t->row_count; r++) {
+    char lower[IRQ_LABEL_LEN];
+    size_t i = 0;
+    for (; t->rows[r].label[i]; i++) lower[i] = (char)tolower((unsigned char)t->rows[r].label[i]);
+    lower[i] = '\0';
+    snprintf(name, sizeof(name), "irq.softirq.%s_per_sec", lower);
+    rc = sysmon_snapshot_builder_add_double(builder, name, "/s", row_rate(t, r, NULL));
+    if (rc != SYSMON_OK) return rc;
+
+    const bool net_rx = strcmp(lower, "net_rx") == 0;
+    if (!net_rx && strcmp(lower, "net_tx") != 0) continue;
+    const double *rate = t->rate + r * t->cpu_cap;
+    if (net_rx) {
+      size_t busiest = 0;
+      const double sum = row_rate(t, r, &busiest);
+      rc = sysmon_snapshot_builder_add_double(builder, "irq.net_rx_max_cpu_share_percent", "%",
+                                              sum > 0.0 ? rate[busiest] * 100.0 / sum : 0.0);
+      if (rc != SYSMON_OK) return rc;
+    }
+    if (!st->per_cpu) continue;
+    for (size_t c = 0; c < t->cpu_count; c++) {
+      snprintf(name, sizeof(name), "irq.cpu.%d.%s_per_sec", t->cpu_ids[c], lower);
+      rc = sysmon_snapshot_builder_add_double(builder, name, "/s", rate[c]);
+      if (rc != SYSMON_OK) return rc;
+    }
+  }
+  return SYSMON_OK;
+}
+#endif
+
+static sysmon_result_t irq_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                sysmon_snapshot_builder_t *builder, char **out_error) {
+  irq_state_t *st = (irq_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+
+#if defined(__linux__)
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
+    if (!table_read(&st->hard) || (st->has_soft && !table_read(&st->soft))) {
+      sysmon_set_error(out_error, "failed to read interrupt counters");
+      return SYSMON_ERR_IO;
+    }
+    const double seconds = st->has_data && now_ns > st->last_ts_ns
+                               ? (double)(now_ns - st->last_ts_ns) / (double)SYSMON_NS_PER_SEC
+                               : 0.0;
+    table_update(&st->hard, seconds);
+    if (st->has_soft) table_update(&st->soft, seconds);
+
+    sysmon_topk_reset(&st->top);
+    st->total_rate = 0.0;
+    for (size_t r = 0; r < st->hard.row_count; r++) {
+      const double rate = row_rate(&st->hard, r, NULL);
+      st->total_rate += rate;
+      if (rate > 0.0) sysmon_topk_offer(&st->top, rate, (uint32_t)r);
+    }
+    sysmon_topk_sort_desc(&st->top);
+    st->last_ts_ns = now_ns;
+    st->has_data = true;
+  }
+
+  sysmon_result_t rc =
+      sysmon_snapshot_builder_add_double(builder, "irq.total_per_sec", "/s", st->total_rate);
+  if (rc != SYSMON_OK) return rc;
+
+  char name[96];
+#define IRQ_ADD(kind, rank, metric, unit, value)                             \
+  do {                                                                       \
+    snprintf(name, sizeof(name), "irq.top.%zu.%s", rank, metric);            \
+    rc = sysmon_snapshot_builder_add_##kind(builder, name, unit, value);     \
+    if (rc != SYSMON_OK) return rc;                                          \
+  } while (0)
+  for (size_t i = 0; i < st->top.count; i++) {
+    const size_t r = st->top.items[i].index;
+    size_t busiest = 0;
+    const double rate = row_rate(&st->hard, r, &busiest);
+    const double busiest_rate = st->hard.rate[r * st->hard.cpu_cap + busiest];
+    IRQ_ADD(string, i, "irq", NULL, st->hard.rows[r].label);
+    IRQ_ADD(string, i, "name", NULL, st->hard.rows[r].name);
+    IRQ_ADD(double, i, "per_sec", "/s", rate);
+    IRQ_ADD(i64, i, "busiest_cpu", NULL, st->hard.cpu_ids[busiest]);
+    IRQ_ADD(double, i, "busiest_cpu_percent", "%", rate > 0.0 ? busiest_rate * 100.0 / rate : 0.0);
+  }
+#undef IRQ_ADD
+
+  return st->has_soft ? add_softirqs(st, builder) : SYSMON_OK;
+#else
+  (void)now_ns;
+  (void)refresh_now;
+  sysmon_set_error(out_error, "irq module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_irq_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "irq",
+      .create = irq_create,
+      .poll = irq_poll,
+      .destroy = irq_destroy,
+  };
+  return &vtable;
+}
@@ -0,0 +1,205 @@
+#include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SYSMON_KERNEL_DEFAULT_LIMITS_MS 60000u
+
+/* Counters re-read on every refresh. */
+enum { KF_FILE_NR, KF_INODE_NR, KF_LOADAVG, KF_CONNTRACK_COUNT, KF_DYNAMIC };
+/* Limits re-read every limits_refresh_ms. */
+enum { KL_PID_MAX, KL_THREADS_MAX, KL_CONNTRACK_MAX, KL_LIMITS };
+
+static const char *const kernel_dynamic_paths[KF_DYNAMIC] = {
+    "sys/fs/file-nr", "sys/fs/inode-nr", "loadavg", "sys/net/netfilter/nf_conntrack_count"};
+static const char *const kernel_limit_paths[KL_LIMITS] = {
+    "sys/kernel/pid_max", "sys/kernel/threads-max", "sys/net/netfilter/nf_conntrack_max"};
+
+typedef struct kernel_state {
+  sysmon_file_t dynamic[KF_DYNAMIC];
+  sysmon_file_t limits[KL_LIMITS];
+  uint64_t limit_values[KL_LIMITS];
+  uint64_t limits_interval_ns;
+  uint64_t limits_ts_ns;
+  uint64_t files_allocated;
+  uint64_t files_free;
+  uint64_t files_max;
+  uint64_t inodes;
+  uint64_t inodes_free;
+  uint64_t threads;
+  uint64_t conntrack;
+  bool has_limits;
+  bool has_data;
+} kernel_state_t;
+
+#if defined(__linux__)
+static bool read_u64s(sysmon_file_t *f, uint64_t *out, size_t count) {
+  if (f->fd < 0 || !sysmon_file_read(f)) return false;
+  const char *p = f->buf;
+  for (size_t i = 0; i < count; i++) {
+    if (!sysmon_parse_u64(&p, &out[i])) return false;
+  }
+  return true;
+}
+
+/* "0.31 0.27 0.24 2/76 21513": the denominator counts every thread on the host. */
+static bool read_thread_count(sysmon_file_t *f, uint64_t *out) {
+  if (f->fd < 0 || !sysmon_file_read(f)) return false;
+  const char *slash = strchr(f->buf, '/');
+  if (!slash) return false;
+  const char *p = slash + 1;
+  return sysmon_parse_u64(&p, out);
+}
+
+static double percent(uint64_t used, uint64_t max) {
+  return max ? (double)used * 100.0 / (double)max : 0.0;
+}
+#endif
+
+static void kernel_destroy(void *state) {
+  kernel_state_t *st = (kernel_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  for (size_t i = 0; i < KF_DYNAMIC; i++) sysmon_file_close(&st->dynamic[i]);
+  for (size_t i = 0; i < KL_LIMITS; i++) sysmon_file_close(&st->limits[i]);
+#endif
+  free(st);
+}
+
+static sysmon_result_t kernel_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                     const char *section, void **out_state, char **out_error) {
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+  bool ok = true;
+  const uint32_t limits_ms = sysmon_ini_get_u32(ini, section, "limits_refresh_ms",
+                                                SYSMON_KERNEL_DEFAULT_LIMITS_MS, &ok);
+  if (!ok) {
+    sysmon_set_error(out_error, "invalid limits_refresh_ms (must be uint32)");
+    return SYSMON_ERR_PARSE;
+  }
+#if defined(__linux__)
+  kernel_state_t *st = (kernel_state_t *)calloc(1, sizeof(*st));
+  if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+  st->limits_interval_ns = (uint64_t)limits_ms * SYSMON_NS_PER_MS;
+
+  char path[SYSMON_PATH_LEN];
+  for (size_t i = 0; i < KF_DYNAMIC; i++) {
+    sysmon_file_init(&st->dynamic[i]);
+    sysmon_proc_path(paths, kernel_dynamic_paths[i], path, sizeof(path));
+    sysmon_file_open(&st->dynamic[i], path); /* conntrack is absent without nf_conntrack */
+  }
+  for (size_t i = 0; i < KL_LIMITS; i++) {
+    sysmon_file_init(&st->limits[i]);
+    sysmon_proc_path(paths, kernel_limit_paths[i], path, sizeof(path));
+    sysmon_file_open(&st->limits[i], path);
+  }
+  if (st->dynamic[KF_FILE_NR].fd < 0 && st->dynamic[KF_LOADAVG].fd < 0) {
+    sysmon_set_path_error(out_error, "cannot open", st->dynamic[KF_FILE_NR].path);
+    kernel_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)paths;
+  (void)limits_ms;
+  sysmon_set_error(out_error, "kernel module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static sysmon_result_t kernel_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                   sysmon_snapshot_builder_t *builder, char **out_error) {
+  kernel_state_t *st = (kernel_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+  (void)out_error;
+
+#if defined(__linux__)
+  if (!st->has_limits || now_ns - st->limits_ts_ns >= st->limits_interval_ns) {
+    for (size_t i = 0; i < KL_LIMITS; i++) {
+      if (!read_u64s(&st->limits[i], &st->limit_values[i], 1)) st->limit_values[i] = 0;
+    }
+    st->limits_ts_ns = now_ns;
+    st->has_limits = true;
+  }
+
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
+    /* file-nr: allocated, free (always 0 since 2.6), max. inode-nr: allocated, free. */
+    uint64_t v[3] = {0, 0, 0};
+    if (read_u64s(&st->dynamic[KF_FILE_NR], v, 3)) {
+      st->files_allocated = v[0];
+      st->files_free = v[1];
+      st->files_max = v[2];
+    }
+    if (read_u64s(&st->dynamic[KF_INODE_NR], v, 2)) {
+      st->inodes = v[0];
+      st->inodes_free = v[1];
+    }
+    read_thread_count(&st->dynamic[KF_LOADAVG], &st->threads);
+    read_u64s(&st->dynamic[KF_CONNTRACK_COUNT], &st->conntrack, 1);
+    st->has_data = true;
+  }
+
+  sysmon_result_t rc;
+  double worst = 0.0;
+#define KERNEL_ADD(kind, metric, unit, value)                                         \
+  do {                                                                                \
+    rc = sysmon_snapshot_builder_add_##kind(builder, "kernel." metric, unit, value);   \
+    if (rc != SYSMON_OK) return rc;                                                   \
+  } while (0)
+#define KERNEL_PERCENT(metric, used, max)                                             \
+  do {                                                                                \
+    const double pct = percent(used, max);                                            \
+    if (pct > worst) worst = pct;                                                     \
+    KERNEL_ADD(double, metric, "%", pct);                                             \
+  } while (0)
+
+  if (st->dynamic[KF_FILE_NR].fd >= 0) {
+    const uint64_t used =
+        st->files_allocated > st->files_free ? st->files_allocated - st->files_free : 0;
+    KERNEL_ADD(u64, "file_handles_used", NULL, used);
+    KERNEL_ADD(u64, "file_handles_max", NULL, st->files_max);
+    KERNEL_PERCENT("file_handles_percent", used, st->files_max);
+  }
+  if (st->dynamic[KF_INODE_NR].fd >= 0) {
+    KERNEL_ADD(u64, "inodes_allocated", NULL, st->inodes);
+    KERNEL_ADD(u64, "inodes_unused", NULL, st->inodes_free);
+  }
+  if (st->dynamic[KF_LOADAVG].fd >= 0) {
+    KERNEL_ADD(u64, "threads", NULL, st->threads);
+    if (st->limit_values[KL_PID_MAX]) {
+      KERNEL_ADD(u64, "pid_max", NULL, st->limit_values[KL_PID_MAX]);
+      KERNEL_PERCENT("pid_percent", st->threads, st->limit_values[KL_PID_MAX]);
+    }
+    if (st->limit_values[KL_THREADS_MAX]) {
+      KERNEL_ADD(u64, "threads_max", NULL, st->limit_values[KL_THREADS_MAX]);
+      KERNEL_PERCENT("threads_percent", st->threads, st->limit_values[KL_THREADS_MAX]);
+    }
+  }
+  if (st->dynamic[KF_CONNTRACK_COUNT].fd >= 0 && st->limit_values[KL_CONNTRACK_MAX]) {
+    KERNEL_ADD(u64, "conntrack_entries", NULL, st->conntrack);
+    KERNEL_ADD(u64, "conntrack_max", NULL, st->limit_values[KL_CONNTRACK_MAX]);
+    KERNEL_PERCENT("conntrack_percent", st->conntrack, st->limit_values[KL_CONNTRACK_MAX]);
+  }
+  KERNEL_ADD(double, "max_table_percent", "%", worst);
+#undef KERNEL_PERCENT
+#undef KERNEL_ADD
+  return SYSMON_OK;
+#else
+  (void)now_ns;
+  (void)refresh_now;
+  sysmon_set_error(out_error, "kernel module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_kernel_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "kernel",
+      .create = kernel_create,
+      .poll = kernel_poll,
+      .destroy = kernel_destroy,
+  };
+  return &vtable;
+}
@@ -0,0 +1,371 @@
+#include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define SYSMON_MEMDETAIL_MAX_POOLS 8
+#define SYSMON_MEMDETAIL_DEFAULT_SLAB_MS 30000u
+#define SLAB_NAME_LEN 32
+
+enum { HP_TOTAL, HP_FREE, HP_RESV, HP_SURPLUS, HP_FIELDS };
+
+static const char *const hugepage_files[HP_FIELDS] = {"nr_hugepages", "free_hugepages",
+                                                      "resv_hugepages", "surplus_hugepages"};
+static const char *const hugepage_names[HP_FIELDS] = {"total", "free", "reserved", "surplus"};
+
+/* /proc/meminfo keys, values in kB. */
+enum { MI_TOTAL, MI_SLAB, MI_SRECLAIMABLE, MI_SUNRECLAIM, MI_ANON_HUGE, MI_SHMEM_HUGE, MI_FILE_HUGE,
+       MI_KEYS };
+
+static const char *const meminfo_keys[MI_KEYS] = {
+    "MemTotal:",      "Slab:",           "SReclaimable:", "SUnreclaim:",
+    "AnonHugePages:", "ShmemHugePages:", "FileHugePages:"};
+
+/* /proc/vmstat THP event counters, published as rates. */
+enum { THP_FAULT_ALLOC, THP_FAULT_FALLBACK, THP_COLLAPSE_ALLOC, THP_SPLIT_PAGE, THP_COUNTERS };
+
+static const char *const thp_keys[THP_COUNTERS] = {"thp_fault_alloc", "thp_fault_fallback",
+                                                   "thp_collapse_alloc", "thp_split_page"};
+
+typedef struct hugepage_pool {
+  uint64_t size_kb;
+  int fds[HP_FIELDS];
+  uint64_t pages[HP_FIELDS];
+} hugepage_pool_t;
+
+typedef struct slab_entry {
+  char name[SLAB_NAME_LEN];
+  uint64_t bytes;
+  double active_percent;
+} slab_entry_t;
+
+typedef struct memdetail_state {
+  hugepage_pool_t pools[SYSMON_MEMDETAIL_MAX_POOLS];
+  size_t pool_count;
+  sysmon_file_t meminfo;
+  sysmon_file_t vmstat;
+  sysmon_file_t thp_enabled;
+  sysmon_file_t slabinfo;
+  uint64_t mem[MI_KEYS];
+  uint64_t thp[THP_COUNTERS];
+  double thp_rates[THP_COUNTERS];
+  char thp_mode[16];
+  sysmon_topk_t slab_top;
+  slab_entry_t *slabs;
+  size_t slab_count;
+  uint64_t slab_interval_ns;
+  uint64_t slab_ts_ns;
+  bool has_slabs;
+  uint64_t last_ts_ns;
+  bool has_data;
+} memdetail_state_t;
+
+#if defined(__linux__)
+static int cmp_pool(const void *a, const void *b) {
+  const uint64_t x = ((const hugepage_pool_t *)a)->size_kb, y = ((const hugepage_pool_t *)b)->size_kb;
+  return (x > y) - (x < y);
+}
+
+static void open_pools(memdetail_state_t *st, const sysmon_paths_t *paths) {
+  char dir[SYSMON_PATH_LEN];
+  sysmon_sys_path(paths, "kernel/mm/hugepages", dir, sizeof(dir));
+  DIR *d = opendir(dir);
+  if (!d) return;
+  for (struct dirent *e; (e = readdir(d)) != NULL && st->pool_count < SYSMON_MEMDETAIL_MAX_POOLS;) {
+    if (strncmp(e->d_name, "hugepages-", 10) != 0) continue;
+    const char *p = e->d_name + 10;
+    uint64_t kb = 0;
+    if (!sysmon_parse_u64(&p, &kb) || strcmp(p, "kB") != 0) continue;
+    hugepage_pool_t *pool = &st->pools[st->pool_count];
+    pool->size_kb = kb;
+    size_t opened = 0;
+    for (size_t f = 0; f < HP_FIELDS; f++) {
+      char rel[SYSMON_PATH_LEN];
+      snprintf(rel, sizeof(rel), "%s/%s", e->d_name, hugepage_files[f]);
+      pool->fds[f] = openat(dirfd(d), rel, O_RDONLY | O_CLOEXEC);
+      opened += pool->fds[f] >= 0;
+    }
+    if (opened) st->pool_count++;
+    else memset(pool, 0, sizeof(*pool));
+  }
+  closedir(d);
+  qsort(st->pools, st->pool_count, sizeof(st->pools[0]), cmp_pool);
+}
+
+static void parse_meminfo(memdetail_state_t *st) {
+  for (const char *p = st->meminfo.buf; *p; p = sysmon_next_line(p)) {
+    for (size_t k = 0; k < MI_KEYS; k++) {
+      const size_t len = strlen(meminfo_keys[k]);
+      if (strncmp(p, meminfo_keys[k], len) != 0) continue;
+      const char *v = p + len;
+      uint64_t kb = 0;
+      if (sysmon_parse_u64(&v, &kb)) st->mem[k] = kb * 1024u;
+      break;
+    }
+  }
+}
+
+/* Only "thp_" lines are compared; they form one contiguous block in /proc/vmstat. */
+static void parse_thp(memdetail_state_t *st, double seconds) {
+  uint64_t cur[THP_COUNTERS];
+  memcpy(cur, st->thp, sizeof(cur));
+  for (const char *p = st->vmstat.buf; *p; p = sysmon_next_line(p)) {
+    if (p[0] != 't' || strncmp(p, "thp_", 4) != 0) continue;
+    for (size_t k = 0; k < THP_COUNTERS; k++) {
+      const size_t len = strlen(thp_keys[k]);
+      if (strncmp(p, thp_keys[k], len) != 0 || p[len] != ' ') continue;
+      const char *v = p + len;
+      sysmon_parse_u64(&v, &cur[k]);
+      break;
+    }
+  }
+  for (size_t k = 0; k < THP_COUNTERS; k++) {
+    st->thp_rates[k] = seconds > 0.0 && cur[k] >= st->thp[k]
+                           ? (double)(cur[k] - st->thp[k]) / seconds
+                           : 0.0;
+    st->thp[k] = cur[k];
+  }
+}
+
+/* "always [madvise] never" -> "madvise" */
+static void parse_thp_mode(memdetail_state_t *st) {
+  st->thp_mode[0] = '\0';
+  if (st->thp_enabled.fd < 0 || !sysmon_file_read(&st->thp_enabled)) return;
+  const char *open_br = strchr(st->thp_enabled.buf, '[');
+  const char *close_br = open_br ? strchr(open_br, ']') : NULL;
+  if (!close_br || (size_t)(close_br - open_br) > sizeof(st->thp_mode)) return;
+  memcpy(st->thp_mode, open_br + 1, (size_t)(close_br - open_br - 1));
+  st->thp_mode[close_br - open_br - 1] = '\0';
+}
+
+/* "name <active_objs> <num_objs> <objsize> ...": one pass over the file, feeding a bounded
+ * top-K keyed by num_objs * objsize; only the winners' names are copied out. */
+static void scan_slabinfo(memdetail_state_t *st) {
+  st->has_slabs = false;
+  if (!sysmon_file_read(&st->slabinfo)) return;
+  const char *base = st->slabinfo.buf;
+  sysmon_topk_reset(&st->slab_top);
+  for (const char *p = base; *p; p = sysmon_next_line(p)) {
+    if (*p == '#' || strncmp(p, "slabinfo", 8) == 0) continue;
+    const char *q = p;
+    while (*q && *q != ' ' && *q != '\n') q++;
+    uint64_t active = 0, num = 0, size = 0;
+    if (!sysmon_parse_u64(&q, &active) || !sysmon_parse_u64(&q, &num) ||
+        !sysmon_parse_u64(&q, &size) || num == 0)
+      continue;
+    sysmon_topk_offer(&st->slab_top, (double)num * (double)size, (uint32_t)(p - base));
+  }
+  sysmon_topk_sort_desc(&st->slab_top);
+
+  st->slab_count = st->slab_top.count;
+  for (size_t i = 0; i < st->slab_count; i++) {
+    const char *line = base + st->slab_top.items[i].index;
+    slab_entry_t *e = &st->slabs[i];
+    size_t n = 0;
+    while (line[n] && line[n] != ' ' && n + 1 < SLAB_NAME_LEN) n++;
+    memcpy(e->name, line, n);
+    e->name[n] = '\0';
+    const char *q = line;
+    while (*q && *q != ' ') q++;
+    uint64_t active = 0, num = 0;
+    sysmon_parse_u64(&q, &active);
+    sysmon_parse_u64(&q, &num);
+    e->bytes = (uint64_t)st->slab_top.items[i].score;
+    e->active_percent = num ? (double)active * 100.0 / (double)num : 0.0;
+  }
+  st->has_slabs = true;
+}
+#endif
+
+static void memdetail_destroy(void *state) {
+  memdetail_state_t *st = (memdetail_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  for (size_t i = 0; i < st->pool_count; i++) {
+    for (size_t f = 0; f < HP_FIELDS; f++) {
+      if (st->pools[i].fds[f] >= 0) close(st->pools[i].fds[f]);
+    }
+  }
+  sysmon_file_close(&st->meminfo);
+  sysmon_file_close(&st->vmstat);
+  sysmon_file_close(&st->thp_enabled);
+  sysmon_file_close(&st->slabinfo);
+#endif
+  sysmon_topk_destroy(&st->slab_top);
+  free(st->slabs);
+  free(st);
+}
+
+static sysmon_result_t memdetail_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                        const char *section, void **out_state, char **out_error) {
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  bool ok = true;
+  const uint32_t slab_top_n = sysmon_ini_get_u32(ini, section, "slab_top_n", 0, &ok);
+  if (!ok || slab_top_n > 64) {
+    sysmon_set_error(out_error, "invalid slab_top_n (must be 0..64)");
+    return SYSMON_ERR_PARSE;
+  }
+  const uint32_t slab_ms = sysmon_ini_get_u32(ini, section, "slab_refresh_ms",
+                                              SYSMON_MEMDETAIL_DEFAULT_SLAB_MS, &ok);
+  if (!ok) {
+    sysmon_set_error(out_error, "invalid slab_refresh_ms (must be uint32)");
+    return SYSMON_ERR_PARSE;
+  }
+
+  memdetail_state_t *st = (memdetail_state_t *)calloc(1, sizeof(*st));
+  if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+  sysmon_file_init(&st->meminfo);
+  sysmon_file_init(&st->vmstat);
+  sysmon_file_init(&st->thp_enabled);
+  sysmon_file_init(&st->slabinfo);
+  st->slab_interval_ns = (uint64_t)slab_ms * SYSMON_NS_PER_MS;
+
+  char path[SYSMON_PATH_LEN];
+  sysmon_proc_path(paths, "meminfo", path, sizeof(path));
+  if (!sysmon_file_open(&st->meminfo, path)) {
+    sysmon_set_path_error(out_error, "cannot open", path);
+    memdetail_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+  sysmon_proc_path(paths, "vmstat", path, sizeof(path));
+  sysmon_file_open(&st->vmstat, path);
+  sysmon_sys_path(paths, "kernel/mm/transparent_hugepage/enabled", path, sizeof(path));
+  sysmon_file_open(&st->thp_enabled, path);
+  open_pools(st, paths);
+
+  /* slabinfo is 0400: without CAP_SYS_ADMIN the top-K is simply not published. */
+  if (slab_top_n > 0) {
+    sysmon_proc_path(paths, "slabinfo", path, sizeof(path));
+    st->slabs = (slab_entry_t *)calloc(slab_top_n, sizeof(*st->slabs));
+    if (!st->slabs || !sysmon_topk_init(&st->slab_top, slab_top_n)) {
+      memdetail_destroy(st);
+      return SYSMON_ERR_OUT_OF_MEMORY;
+    }
+    sysmon_file_open(&st->slabinfo, path);
+  }
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)paths;
+  (void)ini;
+  (void)section;
+  sysmon_set_error(out_error, "memdetail module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static sysmon_result_t memdetail_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                      sysmon_snapshot_builder_t *builder, char **out_error) {
+  memdetail_state_t *st = (memdetail_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+
+#if defined(__linux__)
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
+    const double seconds = st->has_data && now_ns > st->last_ts_ns
+                               ? (double)(now_ns - st->last_ts_ns) / (double)SYSMON_NS_PER_SEC
+                               : 0.0;
+    if (!sysmon_file_read(&st->meminfo)) {
+      sysmon_set_path_error(out_error, "failed to read", st->meminfo.path);
+      return SYSMON_ERR_IO;
+    }
+    parse_meminfo(st);
+    if (st->vmstat.fd >= 0 && sysmon_file_read(&st->vmstat)) parse_thp(st, seconds);
+    parse_thp_mode(st);
+    for (size_t i = 0; i < st->pool_count; i++) {
+      hugepage_pool_t *pool = &st->pools[i];
+      for (size_t f = 0; f < HP_FIELDS; f++) {
+        int64_t v = 0;
+        if (pool->fds[f] < 0 || !sysmon_pread_i64(pool->fds[f], &v) || v < 0) v = 0;
+        pool->pages[f] = (uint64_t)v;
+      }
+    }
+    st->last_ts_ns = now_ns;
+    st->has_data = true;
+  }
+  if (st->slabinfo.fd >= 0 &&
+      (st->slab_ts_ns == 0 || now_ns - st->slab_ts_ns >= st->slab_interval_ns)) {
+    scan_slabinfo(st);
+    st->slab_ts_ns = now_ns;
+  }
+
+  char name[128];
+  sysmon_result_t rc;
+#define MEMDETAIL_ADD(kind, unit, value, ...)                                  \
+  do {                                                                         \
+    snprintf(name, sizeof(name), "memdetail." __VA_ARGS__);                    \
+    rc = sysmon_snapshot_builder_add_##kind(builder, name, unit, value);       \
+    if (rc != SYSMON_OK) return rc;                                            \
+  } while (0)
+
+  uint64_t huge_total = 0, huge_used = 0;
+  for (size_t i = 0; i < st->pool_count; i++) {
+    const hugepage_pool_t *pool = &st->pools[i];
+    const uint64_t size = pool->size_kb * 1024u;
+    const uint64_t total = pool->pages[HP_TOTAL];
+    const uint64_t used = total > pool->pages[HP_FREE] ? total - pool->pages[HP_FREE] : 0;
+    for (size_t f = 0; f < HP_FIELDS; f++) {
+      MEMDETAIL_ADD(u64, "pages", pool->pages[f], "hugepages.%llukB.%s",
+                    (unsigned long long)pool->size_kb, hugepage_names[f]);
+    }
+    MEMDETAIL_ADD(u64, "B", used * size, "hugepages.%llukB.used_bytes",
+                  (unsigned long long)pool->size_kb);
+    huge_total += total * size;
+    huge_used += used * size;
+  }
+  MEMDETAIL_ADD(u64, "B", huge_total, "hugepages_total_bytes");
+  MEMDETAIL_ADD(u64, "B", huge_used, "hugepages_used_bytes");
+  MEMDETAIL_ADD(double, "%",
+                st->mem[MI_TOTAL] ? (double)huge_total * 100.0 / (double)st->mem[MI_TOTAL] : 0.0,
+                "hugepages_ram_percent");
+
+  MEMDETAIL_ADD(u64, "B", st->mem[MI_ANON_HUGE], "thp_anon_bytes");
+  MEMDETAIL_ADD(u64, "B", st->mem[MI_SHMEM_HUGE], "thp_shmem_bytes");
+  MEMDETAIL_ADD(u64, "B", st->mem[MI_FILE_HUGE], "thp_file_bytes");
+  for (size_t k = 0; k < THP_COUNTERS && st->vmstat.fd >= 0; k++) {
+    MEMDETAIL_ADD(double, "/s", st->thp_rates[k], "%s_per_sec", thp_keys[k]);
+  }
+  if (st->thp_mode[0]) {
+    rc = sysmon_snapshot_builder_add_string(builder, "memdetail.thp_enabled", NULL, st->thp_mode);
+    if (rc != SYSMON_OK) return rc;
+  }
+
+  MEMDETAIL_ADD(u64, "B", st->mem[MI_SLAB], "slab_bytes");
+  MEMDETAIL_ADD(u64, "B", st->mem[MI_SRECLAIMABLE], "slab_reclaimable_bytes");
+  MEMDETAIL_ADD(u64, "B", st->mem[MI_SUNRECLAIM], "slab_unreclaimable_bytes");
+  for (size_t i = 0; st->has_slabs && i < st->slab_count; i++) {
+    const slab_entry_t *e = &st->slabs[i];
+    snprintf(name, sizeof(name), "memdetail.slab.top.%zu.name", i);
+    rc = sysmon_snapshot_builder_add_string(builder, name, NULL, e->name);
+    if (rc != SYSMON_OK) return rc;
+    MEMDETAIL_ADD(u64, "B", e->bytes, "slab.top.%zu.bytes", i);
+    MEMDETAIL_ADD(double, "%", e->active_percent, "slab.top.%zu.active_percent", i);
+  }
+#undef MEMDETAIL_ADD
+  return SYSMON_OK;
+#else
+  (void)now_ns;
+  (void)refresh_now;
+  sysmon_set_error(out_error, "memdetail module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_memdetail_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "memdetail",
+      .create = memdetail_create,
+      .poll = memdetail_poll,
+      .destroy = memdetail_destroy,
+  };
+  return &vtable;
+}
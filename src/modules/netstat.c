@@ -0,0 +1,303 @@
+#include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NETSTAT_MAX_GROUPS 16
+
+typedef struct netstat_counter {
+  const char *name;
+  const char *group; /* "Tcp", "TcpExt", ... */
+  const char *field;
+  bool gauge;
+} netstat_counter_t;
+
+enum {
+  NS_IP_IN_RECEIVES,
+  NS_IP_IN_HDR_ERRORS,
+  NS_IP_IN_DISCARDS,
+  NS_IP_OUT_DISCARDS,
+  NS_IP_OUT_NO_ROUTES,
+  NS_IP_REASM_FAILS,
+  NS_IP_FRAG_FAILS,
+  NS_TCP_ACTIVE_OPENS,
+  NS_TCP_PASSIVE_OPENS,
+  NS_TCP_ATTEMPT_FAILS,
+  NS_TCP_ESTAB_RESETS,
+  NS_TCP_CURR_ESTAB,
+  NS_TCP_IN_SEGS,
+  NS_TCP_OUT_SEGS,
+  NS_TCP_RETRANS_SEGS,
+  NS_TCP_IN_ERRS,
+  NS_TCP_OUT_RSTS,
+  NS_TCP_LISTEN_OVERFLOWS,
+  NS_TCP_LISTEN_DROPS,
+  NS_TCP_TIMEOUTS,
+  NS_TCP_SYN_RETRANS,
+  NS_TCP_BACKLOG_DROP,
+  NS_TCP_RCVQ_DROP,
+  NS_TCP_ABORT_ON_MEMORY,
+  NS_UDP_IN_DATAGRAMS,
+  NS_UDP_OUT_DATAGRAMS,
+  NS_UDP_NO_PORTS,
+  NS_UDP_IN_ERRORS,
+  NS_UDP_RCVBUF_ERRORS,
+  NS_UDP_SNDBUF_ERRORS,
+  NS_COUNTERS
+};
+
+static const netstat_counter_t netstat_counters[NS_COUNTERS] = {
+    [NS_IP_IN_RECEIVES] = {"ip_in_receives", "Ip", "InReceives", false},
+    [NS_IP_IN_HDR_ERRORS] = {"ip_in_hdr_errors", "Ip", "InHdrErrors", false},
+    [NS_IP_IN_DISCARDS] = {"ip_in_discards", "Ip", "InDiscards", false},
+    [NS_IP_OUT_DISCARDS] = {"ip_out_discards", "Ip", "OutDiscards", false},
+    [NS_IP_OUT_NO_ROUTES] = {"ip_out_no_routes", "Ip", "OutNoRoutes", false},
+    [NS_IP_REASM_FAILS] = {"ip_reasm_fails", "Ip", "ReasmFails", false},
+    [NS_IP_FRAG_FAILS] = {"ip_frag_fails", "Ip", "FragFails", false},
+    [NS_TCP_ACTIVE_OPENS] = {"tcp_active_opens", "Tcp", "ActiveOpens", false},
+    [NS_TCP_PASSIVE_OPENS] = {"tcp_passive_opens", "Tcp", "PassiveOpens", false},
+    [NS_TCP_ATTEMPT_FAILS] = {"tcp_attempt_fails", "Tcp", "AttemptFails", false},
+    [NS_TCP_ESTAB_RESETS] = {"tcp_estab_resets", "Tcp", "EstabResets", false},
+    [NS_TCP_CURR_ESTAB] = {"tcp_curr_estab", "Tcp", "CurrEstab", true},
+    [NS_TCP_IN_SEGS] = {"tcp_in_segs", "Tcp", "InSegs", false},
+    [NS_TCP_OUT_SEGS] = {"tcp_out_segs", "Tcp", "OutSegs", false},
+    [NS_TCP_RETRANS_SEGS] = {"tcp_retrans_segs", "Tcp", "RetransSegs", false},
+    [NS_TCP_IN_ERRS] = {"tcp_in_errs", "Tcp", "InErrs", false},
+    [NS_TCP_OUT_RSTS] = {"tcp_out_rsts", "Tcp", "OutRsts", false},
+    [NS_TCP_LISTEN_OVERFLOWS] = {"tcp_listen_overflows", "TcpExt", "ListenOverflows", false},
+    [NS_TCP_LISTEN_DROPS] = {"tcp_listen_drops", "TcpExt", "ListenDrops", false},
+    [NS_TCP_TIMEOUTS] = {"tcp_timeouts", "TcpExt", "TCPTimeouts", false},
+    [NS_TCP_SYN_RETRANS] = {"tcp_syn_retrans", "TcpExt", "TCPSynRetrans", false},
+    [NS_TCP_BACKLOG_DROP] = {"tcp_backlog_drop", "TcpExt", "TCPBacklogDrop", false},
+    [NS_TCP_RCVQ_DROP] = {"tcp_rcvq_drop", "TcpExt", "TCPRcvQDrop", false},
+    [NS_TCP_ABORT_ON_MEMORY] = {"tcp_abort_on_memory", "TcpExt", "TCPAbortOnMemory", false},
+    [NS_UDP_IN_DATAGRAMS] = {"udp_in_datagrams", "Udp", "InDatagrams", false},
+    [NS_UDP_OUT_DATAGRAMS] = {"udp_out_datagrams", "Udp", "OutDatagrams", false},
+    [NS_UDP_NO_PORTS] = {"udp_no_ports", "Udp", "NoPorts", false},
+    [NS_UDP_IN_ERRORS] = {"udp_in_errors", "Udp", "InErrors", false},
+    [NS_UDP_RCVBUF_ERRORS] = {"udp_rcvbuf_errors", "Udp", "RcvbufErrors", false},
+    [NS_UDP_SNDBUF_ERRORS] = {"udp_sndbuf_errors", "Udp", "SndbufErrors", false},
+};
+
+static const char *const netstat_default_counters =
+    "tcp_out_segs,tcp_retrans_segs,tcp_curr_estab,tcp_listen_overflows,tcp_listen_drops,"
+    "tcp_estab_resets,udp_rcvbuf_errors,udp_in_errors,ip_reasm_fails,ip_frag_fails";
+
+/* Where a selected counter sits: value column `column` of the `group`-th header/value pair. */
+typedef struct netstat_column {
+  uint16_t group;
+  uint16_t column;
+  uint8_t counter;
+} netstat_column_t;
+
+/* One of /proc/net/snmp or /proc/net/netstat. The header lines are matched against the
+ * counter table once; later polls only check each header's length and walk the value lines. */
+typedef struct netstat_file {
+  sysmon_file_t file;
+  netstat_column_t cols[NS_COUNTERS];
+  size_t col_count;
+  uint32_t header_len[NETSTAT_MAX_GROUPS];
+  size_t group_count;
+  bool resolved;
+} netstat_file_t;
+
+typedef struct netstat_state {
+  netstat_file_t files[2];
+  bool selected[NS_COUNTERS];
+  uint64_t values[NS_COUNTERS];
+  uint64_t prev[NS_COUNTERS];
+  double rates[NS_COUNTERS];
+  uint64_t last_ts_ns;
+  bool has_data;
+} netstat_state_t;
+
+#if defined(__linux__)
+static size_t line_len(const char *p) {
+  const char *end = strchr(p, '\n');
+  return end ? (size_t)(end - p) : strlen(p);
+}
+
+/* "Tcp: RtoAlgorithm RtoMin ..." followed by "Tcp: 1 200 ...". */
+static void resolve_layout(netstat_state_t *st, netstat_file_t *f) {
+  f->col_count = 0;
+  f->group_count = 0;
+  for (const char *p = f->file.buf; *p && f->group_count < NETSTAT_MAX_GROUPS;) {
+    const char *colon = strchr(p, ':');
+    const size_t len = line_len(p);
+    if (!colon || (size_t)(colon - p) >= len) break;
+    const size_t group_len = (size_t)(colon - p);
+    const uint16_t g = (uint16_t)f->group_count;
+    f->header_len[f->group_count++] = (uint32_t)len;
+
+    const char *q = colon + 1;
+    for (uint16_t column = 0;; column++) {
+      q = sysmon_skip_blanks(q);
+      if (*q == '\n' || *q == '\0') break;
+      const char *field = q;
+      while (*q && *q != ' ' && *q != '\n') q++;
+      const size_t field_len = (size_t)(q - field);
+      for (size_t k = 0; k < NS_COUNTERS; k++) {
+        const netstat_counter_t *c = &netstat_counters[k];
+        if (!st->selected[k] || strlen(c->group) != group_len ||
+            strncmp(c->group, p, group_len) != 0 || strlen(c->field) != field_len ||
+            strncmp(c->field, field, field_len) != 0)
+          continue;
+        f->cols[f->col_count++] = (netstat_column_t){g, column, (uint8_t)k};
+        break;
+      }
+    }
+    p = sysmon_next_line(sysmon_next_line(p));
+  }
+  f->resolved = true;
+}
+
+/* False when a header no longer matches the resolved layout. */
+static bool read_values(netstat_state_t *st, netstat_file_t *f) {
+  const char *p = f->file.buf;
+  size_t next = 0;
+  for (size_t g = 0; g < f->group_count; g++) {
+    if (!*p || line_len(p) != f->header_len[g]) return false;
+    const char *q = strchr(sysmon_next_line(p), ':');
+    if (!q) return false;
+    q++;
+    uint16_t column = 0;
+    for (; next < f->col_count && f->cols[next].group == g; next++) {
+      const netstat_column_t *c = &f->cols[next];
+      for (; column < c->column; column++) {
+        q = sysmon_skip_blanks(q);
+        while (*q && *q != ' ' && *q != '\n') q++;
+      }
+      q = sysmon_skip_blanks(q);
+      uint64_t v = 0;
+      if (*q == '-') q++; /* Tcp MaxConn is -1; never a selected counter */
+      if (!sysmon_parse_u64(&q, &v)) return false;
+      column++;
+      st->values[c->counter] = v;
+    }
+    p = sysmon_next_line(sysmon_next_line(p));
+  }
+  return true;
+}
+#endif
+
+static void netstat_destroy(void *state) {
+  netstat_state_t *st = (netstat_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  sysmon_file_close(&st->files[0].file);
+  sysmon_file_close(&st->files[1].file);
+#endif
+  free(st);
+}
+
+static sysmon_result_t netstat_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                      const char *section, void **out_state, char **out_error) {
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  netstat_state_t *st = (netstat_state_t *)calloc(1, sizeof(*st));
+  if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+  sysmon_file_init(&st->files[0].file);
+  sysmon_file_init(&st->files[1].file);
+
+  const char *list = sysmon_ini_get(ini, section, "counters");
+  if (!list || !*list) list = netstat_default_counters;
+  if (!sysmon_select_names(list, netstat_counters, NS_COUNTERS, sizeof(netstat_counters[0]),
+                           st->selected, "netstat counter", out_error)) {
+    netstat_destroy(st);
+    return SYSMON_ERR_PARSE;
+  }
+
+  static const char *const rel[2] = {"net/snmp", "net/netstat"};
+  char path[SYSMON_PATH_LEN];
+  for (size_t i = 0; i < 2; i++) {
+    sysmon_proc_path(paths, rel[i], path, sizeof(path));
+    sysmon_file_open(&st->files[i].file, path);
+  }
+  if (st->files[0].file.fd < 0) {
+    sysmon_set_path_error(out_error, "cannot open", st->files[0].file.path);
+    netstat_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)paths;
+  (void)ini;
+  (void)section;
+  sysmon_set_error(out_error, "netstat module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static sysmon_result_t netstat_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                    sysmon_snapshot_builder_t *builder, char **out_error) {
+  netstat_state_t *st = (netstat_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+
+#if defined(__linux__)
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
+    for (size_t i = 0; i < 2; i++) {
+      netstat_file_t *f = &st->files[i];
+      if (f->file.fd < 0) continue;
+      if (!sysmon_file_read(&f->file)) {
+        sysmon_set_path_error(out_error, "failed to read", f->file.path);
+        return SYSMON_ERR_IO;
+      }
+      if (!f->resolved || !read_values(st, f)) {
+        resolve_layout(st, f);
+        read_values(st, f);
+      }
+    }
+    const double seconds = st->has_data && now_ns > st->last_ts_ns
+                               ? (double)(now_ns - st->last_ts_ns) / (double)SYSMON_NS_PER_SEC
+                               : 0.0;
+    for (size_t i = 0; i < NS_COUNTERS; i++) {
+      st->rates[i] = seconds > 0.0 && st->values[i] >= st->prev[i]
+                         ? (double)(st->values[i] - st->prev[i]) / seconds
+                         : 0.0;
+      st->prev[i] = st->values[i];
+    }
+    st->last_ts_ns = now_ns;
+    st->has_data = true;
+  }
+
+  char name[96];
+  sysmon_result_t rc;
+  for (size_t i = 0; i < NS_COUNTERS; i++) {
+    if (!st->selected[i]) continue;
+    if (netstat_counters[i].gauge) {
+      snprintf(name, sizeof(name), "netstat.%s", netstat_counters[i].name);
+      rc = sysmon_snapshot_builder_add_u64(builder, name, NULL, st->values[i]);
+    } else {
+      snprintf(name, sizeof(name), "netstat.%s_per_sec", netstat_counters[i].name);
+      rc = sysmon_snapshot_builder_add_double(builder, name, "/s", st->rates[i]);
+    }
+    if (rc != SYSMON_OK) return rc;
+  }
+  if (st->selected[NS_TCP_OUT_SEGS] && st->selected[NS_TCP_RETRANS_SEGS]) {
+    const double out = st->rates[NS_TCP_OUT_SEGS];
+    rc = sysmon_snapshot_builder_add_double(
+        builder, "netstat.tcp_retrans_percent", "%",
+        out > 0.0 ? st->rates[NS_TCP_RETRANS_SEGS] * 100.0 / out : 0.0);
+    if (rc != SYSMON_OK) return rc;
+  }
+  return SYSMON_OK;
+#else
+  (void)now_ns;
+  (void)refresh_now;
+  sysmon_set_error(out_error, "netstat module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_netstat_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "netstat",
+      .create = netstat_create,
+      .poll = netstat_poll,
+      .destroy = netstat_destroy,
+  };
+  return &vtable;
+}
@@ -1,4 +1,5 @@
 #include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -12,17 +13,57 @@
 
 #define SYSMON_IFNAME_LEN 64
 
+typedef struct network_counters {
+  uint64_t rx_bytes;
+  uint64_t rx_packets;
+  uint64_t rx_errors;
+  uint64_t rx_drops;
+  uint64_t tx_bytes;
+  uint64_t tx_packets;
+  uint64_t tx_errors;
+  uint64_t tx_drops;
+} network_counters_t;
+
+typedef struct network_iface {
+  uint64_t key;
+  char name[SYSMON_IFNAME_LEN];
+  uint32_t seen_gen;
+  bool included;
+  bool has_prev;
+  network_counters_t cur;
+  network_counters_t prev;
+  double rx_rate;
+  double tx_rate;
+  double rx_packet_rate;
+  double tx_packet_rate;
+} network_iface_t;
+
 typedef struct network_state {
+  char dev_path[SYSMON_PATH_LEN];
   char ifname[SYSMON_IFNAME_LEN];
   bool include_loopback;
   uint64_t last_rx_bytes;
   uint64_t last_tx_bytes;
-  uint64_t last_ts_ms;
+  uint64_t last_ts_ns;
   double last_rx_rate;
   double last_tx_rate;
   bool has_data;
+
+  /* interface=* or a glob list: every matching interface, keyed by a hash of its name. */
+  char *patterns;
+  network_iface_t *ifaces;
+  size_t iface_count;
+  size_t iface_cap;
+  sysmon_u64map_t by_name;
+  uint32_t gen;
+#if defined(__linux__)
+  sysmon_file_t dev;
+#endif
 } network_state_t;
 
+typedef bool (*network_visit_fn)(network_state_t *st, const char *name, size_t name_len,
+                                 bool loopback, const network_counters_t *c, void *ctx);
+
 static void copy_ifname(char *dst, size_t dst_len, const char *src) {
   if (!dst || dst_len == 0) return;
   if (!src) {
@@ -32,90 +73,324 @@ static void copy_ifname(char *dst, size_t dst_len, const char *src) {
   snprintf(dst, dst_len, "%s", src);
 }
 
-static bool read_interface_bytes(const char *requested, bool include_loopback, uint64_t *out_rx,
-                                 uint64_t *out_tx, char *out_selected, size_t out_selected_len,
-                                 char **out_error) {
-  if (!out_rx || !out_tx) return false;
-  const bool has_request = requested && *requested;
-
+/* Calls visit for each interface until it returns false. */
+static bool for_each_interface(network_state_t *st, network_visit_fn visit, void *ctx,
+                               char **out_error) {
 #if defined(__APPLE__)
   struct ifaddrs *ifap = NULL;
   if (getifaddrs(&ifap) != 0) {
     sysmon_set_error(out_error, "getifaddrs failed");
     return false;
   }
-
-  bool found = false;
   for (struct ifaddrs *ifa = ifap; ifa != NULL; ifa = ifa->ifa_next) {
     if (!ifa->ifa_name || !ifa->ifa_addr) continue;
     if (ifa->ifa_addr->sa_family != AF_LINK) continue;
     if (!(ifa->ifa_flags & IFF_UP)) continue;
-    if (has_request && strcmp(ifa->ifa_name, requested) != 0) continue;
-    if (!include_loopback && !has_request && (ifa->ifa_flags & IFF_LOOPBACK)) continue;
     struct if_data *data = (struct if_data *)ifa->ifa_data;
     if (!data) continue;
-    *out_rx = (uint64_t)data->ifi_ibytes;
-    *out_tx = (uint64_t)data->ifi_obytes;
-    copy_ifname(out_selected, out_selected_len, ifa->ifa_name);
-    found = true;
-    break;
+    network_counters_t c = {0};
+    c.rx_bytes = (uint64_t)data->ifi_ibytes;
+    c.rx_packets = (uint64_t)data->ifi_ipackets;
+    c.rx_errors = (uint64_t)data->ifi_ierrors;
+    c.rx_drops = (uint64_t)data->ifi_iqdrops;
+    c.tx_bytes = (uint64_t)data->ifi_obytes;
+    c.tx_packets = (uint64_t)data->ifi_opackets;
+    c.tx_errors = (uint64_t)data->ifi_oerrors;
+    if (!visit(st, ifa->ifa_name, strlen(ifa->ifa_name), (ifa->ifa_flags & IFF_LOOPBACK) != 0, &c,
+               ctx))
+      break;
   }
-
   freeifaddrs(ifap);
-  if (!found) {
-    sysmon_set_error(out_error, has_request ? "requested interface not found" : "no interface found");
-  }
-  return found;
+  return true;
 
 #elif defined(__linux__)
-  FILE *f = fopen("/proc/net/dev", "r");
-  if (!f) {
-    sysmon_set_error(out_error, "failed to open /proc/net/dev");
+  if (!sysmon_file_read(&st->dev)) {
+    sysmon_set_path_error(out_error, "failed to read", st->dev_path);
     return false;
   }
-  char line[512];
-  int line_no = 0;
-  bool found = false;
-  while (fgets(line, (int)sizeof(line), f)) {
-    line_no++;
-    if (line_no <= 2) continue;
-    char ifname[SYSMON_IFNAME_LEN] = "";
-    unsigned long long rx = 0, tx = 0;
-    int scanned = sscanf(line, " %63[^:]: %llu %*u %*u %*u %*u %*u %*u %*u %llu", ifname, &rx, &tx);
-    if (scanned != 3) continue;
-    if (has_request && strcmp(ifname, requested) != 0) continue;
-    if (!include_loopback && !has_request && strcmp(ifname, "lo") == 0) continue;
-    *out_rx = (uint64_t)rx;
-    *out_tx = (uint64_t)tx;
-    copy_ifname(out_selected, out_selected_len, ifname);
-    found = true;
-    break;
-  }
-  fclose(f);
-
-  if (!found) {
-    sysmon_set_error(out_error, has_request ? "requested interface not found" : "no interface found");
-  }
-  return found;
+  /* "  eth0: rx_bytes packets errs drop fifo frame compressed multicast tx_bytes packets errs
+   * drop fifo colls carrier compressed"; the two header lines have no ':' before a number. */
+  for (const char *p = st->dev.buf; *p; p = sysmon_next_line(p)) {
+    p = sysmon_skip_blanks(p);
+    const char *name = p;
+    while (*p && *p != ':' && *p != '\n') p++;
+    if (*p != ':') continue;
+    const size_t name_len = (size_t)(p - name);
+    p++;
+    uint64_t v[16];
+    size_t n = 0;
+    for (; n < 16; n++) {
+      p = sysmon_skip_blanks(p);
+      if (!sysmon_parse_u64(&p, &v[n])) break;
+    }
+    if (n < 16) continue;
+    const network_counters_t c = {v[0], v[1], v[2], v[3], v[8], v[9], v[10], v[11]};
+    const bool loopback = name_len == 2 && memcmp(name, "lo", 2) == 0;
+    if (!visit(st, name, name_len, loopback, &c, ctx)) break;
+  }
+  return true;
 #else
-  (void)requested;
-  (void)include_loopback;
-  (void)out_selected;
-  (void)out_selected_len;
+  (void)st;
+  (void)visit;
+  (void)ctx;
   sysmon_set_error(out_error, "network module not supported on this platform");
   return false;
 #endif
 }
 
-static sysmon_result_t network_create(const sysmon_ini_t *ini, const char *section,
-                                      void **out_state, char **out_error) {
+typedef struct network_pick {
+  const char *requested;
+  network_counters_t counters;
+  char name[SYSMON_IFNAME_LEN];
+  bool found;
+} network_pick_t;
+
+static bool pick_interface(network_state_t *st, const char *name, size_t name_len, bool loopback,
+                           const network_counters_t *c, void *ctx) {
+  network_pick_t *pick = (network_pick_t *)ctx;
+  const bool has_request = pick->requested && *pick->requested;
+  if (has_request && (strlen(pick->requested) != name_len ||
+                      memcmp(pick->requested, name, name_len) != 0))
+    return true;
+  if (!st->include_loopback && !has_request && loopback) return true;
+  if (name_len >= sizeof(pick->name)) name_len = sizeof(pick->name) - 1;
+  memcpy(pick->name, name, name_len);
+  pick->name[name_len] = '\0';
+  pick->counters = *c;
+  pick->found = true;
+  return false;
+}
+
+static bool read_interface_bytes(network_state_t *st, const char *requested, uint64_t *out_rx,
+                                 uint64_t *out_tx, char *out_selected, size_t out_selected_len,
+                                 char **out_error) {
+  if (!out_rx || !out_tx) return false;
+  network_pick_t pick = {.requested = requested};
+  if (!for_each_interface(st, pick_interface, &pick, out_error)) return false;
+  if (!pick.found) {
+    sysmon_set_error(out_error, requested && *requested ? "requested interface not found"
+                                                        : "no interface found");
+    return false;
+  }
+  *out_rx = pick.counters.rx_bytes;
+  *out_tx = pick.counters.tx_bytes;
+  copy_ifname(out_selected, out_selected_len, pick.name);
+  return true;
+}
+
+#if defined(__linux__) || defined(__APPLE__)
+static uint64_t hash_name(const char *name, size_t len) {
+  uint64_t h = 1469598103934665603ull; /* FNV-1a */
+  for (size_t i = 0; i < len; i++) {
+    h ^= (unsigned char)name[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+/* Probes from the name's hash to the first key not taken by another interface. */
+static uint64_t free_key(const network_state_t *st, const char *name, size_t name_len) {
+  uint64_t key = hash_name(name, name_len);
+  while (sysmon_u64map_get(&st->by_name, key, NULL)) key++;
+  return key;
+}
+
+/* Removing an interface can cut the key++ chain of a later one whose hash collided with it,
+ * so the map is rebuilt from the survivors. Only runs when interfaces went away. */
+static bool rekey_interfaces(network_state_t *st) {
+  sysmon_u64map_clear(&st->by_name);
+  for (size_t i = 0; i < st->iface_count; i++) {
+    network_iface_t *it = &st->ifaces[i];
+    it->key = free_key(st, it->name, strlen(it->name));
+    if (!sysmon_u64map_put(&st->by_name, it->key, (uint32_t)i)) return false;
+  }
+  return true;
+}
+
+static bool update_interface(network_state_t *st, const char *name, size_t name_len, bool loopback,
+                             const network_counters_t *c, void *ctx) {
+  bool *out_of_memory = (bool *)ctx;
+  if (name_len >= SYSMON_IFNAME_LEN) name_len = SYSMON_IFNAME_LEN - 1;
+  uint64_t key = hash_name(name, name_len);
+  uint32_t idx = 0;
+  network_iface_t *it = NULL;
+  /* A name whose hash is already taken by another interface probes on to the next key;
+   * it->key remembers the one it landed on. */
+  while (sysmon_u64map_get(&st->by_name, key, &idx)) {
+    network_iface_t *cand = &st->ifaces[idx];
+    if (strncmp(cand->name, name, name_len) == 0 && cand->name[name_len] == '\0') {
+      it = cand;
+      break;
+    }
+    key++;
+  }
+  if (!it) {
+    if (st->iface_count == st->iface_cap) {
+      const size_t cap = st->iface_cap ? st->iface_cap * 2 : 16;
+      network_iface_t *p = (network_iface_t *)realloc(st->ifaces, cap * sizeof(*p));
+      if (!p) {
+        *out_of_memory = true;
+        return false;
+      }
+      st->ifaces = p;
+      st->iface_cap = cap;
+    }
+    if (!sysmon_u64map_put(&st->by_name, key, (uint32_t)st->iface_count)) {
+      *out_of_memory = true;
+      return false;
+    }
+    it = &st->ifaces[st->iface_count++];
+    memset(it, 0, sizeof(*it));
+    it->key = key;
+    memcpy(it->name, name, name_len);
+    it->name[name_len] = '\0';
+    it->included = (st->include_loopback || !loopback) &&
+                   sysmon_glob_list_match(st->patterns, it->name, 0);
+  }
+  it->seen_gen = st->gen;
+  if (it->included) it->cur = *c;
+  return true;
+}
+
+static double counter_rate(uint64_t cur, uint64_t prev, double seconds) {
+  return cur >= prev ? (double)(cur - prev) / seconds : 0.0;
+}
+
+static bool refresh_interfaces(network_state_t *st, uint64_t now_ns, char **out_error) {
+  st->gen++;
+  bool out_of_memory = false;
+  if (!for_each_interface(st, update_interface, &out_of_memory, out_error)) return false;
+  if (out_of_memory) {
+    sysmon_set_error(out_error, "out of memory tracking interfaces");
+    return false;
+  }
+
+  const double seconds = st->has_data && now_ns > st->last_ts_ns
+                             ? (double)(now_ns - st->last_ts_ns) / (double)SYSMON_NS_PER_SEC
+                             : 0.0;
+  bool removed = false;
+  for (size_t i = 0; i < st->iface_count;) {
+    network_iface_t *it = &st->ifaces[i];
+    if (it->seen_gen != st->gen) {
+      if (i + 1 != st->iface_count) st->ifaces[i] = st->ifaces[st->iface_count - 1];
+      st->iface_count--;
+      removed = true;
+      continue;
+    }
+    if (it->included) {
+      if (it->has_prev && seconds > 0.0) {
+        it->rx_rate = counter_rate(it->cur.rx_bytes, it->prev.rx_bytes, seconds);
+        it->tx_rate = counter_rate(it->cur.tx_bytes, it->prev.tx_bytes, seconds);
+        it->rx_packet_rate = counter_rate(it->cur.rx_packets, it->prev.rx_packets, seconds);
+        it->tx_packet_rate = counter_rate(it->cur.tx_packets, it->prev.tx_packets, seconds);
+      }
+      it->prev = it->cur;
+      it->has_prev = true;
+    }
+    i++;
+  }
+  if (removed && !rekey_interfaces(st)) {
+    sysmon_set_error(out_error, "out of memory tracking interfaces");
+    return false;
+  }
+  st->last_ts_ns = now_ns;
+  st->has_data = true;
+  return true;
+}
+
+static sysmon_result_t add_interface_metrics(sysmon_snapshot_builder_t *builder,
+                                             const network_iface_t *it) {
+  char name[96];
+#define NET_ADD(kind, metric, unit, value)                                                  \
+  do {                                                                                      \
+    snprintf(name, sizeof(name), "network.%s.%s", it->name, metric);                        \
+    sysmon_result_t rc_ = sysmon_snapshot_builder_add_##kind(builder, name, unit, (value)); \
+    if (rc_ != SYSMON_OK) return rc_;                                                       \
+  } while (0)
+
+  NET_ADD(u64, "rx_bytes", "B", it->cur.rx_bytes);
+  NET_ADD(u64, "tx_bytes", "B", it->cur.tx_bytes);
+  NET_ADD(double, "rx_bytes_per_sec", "B/s", it->rx_rate);
+  NET_ADD(double, "tx_bytes_per_sec", "B/s", it->tx_rate);
+  NET_ADD(double, "rx_packets_per_sec", "pkt/s", it->rx_packet_rate);
+  NET_ADD(double, "tx_packets_per_sec", "pkt/s", it->tx_packet_rate);
+  NET_ADD(u64, "rx_errors", NULL, it->cur.rx_errors);
+  NET_ADD(u64, "tx_errors", NULL, it->cur.tx_errors);
+  NET_ADD(u64, "rx_drops", NULL, it->cur.rx_drops);
+  NET_ADD(u64, "tx_drops", NULL, it->cur.tx_drops);
+#undef NET_ADD
+  return SYSMON_OK;
+}
+
+static sysmon_result_t poll_interfaces(network_state_t *st, uint64_t now_ns, bool refresh_now,
+                                       sysmon_snapshot_builder_t *builder, char **out_error) {
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data) &&
+      !refresh_interfaces(st, now_ns, out_error))
+    return SYSMON_ERR_IO;
+
+  uint64_t count = 0;
+  double rx_rate = 0.0, tx_rate = 0.0;
+  for (size_t i = 0; i < st->iface_count; i++) {
+    const network_iface_t *it = &st->ifaces[i];
+    if (!it->included) continue;
+    sysmon_result_t rc = add_interface_metrics(builder, it);
+    if (rc != SYSMON_OK) return rc;
+    count++;
+    rx_rate += it->rx_rate;
+    tx_rate += it->tx_rate;
+  }
+  sysmon_result_t rc = sysmon_snapshot_builder_add_u64(builder, "network.interface_count", NULL, count);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "network.rx_bytes_per_sec", "B/s", rx_rate);
+  if (rc != SYSMON_OK) return rc;
+  return sysmon_snapshot_builder_add_double(builder, "network.tx_bytes_per_sec", "B/s", tx_rate);
+}
+
+static bool is_pattern(const char *iface) { return strpbrk(iface, "*?[,") != NULL; }
+#endif
+
+static void network_destroy(void *state) {
+  network_state_t *st = (network_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  sysmon_file_close(&st->dev);
+#endif
+  sysmon_u64map_destroy(&st->by_name);
+  free(st->ifaces);
+  free(st->patterns);
+  free(st);
+}
+
+static sysmon_result_t network_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                      const char *section, void **out_state, char **out_error) {
   if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
   network_state_t *st = (network_state_t *)calloc(1, sizeof(*st));
   if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
 
+  sysmon_proc_path(paths, "net/dev", st->dev_path, sizeof(st->dev_path));
+#if defined(__linux__)
+  sysmon_file_init(&st->dev);
+  if (!sysmon_file_open(&st->dev, st->dev_path)) {
+    sysmon_set_path_error(out_error, "failed to open", st->dev_path);
+    network_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+#endif
+
   st->include_loopback = sysmon_ini_get_bool(ini, section, "include_loopback", false);
 
   const char *iface = sysmon_ini_get(ini, section, "interface");
+#if defined(__linux__) || defined(__APPLE__)
+  if (iface && is_pattern(iface)) {
+    st->patterns = sysmon_strdup(iface);
+    if (!st->patterns || !sysmon_u64map_init(&st->by_name, 64)) {
+      network_destroy(st);
+      return SYSMON_ERR_OUT_OF_MEMORY;
+    }
+    *out_state = st;
+    return SYSMON_OK;
+  }
+#endif
   if (iface && *iface) {
     copy_ifname(st->ifname, sizeof(st->ifname), iface);
   } else {
@@ -125,11 +400,11 @@ static sysmon_result_t network_create(const sysmon_ini_t *ini, const char *secti
   char *err = NULL;
   uint64_t rx = 0, tx = 0;
   char selected[SYSMON_IFNAME_LEN] = "";
-  if (!read_interface_bytes(st->ifname[0] ? st->ifname : NULL, st->include_loopback, &rx, &tx,
-                            selected, sizeof(selected), &err)) {
+  if (!read_interface_bytes(st, st->ifname[0] ? st->ifname : NULL, &rx, &tx, selected,
+                            sizeof(selected), &err)) {
     sysmon_set_error(out_error, err ? err : "network interface not available");
     free(err);
-    free(st);
+    network_destroy(st);
     return SYSMON_ERR_NOT_SUPPORTED;
   }
   free(err);
@@ -138,7 +413,7 @@ static sysmon_result_t network_create(const sysmon_ini_t *ini, const char *secti
 
   st->last_rx_bytes = 0;
   st->last_tx_bytes = 0;
-  st->last_ts_ms = 0;
+  st->last_ts_ns = 0;
   st->last_rx_rate = 0.0;
   st->last_tx_rate = 0.0;
   st->has_data = false;
@@ -147,23 +422,26 @@ static sysmon_result_t network_create(const sysmon_ini_t *ini, const char *secti
   return SYSMON_OK;
 }
 
-static sysmon_result_t network_poll(void *state, uint64_t now_ms, bool refresh_now,
+static sysmon_result_t network_poll(void *state, uint64_t now_ns, bool refresh_now,
                                     sysmon_snapshot_builder_t *builder, char **out_error) {
   network_state_t *st = (network_state_t *)state;
   if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__) || defined(__APPLE__)
+  if (st->patterns) return poll_interfaces(st, now_ns, refresh_now, builder, out_error);
+#endif
 
-  if (refresh_now || !st->has_data) {
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
     uint64_t rx = 0, tx = 0;
     char *err = NULL;
-    if (!read_interface_bytes(st->ifname, st->include_loopback, &rx, &tx, NULL, 0, &err)) {
+    if (!read_interface_bytes(st, st->ifname, &rx, &tx, NULL, 0, &err)) {
       sysmon_set_error(out_error, err ? err : "failed to read network counters");
       free(err);
       return SYSMON_ERR_IO;
     }
     free(err);
 
-    if (st->has_data && st->last_ts_ms > 0 && now_ms > st->last_ts_ms) {
-      const double seconds = (double)(now_ms - st->last_ts_ms) / 1000.0;
+    if (st->has_data && st->last_ts_ns > 0 && now_ns > st->last_ts_ns) {
+      const double seconds = (double)(now_ns - st->last_ts_ns) / (double)SYSMON_NS_PER_SEC;
       const uint64_t rx_delta = rx >= st->last_rx_bytes ? (rx - st->last_rx_bytes) : 0;
       const uint64_t tx_delta = tx >= st->last_tx_bytes ? (tx - st->last_tx_bytes) : 0;
       st->last_rx_rate = seconds > 0.0 ? (double)rx_delta / seconds : 0.0;
@@ -175,7 +453,7 @@ static sysmon_result_t network_poll(void *state, uint64_t now_ms, bool refresh_n
 
     st->last_rx_bytes = rx;
     st->last_tx_bytes = tx;
-    st->last_ts_ms = now_ms;
+    st->last_ts_ns = now_ns;
     st->has_data = true;
   }
 
@@ -192,8 +470,6 @@ static sysmon_result_t network_poll(void *state, uint64_t now_ms, bool refresh_n
   return SYSMON_OK;
 }
 
-static void network_destroy(void *state) { free(state); }
-
 const sysmon_module_vtable_t *sysmon_network_module(void) {
   static const sysmon_module_vtable_t vtable = {
       .name = "network", .create = network_create, .poll = network_poll, .destroy = network_destroy};
@@ -0,0 +1,244 @@
+#include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SYSMON_NUMA_MAX_NODES 64
+
+enum { NUMA_HIT, NUMA_MISS, NUMA_FOREIGN, NUMA_INTERLEAVE, NUMA_LOCAL, NUMA_OTHER, NUMA_STATS };
+
+static const char *const numa_stat_keys[NUMA_STATS] = {
+    "numa_hit", "numa_miss", "numa_foreign", "interleave_hit", "local_node", "other_node"};
+
+typedef struct numa_node {
+  int id;
+  sysmon_file_t meminfo;
+  sysmon_file_t numastat;
+  uint64_t total_bytes;
+  uint64_t free_bytes;
+  uint64_t file_bytes;
+  uint64_t anon_bytes;
+  uint64_t stats[NUMA_STATS];
+  uint64_t prev[NUMA_STATS];
+  double rates[NUMA_STATS]; /* pages per second */
+} numa_node_t;
+
+typedef struct numa_state {
+  numa_node_t nodes[SYSMON_NUMA_MAX_NODES];
+  size_t count;
+  uint64_t last_ts_ns;
+  bool has_data;
+} numa_state_t;
+
+#if defined(__linux__)
+/* "Node 0 MemTotal:        4423416 kB" */
+static bool parse_node_meminfo(numa_node_t *n, const char *p) {
+  bool have_total = false;
+  while (*p) {
+    if (strncmp(p, "Node ", 5) == 0) {
+      p += 5;
+      while (*p >= '0' && *p <= '9') p++;
+      p = sysmon_skip_blanks(p);
+    }
+    uint64_t *dst = NULL;
+    if (strncmp(p, "MemTotal:", 9) == 0) {
+      dst = &n->total_bytes;
+      have_total = true;
+    } else if (strncmp(p, "MemFree:", 8) == 0) {
+      dst = &n->free_bytes;
+    } else if (strncmp(p, "FilePages:", 10) == 0) {
+      dst = &n->file_bytes;
+    } else if (strncmp(p, "AnonPages:", 10) == 0) {
+      dst = &n->anon_bytes;
+    }
+    if (dst) {
+      const char *v = strchr(p, ':') + 1;
+      uint64_t kb = 0;
+      if (sysmon_parse_u64(&v, &kb)) *dst = kb * 1024u;
+    }
+    p = sysmon_next_line(p);
+  }
+  return have_total;
+}
+
+static void parse_numastat(numa_node_t *n, const char *p) {
+  while (*p) {
+    for (size_t i = 0; i < NUMA_STATS; i++) {
+      const size_t len = strlen(numa_stat_keys[i]);
+      if (strncmp(p, numa_stat_keys[i], len) == 0 && p[len] == ' ') {
+        const char *v = p + len;
+        sysmon_parse_u64(&v, &n->stats[i]);
+        break;
+      }
+    }
+    p = sysmon_next_line(p);
+  }
+}
+#endif
+
+static void numa_destroy(void *state) {
+  numa_state_t *st = (numa_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  for (size_t i = 0; i < st->count; i++) {
+    sysmon_file_close(&st->nodes[i].meminfo);
+    sysmon_file_close(&st->nodes[i].numastat);
+  }
+#endif
+  free(st);
+}
+
+static sysmon_result_t numa_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                   const char *section, void **out_state, char **out_error) {
+  (void)ini;
+  (void)section;
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  char path[SYSMON_PATH_LEN];
+  sysmon_sys_path(paths, "devices/system/node/online", path, sizeof(path));
+  int *ids = NULL;
+  size_t n = 0;
+  if (!sysmon_read_id_list(path, &ids, &n) || n == 0) {
+    free(ids);
+    sysmon_set_error(out_error, "no NUMA node information in sysfs");
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+
+  numa_state_t *st = (numa_state_t *)calloc(1, sizeof(*st));
+  if (!st) {
+    free(ids);
+    return SYSMON_ERR_OUT_OF_MEMORY;
+  }
+  for (size_t i = 0; i < n && st->count < SYSMON_NUMA_MAX_NODES; i++) {
+    numa_node_t *node = &st->nodes[st->count];
+    node->id = ids[i];
+    sysmon_file_init(&node->meminfo);
+    sysmon_file_init(&node->numastat);
+    char rel[64];
+    snprintf(rel, sizeof(rel), "devices/system/node/node%d/meminfo", ids[i]);
+    sysmon_sys_path(paths, rel, path, sizeof(path));
+    if (!sysmon_file_open(&node->meminfo, path)) continue; /* memoryless or gone */
+    snprintf(rel, sizeof(rel), "devices/system/node/node%d/numastat", ids[i]);
+    sysmon_sys_path(paths, rel, path, sizeof(path));
+    sysmon_file_open(&node->numastat, path);
+    st->count++;
+  }
+  free(ids);
+  if (st->count == 0) {
+    numa_destroy(st);
+    sysmon_set_error(out_error, "no readable NUMA node meminfo");
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)paths;
+  sysmon_set_error(out_error, "numa module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static sysmon_result_t numa_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                 sysmon_snapshot_builder_t *builder, char **out_error) {
+  numa_state_t *st = (numa_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+
+#if defined(__linux__)
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
+    const double seconds = st->has_data && now_ns > st->last_ts_ns
+                               ? (double)(now_ns - st->last_ts_ns) / (double)SYSMON_NS_PER_SEC
+                               : 0.0;
+    for (size_t i = 0; i < st->count; i++) {
+      numa_node_t *n = &st->nodes[i];
+      if (!sysmon_file_read(&n->meminfo) || !parse_node_meminfo(n, n->meminfo.buf)) {
+        char buf[96];
+        snprintf(buf, sizeof(buf), "failed to read node%d meminfo", n->id);
+        sysmon_set_error(out_error, buf);
+        return SYSMON_ERR_IO;
+      }
+      if (n->numastat.fd >= 0 && sysmon_file_read(&n->numastat)) parse_numastat(n, n->numastat.buf);
+      for (size_t s = 0; s < NUMA_STATS; s++) {
+        n->rates[s] = seconds > 0.0 && n->stats[s] >= n->prev[s]
+                          ? (double)(n->stats[s] - n->prev[s]) / seconds
+                          : 0.0;
+        n->prev[s] = n->stats[s];
+      }
+    }
+    st->last_ts_ns = now_ns;
+    st->has_data = true;
+  }
+
+  char name[96];
+  sysmon_result_t rc;
+#define NUMA_ADD(kind, id, metric, unit, value)                            \
+  do {                                                                     \
+    snprintf(name, sizeof(name), "numa.node.%d.%s", id, metric);           \
+    rc = sysmon_snapshot_builder_add_##kind(builder, name, unit, value);   \
+    if (rc != SYSMON_OK) return rc;                                        \
+  } while (0)
+
+  double miss = 0.0, other = 0.0, local = 0.0, min_free = 101.0;
+  int min_node = -1;
+  for (size_t i = 0; i < st->count; i++) {
+    const numa_node_t *n = &st->nodes[i];
+    const uint64_t free_bytes = n->free_bytes < n->total_bytes ? n->free_bytes : n->total_bytes;
+    const double free_pct =
+        n->total_bytes ? (double)free_bytes * 100.0 / (double)n->total_bytes : 0.0;
+    const double node_other = n->rates[NUMA_OTHER], node_local = n->rates[NUMA_LOCAL];
+    if (n->total_bytes && free_pct < min_free) {
+      min_free = free_pct;
+      min_node = n->id;
+    }
+    miss += n->rates[NUMA_MISS];
+    other += node_other;
+    local += node_local;
+
+    NUMA_ADD(u64, n->id, "total_bytes", "B", n->total_bytes);
+    NUMA_ADD(u64, n->id, "free_bytes", "B", free_bytes);
+    NUMA_ADD(u64, n->id, "used_bytes", "B", n->total_bytes - free_bytes);
+    NUMA_ADD(double, n->id, "used_percent", "%", n->total_bytes ? 100.0 - free_pct : 0.0);
+    NUMA_ADD(u64, n->id, "file_bytes", "B", n->file_bytes);
+    NUMA_ADD(u64, n->id, "anon_bytes", "B", n->anon_bytes);
+    if (n->numastat.fd < 0) continue;
+    NUMA_ADD(double, n->id, "numa_hit_per_sec", "pages/s", n->rates[NUMA_HIT]);
+    NUMA_ADD(double, n->id, "numa_miss_per_sec", "pages/s", n->rates[NUMA_MISS]);
+    NUMA_ADD(double, n->id, "numa_foreign_per_sec", "pages/s", n->rates[NUMA_FOREIGN]);
+    NUMA_ADD(double, n->id, "local_node_per_sec", "pages/s", node_local);
+    NUMA_ADD(double, n->id, "other_node_per_sec", "pages/s", node_other);
+    NUMA_ADD(double, n->id, "remote_percent", "%",
+             node_local + node_other > 0.0 ? node_other * 100.0 / (node_local + node_other) : 0.0);
+  }
+#undef NUMA_ADD
+
+  rc = sysmon_snapshot_builder_add_u64(builder, "numa.node_count", NULL, st->count);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "numa.numa_miss_per_sec", "pages/s", miss);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "numa.other_node_per_sec", "pages/s", other);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "numa.remote_percent", "%",
+                                          local + other > 0.0 ? other * 100.0 / (local + other) : 0.0);
+  if (rc != SYSMON_OK) return rc;
+  if (min_node < 0) return SYSMON_OK;
+  rc = sysmon_snapshot_builder_add_double(builder, "numa.min_free_percent", "%", min_free);
+  if (rc != SYSMON_OK) return rc;
+  return sysmon_snapshot_builder_add_i64(builder, "numa.min_free_node", NULL, min_node);
+#else
+  (void)now_ns;
+  (void)refresh_now;
+  sysmon_set_error(out_error, "numa module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_numa_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "numa",
+      .create = numa_create,
+      .poll = numa_poll,
+      .destroy = numa_destroy,
+  };
+  return &vtable;
+}
@@ -0,0 +1,339 @@
+#include "../sysmon_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define PERF_MAX_GROUP 4
+
+enum { PERF_CYCLES, PERF_INSTRUCTIONS, PERF_CACHE_REFS, PERF_CACHE_MISSES, PERF_HW_EVENTS };
+enum { PERF_CONTEXT_SWITCHES, PERF_PAGE_FAULTS, PERF_CPU_MIGRATIONS, PERF_SW_EVENTS };
+
+typedef struct perf_group {
+  int fds[PERF_MAX_GROUP];
+  uint8_t slot[PERF_MAX_GROUP]; /* read order -> event index */
+  size_t count;
+  uint64_t prev[PERF_MAX_GROUP];
+  uint64_t prev_enabled;
+  uint64_t prev_running;
+  double delta[PERF_MAX_GROUP]; /* by event index, scaled for multiplexing */
+  double running_ratio;
+  bool has_prev;
+} perf_group_t;
+
+typedef struct perf_cpu {
+  int cpu;
+  perf_group_t hw;
+  perf_group_t sw;
+} perf_cpu_t;
+
+typedef struct perf_state {
+  perf_cpu_t *cpus;
+  size_t cpu_count;
+  int cgroup_fd;
+  bool hardware;
+  bool has_cache;
+  bool per_cpu;
+  double seconds;
+  uint64_t last_ts_ns;
+  bool has_data;
+} perf_state_t;
+
+#if defined(__linux__)
+static void group_init(perf_group_t *g) {
+  memset(g, 0, sizeof(*g));
+  for (size_t i = 0; i < PERF_MAX_GROUP; i++) g->fds[i] = -1;
+}
+
+static void group_close(perf_group_t *g) {
+  for (size_t i = 0; i < g->count; i++) {
+    if (g->fds[i] >= 0) close(g->fds[i]);
+    g->fds[i] = -1;
+  }
+  g->count = 0;
+}
+
+/* Opens the events as one group on cpu; members the PMU lacks are skipped. Returns errno of the leader. */
+static int group_open(perf_group_t *g, uint32_t type, const uint64_t *configs, size_t n, int cpu,
+                      int cgroup_fd) {
+  const unsigned long flags = PERF_FLAG_FD_CLOEXEC | (cgroup_fd >= 0 ? PERF_FLAG_PID_CGROUP : 0);
+  for (size_t i = 0; i < n; i++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = configs[i];
+    attr.read_format =
+        PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    const int leader = g->count > 0 ? g->fds[0] : -1;
+    const int fd = (int)syscall(SYS_perf_event_open, &attr, cgroup_fd, cpu, leader, flags);
+    if (fd < 0) {
+      if (g->count == 0) return errno;
+      continue;
+    }
+    g->fds[g->count] = fd;
+    g->slot[g->count] = (uint8_t)i;
+    g->count++;
+  }
+  return 0;
+}
+
+static bool group_read(perf_group_t *g) {
+  uint64_t buf[3 + PERF_MAX_GROUP];
+  memset(g->delta, 0, sizeof(g->delta));
+  g->running_ratio = 0.0;
+  if (g->count == 0) return true;
+  const ssize_t n = read(g->fds[0], buf, sizeof(buf));
+  if (n < (ssize_t)(3 * sizeof(uint64_t)) || buf[0] != g->count) return false;
+
+  const uint64_t enabled = buf[1], running = buf[2];
+  if (g->has_prev && running > g->prev_running && enabled >= g->prev_enabled) {
+    const double d_enabled = (double)(enabled - g->prev_enabled);
+    const double d_running = (double)(running - g->prev_running);
+    const double scale = d_enabled / d_running;
+    g->running_ratio = d_enabled > 0.0 ? d_running / d_enabled : 0.0;
+    for (size_t i = 0; i < g->count; i++) {
+      const uint64_t v = buf[3 + i];
+      g->delta[g->slot[i]] = v >= g->prev[i] ? (double)(v - g->prev[i]) * scale : 0.0;
+    }
+  }
+  for (size_t i = 0; i < g->count; i++) g->prev[i] = buf[3 + i];
+  g->prev_enabled = enabled;
+  g->prev_running = running;
+  g->has_prev = true;
+  return true;
+}
+
+static bool online_cpus(const sysmon_paths_t *paths, int **out, size_t *out_count) {
+  char path[SYSMON_PATH_LEN];
+  sysmon_sys_path(paths, "devices/system/cpu/online", path, sizeof(path));
+  if (sysmon_read_id_list(path, out, out_count)) {
+    if (*out_count > 0) return true;
+    free(*out);
+  }
+
+  const long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n <= 0) return false;
+  int *cpus = (int *)malloc((size_t)n * sizeof(*cpus));
+  if (!cpus) return false;
+  for (long i = 0; i < n; i++) cpus[i] = (int)i;
+  *out = cpus;
+  *out_count = (size_t)n;
+  return true;
+}
+
+static const char *open_error(int err) {
+  if (err == EACCES || err == EPERM)
+    return "perf_event_open denied (needs CAP_PERFMON or kernel.perf_event_paranoid <= 0)";
+  return "perf_event_open not available";
+}
+#endif
+
+static void perf_destroy(void *state) {
+  perf_state_t *st = (perf_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  for (size_t i = 0; i < st->cpu_count; i++) {
+    group_close(&st->cpus[i].hw);
+    group_close(&st->cpus[i].sw);
+  }
+  if (st->cgroup_fd >= 0) close(st->cgroup_fd);
+#endif
+  free(st->cpus);
+  free(st);
+}
+
+static sysmon_result_t perf_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                   const char *section, void **out_state, char **out_error) {
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  perf_state_t *st = (perf_state_t *)calloc(1, sizeof(*st));
+  if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+  st->cgroup_fd = -1;
+  st->per_cpu = sysmon_ini_get_bool(ini, section, "per_cpu", false);
+  const bool want_hw = sysmon_ini_get_bool(ini, section, "hardware", true);
+
+  const char *cgroup = sysmon_ini_get(ini, section, "cgroup");
+  if (cgroup && *cgroup) {
+    char rel[SYSMON_PATH_LEN];
+    char path[SYSMON_PATH_LEN];
+    snprintf(rel, sizeof(rel), "fs/cgroup/%s", cgroup[0] == '/' ? cgroup + 1 : cgroup);
+    sysmon_sys_path(paths, rel, path, sizeof(path));
+    st->cgroup_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (st->cgroup_fd < 0) {
+      char buf[SYSMON_PATH_LEN + 32];
+      snprintf(buf, sizeof(buf), "cannot open cgroup %s", path);
+      sysmon_set_error(out_error, buf);
+      perf_destroy(st);
+      return SYSMON_ERR_IO;
+    }
+  }
+
+  int *cpus = NULL;
+  size_t ncpu = 0;
+  if (!online_cpus(paths, &cpus, &ncpu)) {
+    sysmon_set_error(out_error, "failed to list online CPUs");
+    perf_destroy(st);
+    return SYSMON_ERR_IO;
+  }
+  st->cpus = (perf_cpu_t *)calloc(ncpu, sizeof(*st->cpus));
+  if (!st->cpus) {
+    free(cpus);
+    perf_destroy(st);
+    return SYSMON_ERR_OUT_OF_MEMORY;
+  }
+
+  static const uint64_t hw_events[PERF_HW_EVENTS] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_REFERENCES,
+      PERF_COUNT_HW_CACHE_MISSES};
+  static const uint64_t sw_events[PERF_SW_EVENTS] = {
+      PERF_COUNT_SW_CONTEXT_SWITCHES, PERF_COUNT_SW_PAGE_FAULTS, PERF_COUNT_SW_CPU_MIGRATIONS};
+
+  /* Hardware is all-or-nothing across CPUs: the first CPU without a PMU drops to software only. */
+  st->hardware = want_hw;
+  for (size_t i = 0; i < ncpu; i++) {
+    perf_cpu_t *c = &st->cpus[st->cpu_count];
+    c->cpu = cpus[i];
+    group_init(&c->hw);
+    group_init(&c->sw);
+    const int err = group_open(&c->sw, PERF_TYPE_SOFTWARE, sw_events, PERF_SW_EVENTS, c->cpu,
+                               st->cgroup_fd);
+    if (err == ENODEV) continue; /* went offline since the list was read */
+    if (err != 0) {
+      free(cpus);
+      sysmon_set_error(out_error, open_error(err));
+      perf_destroy(st);
+      return err == ENOENT || err == ENOSYS || err == EACCES || err == EPERM
+                 ? SYSMON_ERR_NOT_SUPPORTED
+                 : SYSMON_ERR_IO;
+    }
+    st->cpu_count++;
+    if (st->hardware && group_open(&c->hw, PERF_TYPE_HARDWARE, hw_events, PERF_HW_EVENTS, c->cpu,
+                                   st->cgroup_fd) != 0)
+      st->hardware = false;
+  }
+  free(cpus);
+
+  st->has_cache = st->hardware;
+  for (size_t i = 0; i < st->cpu_count; i++) {
+    perf_group_t *hw = &st->cpus[i].hw;
+    if (!st->hardware) {
+      group_close(hw);
+      continue;
+    }
+    unsigned mask = 0;
+    for (size_t e = 0; e < hw->count; e++) mask |= 1u << hw->slot[e];
+    if (!(mask & (1u << PERF_CACHE_REFS)) || !(mask & (1u << PERF_CACHE_MISSES)))
+      st->has_cache = false;
+  }
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)paths;
+  (void)ini;
+  (void)section;
+  sysmon_set_error(out_error, "perf module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+#if defined(__linux__)
+static sysmon_result_t add_rates(perf_state_t *st, sysmon_snapshot_builder_t *builder,
+                                 const char *prefix, const double *hw, const double *sw,
+                                 double hw_running) {
+  const double s = st->seconds > 0.0 ? st->seconds : 0.0;
+  char name[96];
+  sysmon_result_t rc;
+#define PERF_ADD(metric, unit, value)                                             \
+  do {                                                                            \
+    snprintf(name, sizeof(name), "%s.%s", prefix, metric);                        \
+    rc = sysmon_snapshot_builder_add_double(builder, name, unit, value);          \
+    if (rc != SYSMON_OK) return rc;                                               \
+  } while (0)
+
+  if (st->hardware) {
+    PERF_ADD("cycles_per_sec", "/s", s > 0.0 ? hw[PERF_CYCLES] / s : 0.0);
+    PERF_ADD("instructions_per_sec", "/s", s > 0.0 ? hw[PERF_INSTRUCTIONS] / s : 0.0);
+    PERF_ADD("ipc", NULL, hw[PERF_CYCLES] > 0.0 ? hw[PERF_INSTRUCTIONS] / hw[PERF_CYCLES] : 0.0);
+    if (st->has_cache) {
+      PERF_ADD("cache_misses_per_sec", "/s", s > 0.0 ? hw[PERF_CACHE_MISSES] / s : 0.0);
+      PERF_ADD("cache_miss_percent", "%",
+               hw[PERF_CACHE_REFS] > 0.0 ? hw[PERF_CACHE_MISSES] * 100.0 / hw[PERF_CACHE_REFS]
+                                         : 0.0);
+    }
+    PERF_ADD("hw_running_percent", "%", hw_running * 100.0);
+  }
+  PERF_ADD("context_switches_per_sec", "/s", s > 0.0 ? sw[PERF_CONTEXT_SWITCHES] / s : 0.0);
+  PERF_ADD("page_faults_per_sec", "/s", s > 0.0 ? sw[PERF_PAGE_FAULTS] / s : 0.0);
+  PERF_ADD("cpu_migrations_per_sec", "/s", s > 0.0 ? sw[PERF_CPU_MIGRATIONS] / s : 0.0);
+#undef PERF_ADD
+  return SYSMON_OK;
+}
+#endif
+
+static sysmon_result_t perf_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                 sysmon_snapshot_builder_t *builder, char **out_error) {
+  perf_state_t *st = (perf_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+
+#if defined(__linux__)
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
+    for (size_t i = 0; i < st->cpu_count; i++) {
+      if (!group_read(&st->cpus[i].hw) || !group_read(&st->cpus[i].sw)) {
+        sysmon_set_error(out_error, "failed to read perf counters");
+        return SYSMON_ERR_IO;
+      }
+    }
+    st->seconds = st->has_data && now_ns > st->last_ts_ns
+                      ? (double)(now_ns - st->last_ts_ns) / (double)SYSMON_NS_PER_SEC
+                      : 0.0;
+    st->last_ts_ns = now_ns;
+    st->has_data = true;
+  }
+
+  double hw[PERF_HW_EVENTS] = {0}, sw[PERF_SW_EVENTS] = {0}, running = 0.0;
+  for (size_t i = 0; i < st->cpu_count; i++) {
+    const perf_cpu_t *c = &st->cpus[i];
+    for (size_t e = 0; e < PERF_HW_EVENTS; e++) hw[e] += c->hw.delta[e];
+    for (size_t e = 0; e < PERF_SW_EVENTS; e++) sw[e] += c->sw.delta[e];
+    running += c->hw.running_ratio;
+  }
+  sysmon_result_t rc = sysmon_snapshot_builder_add_u64(builder, "perf.hardware", NULL, st->hardware);
+  if (rc != SYSMON_OK) return rc;
+  rc = add_rates(st, builder, "perf", hw, sw, st->cpu_count ? running / (double)st->cpu_count : 0.0);
+  if (rc != SYSMON_OK || !st->per_cpu) return rc;
+
+  for (size_t i = 0; i < st->cpu_count; i++) {
+    const perf_cpu_t *c = &st->cpus[i];
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "perf.cpu.%d", c->cpu);
+    rc = add_rates(st, builder, prefix, c->hw.delta, c->sw.delta, c->hw.running_ratio);
+    if (rc != SYSMON_OK) return rc;
+  }
+  return SYSMON_OK;
+#else
+  (void)now_ns;
+  (void)refresh_now;
+  sysmon_set_error(out_error, "perf module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_perf_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "perf",
+      .create = perf_create,
+      .poll = perf_poll,
+      .destroy = perf_destroy,
+      .opt_in = true,
+  };
+  return &vtable;
+}
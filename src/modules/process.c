@@ -0,0 +1,490 @@
+#include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define PROCESS_MAX_TOP_N 64
+#define PROCESS_COMM_LEN 16
+#define PROCESS_GETDENTS_BUF (64 * 1024)
+#define PROCESS_MAX_THREADS 16
+/* Below this many PIDs per worker, thread start-up costs more than it saves. */
+#define PROCESS_PIDS_PER_THREAD 4096
+
+typedef struct process_entry {
+  uint32_t pid;
+  uint32_t seen_gen;
+  int stat_fd;
+  int io_fd;
+  bool cache_fds;
+  bool fd_starved;
+  bool io_blocked;
+  bool alive;
+  bool has_prev;
+  char state;
+  char comm[PROCESS_COMM_LEN + 1];
+  uint64_t cpu_ticks;
+  uint64_t prev_cpu_ticks;
+  uint64_t io_bytes;
+  uint64_t prev_io_bytes;
+  uint64_t rss_pages;
+  uint64_t threads;
+} process_entry_t;
+
+typedef struct process_rank {
+  uint32_t pid;
+  char comm[PROCESS_COMM_LEN + 1];
+  double value;
+} process_rank_t;
+
+typedef struct process_state {
+  int proc_fd;
+  char *dents;
+  process_entry_t *entries;
+  size_t count;
+  size_t cap;
+  sysmon_u64map_t by_pid;
+  uint32_t gen;
+  size_t open_fds;
+  size_t fd_budget;
+  size_t max_threads;
+  size_t top_n;
+  bool io;
+  double ticks_per_sec;
+  uint64_t page_size;
+  uint64_t last_ns;
+  bool has_data;
+
+  sysmon_topk_t heap;
+  process_rank_t top_cpu[PROCESS_MAX_TOP_N];
+  process_rank_t top_rss[PROCESS_MAX_TOP_N];
+  process_rank_t top_io[PROCESS_MAX_TOP_N];
+  size_t top_cpu_count;
+  size_t top_rss_count;
+  size_t top_io_count;
+  uint64_t total_threads;
+  uint64_t running;
+} process_state_t;
+
+#if defined(__linux__)
+struct process_dirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+
+typedef struct process_shard {
+  process_state_t *st;
+  size_t begin;
+  size_t end;
+} process_shard_t;
+
+static ssize_t read_at(int fd, char *buf, size_t cap) {
+  for (;;) {
+    const ssize_t n = pread(fd, buf, cap - SYSMON_PARSE_PADDING - 1, 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n >= 0) memset(buf + n, 0, SYSMON_PARSE_PADDING + 1);
+    return n;
+  }
+}
+
+static int open_pid_file(int proc_fd, uint32_t pid, const char *name) {
+  char rel[32];
+  snprintf(rel, sizeof(rel), "%u/%s", (unsigned)pid, name);
+  return openat(proc_fd, rel, O_RDONLY | O_CLOEXEC);
+}
+
+/* Only the fields we report are decoded: comm, state, utime, stime, num_threads, rss. */
+static bool parse_stat(process_entry_t *e, const char *buf, size_t len) {
+  const char *open = memchr(buf, '(', len);
+  const char *close = memrchr(buf, ')', len);
+  if (!open || !close || close < open || close + 2 >= buf + len) return false;
+  size_t comm_len = (size_t)(close - open - 1);
+  if (comm_len > PROCESS_COMM_LEN) comm_len = PROCESS_COMM_LEN;
+  memcpy(e->comm, open + 1, comm_len);
+  e->comm[comm_len] = '\0';
+
+  const char *p = close + 2;
+  e->state = *p;
+  uint64_t utime = 0, stime = 0;
+  p = sysmon_skip_fields(p, 11); /* state .. cstime -> utime (field 14) */
+  if (!sysmon_parse_u64(&p, &utime) || *p++ != ' ' || !sysmon_parse_u64(&p, &stime)) return false;
+  p = sysmon_skip_fields(p + 1, 4); /* cutime .. nice -> num_threads (field 20) */
+  if (!sysmon_parse_u64(&p, &e->threads)) return false;
+  p = sysmon_skip_fields(p + 1, 3); /* itrealvalue .. vsize -> rss (field 24) */
+  if (!sysmon_parse_u64(&p, &e->rss_pages)) e->rss_pages = 0;
+  e->cpu_ticks = utime + stime;
+  return true;
+}
+
+static bool parse_io(const char *p, uint64_t *out) {
+  uint64_t total = 0;
+  bool found = false;
+  for (; *p; p = sysmon_next_line(p)) {
+    const char *v = NULL;
+    if (strncmp(p, "read_bytes:", 11) == 0) v = p + 11;
+    else if (strncmp(p, "write_bytes:", 12) == 0) v = p + 12;
+    if (!v) continue;
+    v = sysmon_skip_blanks(v);
+    uint64_t n = 0;
+    if (!sysmon_parse_u64(&v, &n)) return false;
+    total += n;
+    found = true;
+  }
+  *out = total;
+  return found;
+}
+
+static void sample_entry(process_state_t *st, process_entry_t *e, char *buf, size_t cap) {
+  int fd = e->stat_fd >= 0 ? e->stat_fd : open_pid_file(st->proc_fd, e->pid, "stat");
+  if (fd < 0) {
+    /* Out of descriptors says nothing about the PID: keep its last sample. */
+    if (sysmon_out_of_fds()) e->fd_starved = true;
+    else e->alive = false;
+    return;
+  }
+  const ssize_t n = read_at(fd, buf, cap);
+  if (e->cache_fds) e->stat_fd = fd;
+  else close(fd);
+  /* A cached fd of an exited PID fails with ESRCH, so PID reuse is never misattributed. */
+  e->alive = n > 0 && parse_stat(e, buf, (size_t)n);
+  if (!e->alive || !st->io || e->io_blocked) return;
+
+  /* /proc/<pid>/io needs ptrace access; give up on PIDs we are not allowed to inspect. */
+  fd = e->io_fd >= 0 ? e->io_fd : open_pid_file(st->proc_fd, e->pid, "io");
+  if (fd < 0) {
+    e->io_blocked = errno == EACCES || errno == EPERM;
+    e->fd_starved = sysmon_out_of_fds();
+    return;
+  }
+  if (read_at(fd, buf, cap) <= 0 || !parse_io(buf, &e->io_bytes)) e->io_bytes = e->prev_io_bytes;
+  if (e->cache_fds) e->io_fd = fd;
+  else close(fd);
+}
+
+static void *sample_shard(void *arg) {
+  process_shard_t *shard = (process_shard_t *)arg;
+  char buf[4096];
+  for (size_t i = shard->begin; i < shard->end; i++)
+    sample_entry(shard->st, &shard->st->entries[i], buf, sizeof(buf));
+  return NULL;
+}
+
+static size_t fds_per_entry(const process_state_t *st) { return st->io ? 2 : 1; }
+
+static void release_entry(process_state_t *st, process_entry_t *e) {
+  sysmon_close_fd(&e->stat_fd);
+  sysmon_close_fd(&e->io_fd);
+  if (e->cache_fds) st->open_fds -= fds_per_entry(st);
+  e->cache_fds = false;
+}
+
+static void remove_entry(process_state_t *st, size_t i) {
+  release_entry(st, &st->entries[i]);
+  sysmon_u64map_remove(&st->by_pid, st->entries[i].pid);
+  if (i + 1 != st->count) {
+    st->entries[i] = st->entries[st->count - 1];
+    sysmon_u64map_put(&st->by_pid, st->entries[i].pid, (uint32_t)i);
+  }
+  st->count--;
+}
+
+static bool add_entry(process_state_t *st, uint32_t pid) {
+  if (st->count == st->cap) {
+    const size_t cap = st->cap ? st->cap * 2 : 1024;
+    process_entry_t *p = (process_entry_t *)realloc(st->entries, cap * sizeof(*p));
+    if (!p) return false;
+    st->entries = p;
+    st->cap = cap;
+  }
+  if (!sysmon_u64map_put(&st->by_pid, pid, (uint32_t)st->count)) return false;
+  process_entry_t *e = &st->entries[st->count++];
+  memset(e, 0, sizeof(*e));
+  e->pid = pid;
+  e->seen_gen = st->gen;
+  e->stat_fd = -1;
+  e->io_fd = -1;
+  const size_t need = fds_per_entry(st);
+  if (st->open_fds + need <= st->fd_budget) {
+    e->cache_fds = true;
+    st->open_fds += need;
+  }
+  return true;
+}
+
+static bool scan_pids(process_state_t *st, char **out_error) {
+  if (lseek(st->proc_fd, 0, SEEK_SET) < 0) {
+    sysmon_set_error(out_error, "failed to rewind proc directory");
+    return false;
+  }
+  st->gen++;
+  for (;;) {
+    const long n = syscall(SYS_getdents64, st->proc_fd, st->dents, PROCESS_GETDENTS_BUF);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      sysmon_set_error(out_error, "failed to list proc directory");
+      return false;
+    }
+    if (n == 0) break;
+    for (long off = 0; off < n;) {
+      const struct process_dirent64 *d = (const struct process_dirent64 *)(st->dents + off);
+      off += d->d_reclen;
+      if (d->d_name[0] < '1' || d->d_name[0] > '9') continue;
+      uint32_t pid = 0;
+      const char *c = d->d_name;
+      while (*c >= '0' && *c <= '9') pid = pid * 10u + (uint32_t)(*c++ - '0');
+      if (*c) continue;
+      uint32_t idx = 0;
+      if (sysmon_u64map_get(&st->by_pid, pid, &idx)) {
+        st->entries[idx].seen_gen = st->gen;
+      } else if (!add_entry(st, pid)) {
+        sysmon_set_error(out_error, "out of memory tracking processes");
+        return false;
+      }
+    }
+  }
+  for (size_t i = 0; i < st->count;) {
+    if (st->entries[i].seen_gen != st->gen) remove_entry(st, i);
+    else i++;
+  }
+  return true;
+}
+
+static void sample_all(process_state_t *st) {
+  size_t threads = st->max_threads;
+  const size_t useful = st->count / PROCESS_PIDS_PER_THREAD + 1;
+  if (threads > useful) threads = useful;
+
+  process_shard_t shards[PROCESS_MAX_THREADS];
+  pthread_t tids[PROCESS_MAX_THREADS];
+  bool started[PROCESS_MAX_THREADS] = {false};
+  const size_t per = (st->count + threads - 1) / threads;
+  for (size_t t = 0; t < threads; t++) {
+    shards[t].st = st;
+    shards[t].begin = t * per < st->count ? t * per : st->count;
+    shards[t].end = shards[t].begin + per < st->count ? shards[t].begin + per : st->count;
+    if (t > 0) started[t] = pthread_create(&tids[t], NULL, sample_shard, &shards[t]) == 0;
+  }
+  sample_shard(&shards[0]);
+  for (size_t t = 1; t < threads; t++) {
+    if (started[t]) pthread_join(tids[t], NULL);
+    else sample_shard(&shards[t]);
+  }
+}
+
+static size_t take_top(process_state_t *st, process_rank_t *out) {
+  sysmon_topk_sort_desc(&st->heap);
+  for (size_t i = 0; i < st->heap.count; i++) {
+    const process_entry_t *e = &st->entries[st->heap.items[i].index];
+    out[i].pid = e->pid;
+    memcpy(out[i].comm, e->comm, sizeof(out[i].comm));
+    out[i].value = st->heap.items[i].score;
+  }
+  const size_t n = st->heap.count;
+  sysmon_topk_reset(&st->heap);
+  return n;
+}
+
+static bool refresh(process_state_t *st, uint64_t now_ns, char **out_error) {
+  if (!scan_pids(st, out_error)) return false;
+  sample_all(st);
+
+  const double elapsed_s =
+      st->has_data && now_ns > st->last_ns ? (double)(now_ns - st->last_ns) / 1e9 : 0.0;
+  st->total_threads = 0;
+  st->running = 0;
+  for (size_t i = 0; i < st->count;) {
+    process_entry_t *e = &st->entries[i];
+    if (e->fd_starved) {
+      /* The process hit EMFILE/ENFILE: stop caching here and let later PIDs reopen per read. */
+      e->fd_starved = false;
+      release_entry(st, e);
+      st->fd_budget = st->open_fds;
+    }
+    if (!e->alive) {
+      remove_entry(st, i);
+      continue;
+    }
+    st->total_threads += e->threads;
+    if (e->state == 'R') st->running++;
+    i++;
+  }
+
+  /* One heap, reused for each ranking; indices stay valid because nothing is removed below. */
+  for (size_t i = 0; i < st->count; i++) {
+    const process_entry_t *e = &st->entries[i];
+    if (!e->has_prev || elapsed_s <= 0.0 || e->cpu_ticks < e->prev_cpu_ticks) continue;
+    const double pct =
+        (double)(e->cpu_ticks - e->prev_cpu_ticks) * 100.0 / (st->ticks_per_sec * elapsed_s);
+    sysmon_topk_offer(&st->heap, pct, (uint32_t)i);
+  }
+  st->top_cpu_count = take_top(st, st->top_cpu);
+
+  for (size_t i = 0; i < st->count; i++)
+    sysmon_topk_offer(&st->heap, (double)(st->entries[i].rss_pages * st->page_size), (uint32_t)i);
+  st->top_rss_count = take_top(st, st->top_rss);
+
+  if (st->io) {
+    for (size_t i = 0; i < st->count; i++) {
+      const process_entry_t *e = &st->entries[i];
+      if (!e->has_prev || elapsed_s <= 0.0 || e->io_bytes < e->prev_io_bytes) continue;
+      sysmon_topk_offer(&st->heap, (double)(e->io_bytes - e->prev_io_bytes) / elapsed_s,
+                        (uint32_t)i);
+    }
+    st->top_io_count = take_top(st, st->top_io);
+  }
+
+  for (size_t i = 0; i < st->count; i++) {
+    process_entry_t *e = &st->entries[i];
+    e->prev_cpu_ticks = e->cpu_ticks;
+    e->prev_io_bytes = e->io_bytes;
+    e->has_prev = true;
+  }
+  st->last_ns = now_ns;
+  st->has_data = true;
+  return true;
+}
+
+static sysmon_result_t add_ranking(sysmon_snapshot_builder_t *builder, const char *list,
+                                   const char *metric, const char *unit, bool integral,
+                                   const process_rank_t *ranks, size_t count) {
+  char name[96];
+  for (size_t i = 0; i < count; i++) {
+    snprintf(name, sizeof(name), "process.%s.%zu.pid", list, i);
+    sysmon_result_t rc = sysmon_snapshot_builder_add_u64(builder, name, NULL, ranks[i].pid);
+    if (rc != SYSMON_OK) return rc;
+    snprintf(name, sizeof(name), "process.%s.%zu.name", list, i);
+    rc = sysmon_snapshot_builder_add_string(builder, name, NULL, ranks[i].comm);
+    if (rc != SYSMON_OK) return rc;
+    snprintf(name, sizeof(name), "process.%s.%zu.%s", list, i, metric);
+    rc = integral ? sysmon_snapshot_builder_add_u64(builder, name, unit, (uint64_t)ranks[i].value)
+                  : sysmon_snapshot_builder_add_double(builder, name, unit, ranks[i].value);
+    if (rc != SYSMON_OK) return rc;
+  }
+  return SYSMON_OK;
+}
+#endif
+
+static void process_destroy(void *state) {
+  process_state_t *st = (process_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  for (size_t i = 0; i < st->count; i++) release_entry(st, &st->entries[i]);
+  if (st->proc_fd >= 0) close(st->proc_fd);
+#endif
+  sysmon_u64map_destroy(&st->by_pid);
+  sysmon_topk_destroy(&st->heap);
+  free(st->entries);
+  free(st->dents);
+  free(st);
+}
+
+static sysmon_result_t process_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                      const char *section, void **out_state, char **out_error) {
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  bool ok = true;
+  const uint32_t top_n = sysmon_ini_get_u32(ini, section, "top_n", 5, &ok);
+  if (!ok || top_n == 0 || top_n > PROCESS_MAX_TOP_N) {
+    sysmon_set_error(out_error, "invalid top_n (must be 1..64)");
+    return SYSMON_ERR_PARSE;
+  }
+  const uint32_t threads = sysmon_ini_get_u32(ini, section, "threads", 0, &ok);
+  if (!ok || threads > PROCESS_MAX_THREADS) {
+    sysmon_set_error(out_error, "invalid threads (must be 0..16)");
+    return SYSMON_ERR_PARSE;
+  }
+  const uint32_t fd_budget = sysmon_ini_get_u32(ini, section, "fd_budget", 4096, &ok);
+  if (!ok) {
+    sysmon_set_error(out_error, "invalid fd_budget (must be an integer)");
+    return SYSMON_ERR_PARSE;
+  }
+
+  process_state_t *st = (process_state_t *)calloc(1, sizeof(*st));
+  if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+  st->proc_fd = open(paths->proc_root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  st->dents = (char *)malloc(PROCESS_GETDENTS_BUF);
+  if (!st->dents || !sysmon_u64map_init(&st->by_pid, 1024) || !sysmon_topk_init(&st->heap, top_n)) {
+    process_destroy(st);
+    return SYSMON_ERR_OUT_OF_MEMORY;
+  }
+  if (st->proc_fd < 0) {
+    sysmon_set_error(out_error, "failed to open proc directory");
+    process_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+
+  st->top_n = top_n;
+  st->fd_budget = sysmon_fd_budget(fd_budget);
+  st->io = sysmon_ini_get_bool(ini, section, "io", false);
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cpus < 1) cpus = 1;
+  st->max_threads = threads ? threads : (size_t)(cpus < 8 ? cpus : 8);
+  const long hz = sysconf(_SC_CLK_TCK);
+  st->ticks_per_sec = hz > 0 ? (double)hz : 100.0;
+  const long page = sysconf(_SC_PAGESIZE);
+  st->page_size = page > 0 ? (uint64_t)page : 4096u;
+
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)paths;
+  (void)ini;
+  (void)section;
+  sysmon_set_error(out_error, "process module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static sysmon_result_t process_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                    sysmon_snapshot_builder_t *builder, char **out_error) {
+  process_state_t *st = (process_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+
+#if defined(__linux__)
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data) &&
+      !refresh(st, now_ns, out_error))
+    return SYSMON_ERR_IO;
+
+  sysmon_result_t rc = sysmon_snapshot_builder_add_u64(builder, "process.count", NULL, st->count);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_u64(builder, "process.threads", NULL, st->total_threads);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_u64(builder, "process.running", NULL, st->running);
+  if (rc != SYSMON_OK) return rc;
+  rc = add_ranking(builder, "top_cpu", "cpu_percent", "%", false, st->top_cpu, st->top_cpu_count);
+  if (rc != SYSMON_OK) return rc;
+  rc = add_ranking(builder, "top_rss", "rss_bytes", "B", true, st->top_rss, st->top_rss_count);
+  if (rc != SYSMON_OK) return rc;
+  if (!st->io) return SYSMON_OK;
+  return add_ranking(builder, "top_io", "io_bytes_per_sec", "B/s", false, st->top_io,
+                     st->top_io_count);
+#else
+  (void)now_ns;
+  (void)refresh_now;
+  sysmon_set_error(out_error, "process module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_process_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "process",
+      .create = process_create,
+      .poll = process_poll,
+      .destroy = process_destroy,
+      .opt_in = true,
+  };
+  return &vtable;
+}
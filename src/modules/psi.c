@@ -0,0 +1,363 @@
+#include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#define SYSMON_PSI_MAX_RESOURCES 4
+
+static const char *const psi_resource_names[SYSMON_PSI_MAX_RESOURCES] = {"cpu", "memory", "io",
+                                                                         "irq"};
+
+typedef struct psi_line {
+  double avg10;
+  double avg60;
+  double avg300;
+  uint64_t total_us;
+  double stall_percent;
+  bool present;
+} psi_line_t;
+
+typedef struct psi_resource {
+  const char *name;
+  sysmon_file_t file;
+  int trigger_fd;
+  char *trigger_error;
+  uint64_t trigger_events;
+  uint64_t pending_events;
+  bool triggered;
+  psi_line_t some;
+  psi_line_t full;
+  uint64_t last_ts_ns;
+  bool has_prev;
+} psi_resource_t;
+
+typedef struct psi_state {
+  psi_resource_t res[SYSMON_PSI_MAX_RESOURCES];
+  size_t count;
+  const char *prefix;
+  bool has_data;
+} psi_state_t;
+
+#if defined(__linux__)
+static bool parse_decimal(const char **cursor, double *out) {
+  uint64_t ip = 0, fp = 0;
+  if (!sysmon_parse_u64(cursor, &ip)) return false;
+  double scale = 1.0;
+  if (**cursor == '.') {
+    const char *p = *cursor + 1;
+    while (*p >= '0' && *p <= '9') {
+      fp = fp * 10u + (uint64_t)(*p++ - '0');
+      scale *= 10.0;
+    }
+    *cursor = p;
+  }
+  *out = (double)ip + (double)fp / scale;
+  return true;
+}
+
+/* "some avg10=0.12 avg60=0.05 avg300=0.01 total=123456", optionally followed by a "full" line. */
+static bool parse_psi(const char *p, psi_line_t *some, psi_line_t *full) {
+  some->present = false;
+  full->present = false;
+  while (*p) {
+    psi_line_t *line = NULL;
+    if (strncmp(p, "some ", 5) == 0) line = some;
+    else if (strncmp(p, "full ", 5) == 0) line = full;
+    if (line) {
+      p += 5;
+      while (*p && *p != '\n') {
+        p = sysmon_skip_blanks(p);
+        if (strncmp(p, "avg10=", 6) == 0) {
+          p += 6;
+          if (!parse_decimal(&p, &line->avg10)) return false;
+        } else if (strncmp(p, "avg60=", 6) == 0) {
+          p += 6;
+          if (!parse_decimal(&p, &line->avg60)) return false;
+        } else if (strncmp(p, "avg300=", 7) == 0) {
+          p += 7;
+          if (!parse_decimal(&p, &line->avg300)) return false;
+        } else if (strncmp(p, "total=", 6) == 0) {
+          p += 6;
+          if (!sysmon_parse_u64(&p, &line->total_us)) return false;
+        } else {
+          while (*p && *p != ' ' && *p != '\n') p++;
+        }
+      }
+      line->present = true;
+    }
+    p = sysmon_next_line(p);
+  }
+  return some->present;
+}
+
+static void update_stall_percent(psi_line_t *line, uint64_t prev_total, double elapsed_us) {
+  const uint64_t delta = line->total_us >= prev_total ? line->total_us - prev_total : 0;
+  line->stall_percent = elapsed_us > 0.0 ? (double)delta * 100.0 / elapsed_us : 0.0;
+  if (line->stall_percent > 100.0) line->stall_percent = 100.0;
+}
+
+static bool refresh_resource(psi_resource_t *r, uint64_t now_ns, char **out_error) {
+  const uint64_t prev_some = r->some.total_us, prev_full = r->full.total_us;
+  if (!sysmon_file_read(&r->file) || !parse_psi(r->file.buf, &r->some, &r->full)) {
+    char buf[96];
+    snprintf(buf, sizeof(buf), "failed to read %s pressure", r->name);
+    sysmon_set_error(out_error, buf);
+    return false;
+  }
+  if (r->has_prev && now_ns > r->last_ts_ns) {
+    const double elapsed_us = (double)(now_ns - r->last_ts_ns) / 1000.0;
+    update_stall_percent(&r->some, prev_some, elapsed_us);
+    if (r->full.present) update_stall_percent(&r->full, prev_full, elapsed_us);
+  } else {
+    r->some.stall_percent = 0.0;
+    r->full.stall_percent = 0.0;
+  }
+  r->last_ts_ns = now_ns;
+  r->has_prev = true;
+
+  r->triggered = r->pending_events > 0;
+  r->trigger_events += r->pending_events;
+  r->pending_events = 0;
+  return true;
+}
+
+/* POLLERR/POLLHUP mean the trigger is gone for good (its cgroup was removed): poll(2) would
+ * report it again immediately, so the trigger is dropped and the resource falls back to the
+ * refresh schedule. */
+static void trigger_event(psi_resource_t *r, short revents) {
+  if (revents & POLLPRI) r->pending_events++;
+  if (!(revents & (POLLERR | POLLHUP | POLLNVAL))) return;
+  sysmon_close_fd(&r->trigger_fd);
+  sysmon_set_error(&r->trigger_error, "trigger removed by the kernel");
+}
+
+static void check_triggers(psi_state_t *st) {
+  struct pollfd fds[SYSMON_PSI_MAX_RESOURCES];
+  size_t idx[SYSMON_PSI_MAX_RESOURCES], n = 0;
+  for (size_t i = 0; i < st->count; i++) {
+    if (st->res[i].trigger_fd < 0) continue;
+    fds[n].fd = st->res[i].trigger_fd;
+    fds[n].events = POLLPRI;
+    fds[n].revents = 0;
+    idx[n++] = i;
+  }
+  if (n == 0 || poll(fds, (nfds_t)n, 0) <= 0) return;
+  for (size_t k = 0; k < n; k++) {
+    if (fds[k].revents) trigger_event(&st->res[idx[k]], fds[k].revents);
+  }
+}
+
+/* A trigger the kernel refuses (no write access, unprivileged window, ...) does not fail
+ * create: the resource is polled on the refresh schedule and <res>.trigger_error says why. */
+static bool install_trigger(psi_resource_t *r, const char *path, const char *spec,
+                            char **out_error) {
+  char buf[SYSMON_PATH_LEN + 128];
+  if (strncmp(spec, "some ", 5) != 0 && strncmp(spec, "full ", 5) != 0) {
+    snprintf(buf, sizeof(buf), "invalid %s_trigger (expected \"some|full <stall_us> <window_us>\")",
+             r->name);
+    sysmon_set_error(out_error, buf);
+    return false;
+  }
+  r->trigger_fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (r->trigger_fd < 0 || write(r->trigger_fd, spec, strlen(spec) + 1) < 0) {
+    snprintf(buf, sizeof(buf), "failed to install PSI trigger on %s: %s", path, strerror(errno));
+    sysmon_set_error(&r->trigger_error, buf);
+    sysmon_close_fd(&r->trigger_fd);
+  }
+  return true;
+}
+
+static sysmon_result_t add_line_metrics(sysmon_snapshot_builder_t *builder, const char *prefix,
+                                        const char *res, const char *kind, const psi_line_t *l) {
+  char name[96];
+  snprintf(name, sizeof(name), "%s.%s.%s_avg10", prefix, res, kind);
+  sysmon_result_t rc = sysmon_snapshot_builder_add_double(builder, name, "%", l->avg10);
+  if (rc != SYSMON_OK) return rc;
+  snprintf(name, sizeof(name), "%s.%s.%s_avg60", prefix, res, kind);
+  rc = sysmon_snapshot_builder_add_double(builder, name, "%", l->avg60);
+  if (rc != SYSMON_OK) return rc;
+  snprintf(name, sizeof(name), "%s.%s.%s_avg300", prefix, res, kind);
+  rc = sysmon_snapshot_builder_add_double(builder, name, "%", l->avg300);
+  if (rc != SYSMON_OK) return rc;
+  snprintf(name, sizeof(name), "%s.%s.%s_total_us", prefix, res, kind);
+  rc = sysmon_snapshot_builder_add_u64(builder, name, "us", l->total_us);
+  if (rc != SYSMON_OK) return rc;
+  snprintf(name, sizeof(name), "%s.%s.%s_stall_percent", prefix, res, kind);
+  return sysmon_snapshot_builder_add_double(builder, name, "%", l->stall_percent);
+}
+
+static size_t psi_event_sources(void *state, sysmon_event_source_t *out, size_t max) {
+  psi_state_t *st = (psi_state_t *)state;
+  size_t n = 0;
+  for (size_t i = 0; st && i < st->count; i++) {
+    if (st->res[i].trigger_fd < 0) continue;
+    if (out && n < max) {
+      out[n].fd = st->res[i].trigger_fd;
+      out[n].events = POLLPRI;
+      out[n].revents = 0;
+    }
+    n++;
+  }
+  return n;
+}
+
+static bool psi_on_event(void *state, const sysmon_event_source_t *source) {
+  psi_state_t *st = (psi_state_t *)state;
+  if (!st || !source->revents) return false;
+  for (size_t i = 0; i < st->count; i++) {
+    if (st->res[i].trigger_fd == source->fd) trigger_event(&st->res[i], source->revents);
+  }
+  return true;
+}
+#endif
+
+static void psi_destroy(void *state) {
+  psi_state_t *st = (psi_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  for (size_t i = 0; i < st->count; i++) {
+    sysmon_file_close(&st->res[i].file);
+    sysmon_close_fd(&st->res[i].trigger_fd);
+    free(st->res[i].trigger_error);
+  }
+#endif
+  free(st);
+}
+
+static sysmon_result_t psi_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                  const char *section, void **out_state, char **out_error) {
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  psi_state_t *st = (psi_state_t *)calloc(1, sizeof(*st));
+  if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+
+  const char *resources = sysmon_ini_get(ini, section, "resources");
+  bool selected[SYSMON_PSI_MAX_RESOURCES] = {true, true, true, false};
+  if (resources && *resources) {
+    memset(selected, 0, sizeof(selected));
+    if (!sysmon_select_names(resources, psi_resource_names, SYSMON_PSI_MAX_RESOURCES,
+                             sizeof(psi_resource_names[0]), selected, "psi resource", out_error)) {
+      free(st);
+      return SYSMON_ERR_PARSE;
+    }
+  }
+  const char *cgroup = sysmon_ini_get(ini, section, "cgroup");
+  const bool use_cgroup = cgroup && *cgroup;
+  st->prefix = use_cgroup ? "psi.cgroup" : "psi";
+
+  for (size_t i = 0; i < SYSMON_PSI_MAX_RESOURCES; i++) {
+    const char *name = psi_resource_names[i];
+    if (!selected[i]) continue;
+
+    char rel[SYSMON_PATH_LEN], path[SYSMON_PATH_LEN];
+    if (use_cgroup) {
+      snprintf(rel, sizeof(rel), "fs/cgroup/%s/%s.pressure", cgroup[0] == '/' ? cgroup + 1 : cgroup,
+               name);
+      sysmon_sys_path(paths, rel, path, sizeof(path));
+    } else {
+      snprintf(rel, sizeof(rel), "pressure/%s", name);
+      sysmon_proc_path(paths, rel, path, sizeof(path));
+    }
+
+    psi_resource_t *r = &st->res[st->count];
+    r->name = name;
+    r->trigger_fd = -1;
+    sysmon_file_init(&r->file);
+    if (!sysmon_file_open(&r->file, path)) continue;
+    st->count++;
+
+    char key[32];
+    snprintf(key, sizeof(key), "%s_trigger", name);
+    const char *spec = sysmon_ini_get(ini, section, key);
+    if (spec && *spec && !install_trigger(r, path, spec, out_error)) {
+      psi_destroy(st);
+      return SYSMON_ERR_PARSE;
+    }
+  }
+
+  if (st->count == 0) {
+    sysmon_set_error(out_error, "pressure stall information not available");
+    psi_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)paths;
+  (void)ini;
+  (void)section;
+  sysmon_set_error(out_error, "psi module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static sysmon_result_t psi_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                sysmon_snapshot_builder_t *builder, char **out_error) {
+  psi_state_t *st = (psi_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+
+#if defined(__linux__)
+  check_triggers(st);
+  bool pending = false;
+  for (size_t i = 0; i < st->count; i++) pending = pending || st->res[i].pending_events > 0;
+
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, pending || !st->has_data)) {
+    for (size_t i = 0; i < st->count; i++) {
+      if (!refresh_resource(&st->res[i], now_ns, out_error)) return SYSMON_ERR_IO;
+    }
+    st->has_data = true;
+  }
+
+  for (size_t i = 0; i < st->count; i++) {
+    const psi_resource_t *r = &st->res[i];
+    sysmon_result_t rc = add_line_metrics(builder, st->prefix, r->name, "some", &r->some);
+    if (rc != SYSMON_OK) return rc;
+    if (r->full.present) {
+      rc = add_line_metrics(builder, st->prefix, r->name, "full", &r->full);
+      if (rc != SYSMON_OK) return rc;
+    }
+    char name[96];
+    if (r->trigger_error) {
+      snprintf(name, sizeof(name), "%s.%s.trigger_error", st->prefix, r->name);
+      rc = sysmon_snapshot_builder_add_string(builder, name, NULL, r->trigger_error);
+      if (rc != SYSMON_OK) return rc;
+    }
+    if (r->trigger_fd < 0 && !r->trigger_error) continue;
+    snprintf(name, sizeof(name), "%s.%s.trigger_events", st->prefix, r->name);
+    rc = sysmon_snapshot_builder_add_u64(builder, name, NULL, r->trigger_events);
+    if (rc != SYSMON_OK) return rc;
+    snprintf(name, sizeof(name), "%s.%s.triggered", st->prefix, r->name);
+    rc = sysmon_snapshot_builder_add_i64(builder, name, NULL, r->triggered ? 1 : 0);
+    if (rc != SYSMON_OK) return rc;
+  }
+  return SYSMON_OK;
+#else
+  (void)now_ns;
+  (void)refresh_now;
+  sysmon_set_error(out_error, "psi module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_psi_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "psi",
+      .create = psi_create,
+      .poll = psi_poll,
+      .destroy = psi_destroy,
+#if defined(__linux__)
+      .event_sources = psi_event_sources,
+      .on_event = psi_on_event,
+#endif
+  };
+  return &vtable;
+}
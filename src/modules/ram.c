@@ -1,4 +1,5 @@
 #include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
 
 #include <errno.h>
 #include <stdio.h>
@@ -13,6 +14,15 @@
 #endif
 
 typedef struct ram_state {
+#if defined(__linux__)
+  char meminfo_path[SYSMON_PATH_LEN];
+  /* container mode: memory.current minus inactive file cache, against memory.max */
+  bool container;
+  sysmon_cgroup_limit_t cg_limit;
+  sysmon_file_t cg_current;
+  sysmon_file_t cg_stat;
+  uint64_t host_total_bytes;
+#endif
   uint64_t total_bytes;
   uint64_t last_used_bytes;
   uint64_t last_free_bytes;
@@ -20,8 +30,9 @@ typedef struct ram_state {
   bool has_data;
 } ram_state_t;
 
-static bool read_total_mem(uint64_t *out_total, char **out_error) {
+static bool read_total_mem(const ram_state_t *st, uint64_t *out_total, char **out_error) {
 #if defined(__APPLE__)
+  (void)st;
   uint64_t memsize = 0;
   size_t len = sizeof(memsize);
   if (sysctlbyname("hw.memsize", &memsize, &len, NULL, 0) != 0 || memsize == 0) {
@@ -31,9 +42,9 @@ static bool read_total_mem(uint64_t *out_total, char **out_error) {
   *out_total = memsize;
   return true;
 #elif defined(__linux__)
-  FILE *f = fopen("/proc/meminfo", "r");
+  FILE *f = fopen(st->meminfo_path, "r");
   if (!f) {
-    sysmon_set_error(out_error, "failed to open /proc/meminfo");
+    sysmon_set_path_error(out_error, "failed to open", st->meminfo_path);
     return false;
   }
   char line[256];
@@ -46,17 +57,19 @@ static bool read_total_mem(uint64_t *out_total, char **out_error) {
     }
   }
   fclose(f);
-  sysmon_set_error(out_error, "MemTotal not found in /proc/meminfo");
+  sysmon_set_path_error(out_error, "MemTotal not found in", st->meminfo_path);
   return false;
 #else
+  (void)st;
   (void)out_total;
   sysmon_set_error(out_error, "ram module not supported on this platform");
   return false;
 #endif
 }
 
-static bool read_mem_used_free(uint64_t total_bytes, uint64_t *out_used, uint64_t *out_free,
+static bool read_mem_used_free(const ram_state_t *st, uint64_t *out_used, uint64_t *out_free,
                                char **out_error) {
+  const uint64_t total_bytes = st->total_bytes;
 #if defined(__APPLE__)
   vm_size_t page_size = 0;
   if (host_page_size(mach_host_self(), &page_size) != KERN_SUCCESS || page_size == 0) {
@@ -78,9 +91,9 @@ static bool read_mem_used_free(uint64_t total_bytes, uint64_t *out_used, uint64_
   *out_free = free_bytes;
   return true;
 #elif defined(__linux__)
-  FILE *f = fopen("/proc/meminfo", "r");
+  FILE *f = fopen(st->meminfo_path, "r");
   if (!f) {
-    sysmon_set_error(out_error, "failed to open /proc/meminfo");
+    sysmon_set_path_error(out_error, "failed to open", st->meminfo_path);
     return false;
   }
   unsigned long long mem_total_kb = 0, mem_free_kb = 0, mem_available_kb = 0;
@@ -108,35 +121,116 @@ static bool read_mem_used_free(uint64_t total_bytes, uint64_t *out_used, uint64_
 #endif
 }
 
-static sysmon_result_t ram_create(const sysmon_ini_t *ini, const char *section, void **out_state,
-                                  char **out_error) {
-  (void)ini;
-  (void)section;
+#if defined(__linux__)
+static double parse_memory_max(const char *text) {
+  uint64_t v = 0;
+  return sysmon_parse_u64(&text, &v) ? (double)v : -1.0;
+}
+
+/* Working set as the kubelet computes it: memory.current - inactive_file. */
+static bool read_cgroup_used(ram_state_t *st, uint64_t *out_used, char **out_error) {
+  if (sysmon_cgroup_limit_changed(&st->cg_limit)) {
+    double limit = 0.0;
+    st->total_bytes = sysmon_cgroup_limit_read(&st->cg_limit, parse_memory_max, &limit) &&
+                              limit < (double)st->host_total_bytes
+                          ? (uint64_t)limit
+                          : st->host_total_bytes;
+  }
+  uint64_t current = 0, inactive_file = 0;
+  if (!sysmon_file_read(&st->cg_current)) {
+    sysmon_set_error(out_error, "failed to read cgroup memory.current");
+    return false;
+  }
+  const char *p = st->cg_current.buf;
+  sysmon_parse_u64(&p, &current);
+  if (sysmon_file_read(&st->cg_stat)) {
+    for (p = st->cg_stat.buf; *p; p = sysmon_next_line(p)) {
+      if (strncmp(p, "inactive_file ", 14) != 0) continue;
+      p += 14;
+      sysmon_parse_u64(&p, &inactive_file);
+      break;
+    }
+  }
+  *out_used = current > inactive_file ? current - inactive_file : 0;
+  return true;
+}
+#endif
+
+static void ram_destroy(void *state) {
+  ram_state_t *st = (ram_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  sysmon_file_close(&st->cg_current);
+  sysmon_file_close(&st->cg_stat);
+  sysmon_cgroup_limit_close(&st->cg_limit);
+#endif
+  free(st);
+}
+
+static sysmon_result_t ram_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                  const char *section, void **out_state, char **out_error) {
   if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
   ram_state_t *st = (ram_state_t *)calloc(1, sizeof(*st));
   if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+#if defined(__linux__)
+  sysmon_proc_path(paths, "meminfo", st->meminfo_path, sizeof(st->meminfo_path));
+  sysmon_file_init(&st->cg_current);
+  sysmon_file_init(&st->cg_stat);
+  st->cg_limit.inotify_fd = -1;
+#else
+  (void)paths;
+#endif
   char *err = NULL;
-  if (!read_total_mem(&st->total_bytes, &err)) {
+  if (!read_total_mem(st, &st->total_bytes, &err)) {
     sysmon_set_error(out_error, err ? err : "failed to read total memory");
     free(err);
     free(st);
     return SYSMON_ERR_NOT_SUPPORTED;
   }
   free(err);
+#if defined(__linux__)
+  st->host_total_bytes = st->total_bytes;
+  if (sysmon_ini_get_bool(ini, section, "container", false)) {
+    st->container = true;
+    char path[SYSMON_PATH_LEN + 16] = "";
+    if (sysmon_cgroup_limit_open(&st->cg_limit, paths, "memory.max"))
+      snprintf(path, sizeof(path), "%s/memory.current", st->cg_limit.dir);
+    if (st->cg_limit.inotify_fd < 0 || !sysmon_file_open(&st->cg_current, path)) {
+      sysmon_set_error(out_error,
+                       "container mode needs the cgroup v2 memory.current of this process");
+      ram_destroy(st);
+      return SYSMON_ERR_NOT_SUPPORTED;
+    }
+    snprintf(path, sizeof(path), "%s/memory.stat", st->cg_limit.dir);
+    sysmon_file_open(&st->cg_stat, path);
+  }
+#else
+  (void)ini;
+  (void)section;
+#endif
   *out_state = st;
   return SYSMON_OK;
 }
 
-static sysmon_result_t ram_poll(void *state, uint64_t now_ms, bool refresh_now,
+static sysmon_result_t ram_poll(void *state, uint64_t now_ns, bool refresh_now,
                                 sysmon_snapshot_builder_t *builder, char **out_error) {
-  (void)now_ms;
   ram_state_t *st = (ram_state_t *)state;
   if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
 
-  if (refresh_now || !st->has_data) {
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
     uint64_t used = 0, free_b = 0;
     char *err = NULL;
-    if (!read_mem_used_free(st->total_bytes, &used, &free_b, &err)) {
+#if defined(__linux__)
+    const bool ok = st->container ? read_cgroup_used(st, &used, &err)
+                                  : read_mem_used_free(st, &used, &free_b, &err);
+    if (ok && st->container) {
+      if (used > st->total_bytes) used = st->total_bytes;
+      free_b = st->total_bytes - used;
+    }
+#else
+    const bool ok = read_mem_used_free(st, &used, &free_b, &err);
+#endif
+    if (!ok) {
       sysmon_set_error(out_error, err ? err : "failed to read memory usage");
       free(err);
       return SYSMON_ERR_NOT_SUPPORTED;
@@ -160,11 +254,15 @@ static sysmon_result_t ram_poll(void *state, uint64_t now_ms, bool refresh_now,
     rc = sysmon_snapshot_builder_add_double(builder, "ram.used_percent", "%", st->last_used_percent);
     if (rc != SYSMON_OK) return rc;
   }
+#if defined(__linux__)
+  if (st->container) {
+    rc = sysmon_snapshot_builder_add_u64(builder, "ram.host_total_bytes", "B", st->host_total_bytes);
+    if (rc != SYSMON_OK) return rc;
+  }
+#endif
   return SYSMON_OK;
 }
 
-static void ram_destroy(void *state) { free(state); }
-
 const sysmon_module_vtable_t *sysmon_ram_module(void) {
   static const sysmon_module_vtable_t vtable = {
       .name = "ram", .create = ram_create, .poll = ram_poll, .destroy = ram_destroy};
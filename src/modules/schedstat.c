@@ -0,0 +1,222 @@
+#include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct schedstat_cpu {
+  int id;
+  uint64_t run_ns;
+  uint64_t wait_ns;
+  uint64_t timeslices;
+  double wait_per_slice_us;
+  double wait_percent;
+  double slices_per_sec;
+} schedstat_cpu_t;
+
+typedef struct schedstat_state {
+  sysmon_file_t file;
+  schedstat_cpu_t *cpus;
+  size_t count;
+  size_t cap;
+  double *sorted;
+  bool per_cpu;
+  double wait_per_slice_us;
+  double waiting_avg;
+  double p50_us;
+  double p99_us;
+  double max_us;
+  uint64_t last_ts_ns;
+  bool has_data;
+} schedstat_state_t;
+
+#if defined(__linux__)
+static int cmp_double(const void *a, const void *b) {
+  const double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/* "cpu<N> yld 0 sched goidle ttwu ttwu_local run_ns wait_ns timeslices" (version >= 15) */
+static bool parse_schedstat(schedstat_state_t *st, const char *p, double seconds) {
+  size_t n = 0;
+  while (*p) {
+    if (strncmp(p, "cpu", 3) != 0) {
+      p = sysmon_next_line(p);
+      continue;
+    }
+    const char *q = p + 3;
+    uint64_t id = 0, skip = 0, run = 0, wait = 0, slices = 0;
+    bool ok = sysmon_parse_u64(&q, &id);
+    for (int i = 0; ok && i < 6; i++) ok = sysmon_parse_u64(&q, &skip);
+    ok = ok && sysmon_parse_u64(&q, &run) && sysmon_parse_u64(&q, &wait) &&
+         sysmon_parse_u64(&q, &slices);
+    p = sysmon_next_line(q);
+    if (!ok) continue;
+
+    if (n == st->cap) {
+      const size_t cap = st->cap ? st->cap * 2 : 64;
+      schedstat_cpu_t *grown = (schedstat_cpu_t *)realloc(st->cpus, cap * sizeof(*grown));
+      if (!grown) return false;
+      st->cpus = grown;
+      double *sorted = (double *)realloc(st->sorted, cap * sizeof(*sorted));
+      if (!sorted) return false;
+      st->sorted = sorted;
+      st->cap = cap;
+    }
+    schedstat_cpu_t *c = &st->cpus[n];
+    const bool known = n < st->count && c->id == (int)id;
+    if (!known) {
+      memset(c, 0, sizeof(*c));
+      c->id = (int)id;
+    }
+    if (known && seconds > 0.0 && wait >= c->wait_ns && slices >= c->timeslices) {
+      const double d_wait = (double)(wait - c->wait_ns);
+      const double d_slices = (double)(slices - c->timeslices);
+      c->wait_per_slice_us = d_slices > 0.0 ? d_wait / d_slices / 1000.0 : 0.0;
+      c->wait_percent = d_wait / (seconds * 1e9) * 100.0;
+      c->slices_per_sec = d_slices / seconds;
+    } else {
+      c->wait_per_slice_us = 0.0;
+      c->wait_percent = 0.0;
+      c->slices_per_sec = 0.0;
+    }
+    c->run_ns = run;
+    c->wait_ns = wait;
+    c->timeslices = slices;
+    n++;
+  }
+  st->count = n;
+  return n > 0;
+}
+
+static void summarize(schedstat_state_t *st) {
+  double wait_us = 0.0, slices = 0.0, waiting = 0.0;
+  for (size_t i = 0; i < st->count; i++) {
+    const schedstat_cpu_t *c = &st->cpus[i];
+    wait_us += c->wait_per_slice_us * c->slices_per_sec;
+    slices += c->slices_per_sec;
+    waiting += c->wait_percent / 100.0;
+    st->sorted[i] = c->wait_per_slice_us;
+  }
+  st->wait_per_slice_us = slices > 0.0 ? wait_us / slices : 0.0;
+  st->waiting_avg = waiting;
+  qsort(st->sorted, st->count, sizeof(*st->sorted), cmp_double);
+  const size_t last = st->count - 1;
+  st->p50_us = st->sorted[last / 2];
+  st->p99_us = st->sorted[(size_t)((double)last * 0.99 + 0.5)];
+  st->max_us = st->sorted[last];
+}
+#endif
+
+static void schedstat_destroy(void *state) {
+  schedstat_state_t *st = (schedstat_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  sysmon_file_close(&st->file);
+#endif
+  free(st->cpus);
+  free(st->sorted);
+  free(st);
+}
+
+static sysmon_result_t schedstat_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                        const char *section, void **out_state, char **out_error) {
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  schedstat_state_t *st = (schedstat_state_t *)calloc(1, sizeof(*st));
+  if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+  sysmon_file_init(&st->file);
+  st->per_cpu = sysmon_ini_get_bool(ini, section, "per_cpu", false);
+
+  char path[SYSMON_PATH_LEN];
+  sysmon_proc_path(paths, "schedstat", path, sizeof(path));
+  uint64_t version = 0;
+  const char *p = NULL;
+  if (sysmon_file_open(&st->file, path) && sysmon_file_read(&st->file)) {
+    p = st->file.buf;
+    if (strncmp(p, "version ", 8) == 0) p += 8;
+  }
+  if (!p || !sysmon_parse_u64(&p, &version) || version < 15) {
+    char buf[SYSMON_PATH_LEN + 64];
+    snprintf(buf, sizeof(buf),
+             p ? "unsupported version (< 15) in %s" : "cannot open %s (CONFIG_SCHEDSTATS)", path);
+    sysmon_set_error(out_error, buf);
+    schedstat_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)paths;
+  (void)ini;
+  (void)section;
+  sysmon_set_error(out_error, "schedstat module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static sysmon_result_t schedstat_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                      sysmon_snapshot_builder_t *builder, char **out_error) {
+  schedstat_state_t *st = (schedstat_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+
+#if defined(__linux__)
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
+    const double seconds = st->has_data && now_ns > st->last_ts_ns
+                               ? (double)(now_ns - st->last_ts_ns) / (double)SYSMON_NS_PER_SEC
+                               : 0.0;
+    if (!sysmon_file_read(&st->file) || !parse_schedstat(st, st->file.buf, seconds)) {
+      sysmon_set_path_error(out_error, "failed to read", st->file.path);
+      return SYSMON_ERR_IO;
+    }
+    summarize(st);
+    st->last_ts_ns = now_ns;
+    st->has_data = true;
+  }
+
+  sysmon_result_t rc = sysmon_snapshot_builder_add_double(builder, "schedstat.wait_per_timeslice_us",
+                                                          "us", st->wait_per_slice_us);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "schedstat.waiting_tasks_avg", NULL,
+                                          st->waiting_avg);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "schedstat.cpu_wait_p50_us", "us", st->p50_us);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "schedstat.cpu_wait_p99_us", "us", st->p99_us);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "schedstat.cpu_wait_max_us", "us", st->max_us);
+  if (rc != SYSMON_OK || !st->per_cpu) return rc;
+
+  char name[96];
+#define SCHED_ADD(id, metric, unit, value)                                       \
+  do {                                                                           \
+    snprintf(name, sizeof(name), "schedstat.cpu.%d.%s", id, metric);             \
+    rc = sysmon_snapshot_builder_add_double(builder, name, unit, value);         \
+    if (rc != SYSMON_OK) return rc;                                              \
+  } while (0)
+  for (size_t i = 0; i < st->count; i++) {
+    const schedstat_cpu_t *c = &st->cpus[i];
+    SCHED_ADD(c->id, "wait_per_timeslice_us", "us", c->wait_per_slice_us);
+    SCHED_ADD(c->id, "wait_percent", "%", c->wait_percent);
+    SCHED_ADD(c->id, "timeslices_per_sec", "/s", c->slices_per_sec);
+  }
+#undef SCHED_ADD
+  return SYSMON_OK;
+#else
+  (void)now_ns;
+  (void)refresh_now;
+  sysmon_set_error(out_error, "schedstat module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_schedstat_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "schedstat",
+      .create = schedstat_create,
+      .poll = schedstat_poll,
+      .destroy = schedstat_destroy,
+  };
+  return &vtable;
+}
@@ -0,0 +1,404 @@
+#include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define SELF_MAX_TOP_N 64
+#define SELF_COMM_LEN 16
+#define SELF_GETDENTS_BUF (16 * 1024)
+#define SELF_BUF 2048
+/* 64 threads' worth of cached fds; larger thread pools are read uncached past that. */
+#define SELF_DEFAULT_FD_BUDGET 256
+
+enum { SELF_STAT, SELF_SCHEDSTAT, SELF_STATUS, SELF_FILES };
+
+static const char *const self_file_names[SELF_FILES] = {"stat", "schedstat", "status"};
+
+/* Directory fd plus one fd per file, kept while the thread lives and the budget allows. */
+#define SELF_FDS_PER_THREAD (1 + SELF_FILES)
+
+typedef struct self_sample {
+  uint64_t cpu_ticks;
+  uint64_t run_ns;
+  uint64_t wait_ns;
+  uint64_t voluntary;
+  uint64_t involuntary;
+} self_sample_t;
+
+typedef struct self_thread {
+  uint32_t tid;
+  uint32_t seen_gen;
+  int dir_fd;
+  int fds[SELF_FILES];
+  bool cache_fds;
+  bool fd_starved;
+  bool alive;
+  bool has_prev;
+  bool has_schedstat;
+  char comm[SELF_COMM_LEN + 1];
+  self_sample_t cur;
+  self_sample_t prev;
+  uint64_t prev_ns;
+  double cpu_percent;
+  double run_delay_percent;
+  double voluntary_rate;
+  double involuntary_rate;
+} self_thread_t;
+
+typedef struct self_state {
+  int task_fd;
+  char *dents;
+  self_thread_t *threads;
+  size_t count;
+  size_t cap;
+  sysmon_u64map_t by_tid;
+  uint32_t gen;
+  size_t open_fds;
+  size_t fd_budget;
+  double ticks_per_sec;
+  sysmon_topk_t top;
+  double cpu_percent;
+  double run_delay_percent;
+  double voluntary_rate;
+  double involuntary_rate;
+  char buf[SELF_BUF + SYSMON_PARSE_PADDING + 1];
+  bool has_data;
+} self_state_t;
+
+#if defined(__linux__)
+struct self_dirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+
+static void release_thread(self_state_t *st, self_thread_t *t) {
+  for (size_t f = 0; f < SELF_FILES; f++) sysmon_close_fd(&t->fds[f]);
+  sysmon_close_fd(&t->dir_fd);
+  if (t->cache_fds) st->open_fds -= SELF_FDS_PER_THREAD;
+  t->cache_fds = false;
+}
+
+static void remove_thread(self_state_t *st, size_t i) {
+  release_thread(st, &st->threads[i]);
+  sysmon_u64map_remove(&st->by_tid, st->threads[i].tid);
+  if (i + 1 != st->count) {
+    st->threads[i] = st->threads[st->count - 1];
+    sysmon_u64map_put(&st->by_tid, st->threads[i].tid, (uint32_t)i);
+  }
+  st->count--;
+}
+
+static bool add_thread(self_state_t *st, uint32_t tid) {
+  if (st->count == st->cap) {
+    const size_t cap = st->cap ? st->cap * 2 : 64;
+    self_thread_t *p = (self_thread_t *)realloc(st->threads, cap * sizeof(*p));
+    if (!p) return false;
+    st->threads = p;
+    st->cap = cap;
+  }
+  if (!sysmon_u64map_put(&st->by_tid, tid, (uint32_t)st->count)) return false;
+  self_thread_t *t = &st->threads[st->count++];
+  memset(t, 0, sizeof(*t));
+  t->tid = tid;
+  t->seen_gen = st->gen;
+  t->dir_fd = -1;
+  for (size_t f = 0; f < SELF_FILES; f++) t->fds[f] = -1;
+  t->has_schedstat = true;
+  if (st->open_fds + SELF_FDS_PER_THREAD <= st->fd_budget) {
+    t->cache_fds = true;
+    st->open_fds += SELF_FDS_PER_THREAD;
+  }
+  return true;
+}
+
+/* Only new TIDs cost an open; known ones just get their generation bumped. */
+static bool scan_tasks(self_state_t *st, char **out_error) {
+  if (lseek(st->task_fd, 0, SEEK_SET) < 0) {
+    sysmon_set_error(out_error, "failed to rewind task directory");
+    return false;
+  }
+  st->gen++;
+  for (;;) {
+    const long n = syscall(SYS_getdents64, st->task_fd, st->dents, SELF_GETDENTS_BUF);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      sysmon_set_error(out_error, "failed to list task directory");
+      return false;
+    }
+    if (n == 0) break;
+    for (long off = 0; off < n;) {
+      const struct self_dirent64 *d = (const struct self_dirent64 *)(st->dents + off);
+      off += d->d_reclen;
+      if (d->d_name[0] < '1' || d->d_name[0] > '9') continue;
+      uint32_t tid = 0;
+      const char *c = d->d_name;
+      while (*c >= '0' && *c <= '9') tid = tid * 10u + (uint32_t)(*c++ - '0');
+      if (*c) continue;
+      uint32_t idx = 0;
+      if (sysmon_u64map_get(&st->by_tid, tid, &idx)) {
+        st->threads[idx].seen_gen = st->gen;
+      } else if (!add_thread(st, tid)) {
+        sysmon_set_error(out_error, "out of memory tracking threads");
+        return false;
+      }
+    }
+  }
+  for (size_t i = 0; i < st->count;) {
+    if (st->threads[i].seen_gen != st->gen) remove_thread(st, i);
+    else i++;
+  }
+  return true;
+}
+
+static ssize_t read_file(self_state_t *st, self_thread_t *t, size_t which) {
+  if (t->dir_fd < 0) {
+    char rel[16];
+    snprintf(rel, sizeof(rel), "%u", (unsigned)t->tid);
+    t->dir_fd = openat(st->task_fd, rel, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (t->dir_fd < 0) {
+      t->fd_starved = sysmon_out_of_fds();
+      return -1;
+    }
+  }
+  int fd = t->fds[which];
+  if (fd < 0) fd = openat(t->dir_fd, self_file_names[which], O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    t->fd_starved = sysmon_out_of_fds();
+    return -1;
+  }
+  ssize_t n;
+  do {
+    n = pread(fd, st->buf, SELF_BUF, 0);
+  } while (n < 0 && errno == EINTR);
+  if (t->cache_fds) t->fds[which] = fd;
+  else close(fd);
+  if (n >= 0) memset(st->buf + n, 0, SYSMON_PARSE_PADDING + 1);
+  return n;
+}
+
+/* stat gives comm and utime + stime, schedstat "run_ns wait_ns timeslices", status the
+ * context-switch counts. A cached fd of an exited thread fails with ESRCH; running out of
+ * descriptors leaves the thread alive with its last sample. */
+static void sample_thread(self_state_t *st, self_thread_t *t) {
+  ssize_t n = read_file(st, t, SELF_STAT);
+  if (t->fd_starved) return;
+  const char *open_paren = n > 0 ? strchr(st->buf, '(') : NULL;
+  const char *close_paren = n > 0 ? strrchr(st->buf, ')') : NULL;
+  if (!open_paren || !close_paren || close_paren < open_paren) {
+    t->alive = false;
+    return;
+  }
+  size_t comm_len = (size_t)(close_paren - open_paren - 1);
+  if (comm_len > SELF_COMM_LEN) comm_len = SELF_COMM_LEN;
+  memcpy(t->comm, open_paren + 1, comm_len);
+  t->comm[comm_len] = '\0';
+  const char *p = sysmon_skip_fields(close_paren + 2, 11); /* state .. cmajflt -> utime (field 14) */
+  uint64_t utime = 0, stime = 0;
+  if (!sysmon_parse_u64(&p, &utime) || !sysmon_parse_u64(&p, &stime)) {
+    t->alive = false;
+    return;
+  }
+  t->cur.cpu_ticks = utime + stime;
+  t->alive = true;
+
+  if (t->has_schedstat) {
+    n = read_file(st, t, SELF_SCHEDSTAT);
+    p = st->buf;
+    t->has_schedstat = t->fd_starved || (n > 0 && sysmon_parse_u64(&p, &t->cur.run_ns) &&
+                                         sysmon_parse_u64(&p, &t->cur.wait_ns));
+  }
+  if (read_file(st, t, SELF_STATUS) > 0) {
+    t->cur.voluntary = sysmon_status_value(st->buf, "voluntary_ctxt_switches");
+    t->cur.involuntary = sysmon_status_value(st->buf, "nonvoluntary_ctxt_switches");
+  }
+  if (!t->cache_fds) sysmon_close_fd(&t->dir_fd);
+}
+
+static bool refresh(self_state_t *st, uint64_t now_ns, char **out_error) {
+  if (!scan_tasks(st, out_error)) return false;
+
+  st->cpu_percent = 0.0;
+  st->run_delay_percent = 0.0;
+  st->voluntary_rate = 0.0;
+  st->involuntary_rate = 0.0;
+  sysmon_topk_reset(&st->top);
+  for (size_t i = 0; i < st->count;) {
+    self_thread_t *t = &st->threads[i];
+    sample_thread(st, t);
+    if (!t->alive) {
+      remove_thread(st, i);
+      continue;
+    }
+    const bool starved = t->fd_starved;
+    if (starved) {
+      /* EMFILE/ENFILE: stop caching here, later threads reopen per read, and this one keeps
+       * its previous rates and its history until a full sample goes through. */
+      t->fd_starved = false;
+      release_thread(st, t);
+      st->fd_budget = st->open_fds;
+    }
+#define SELF_DELTA(field) \
+  (t->cur.field >= t->prev.field ? (double)(t->cur.field - t->prev.field) : 0.0)
+    /* Per thread: a starved refresh leaves prev older than the last refresh. */
+    const double elapsed_s =
+        t->has_prev && now_ns > t->prev_ns ? (double)(now_ns - t->prev_ns) / 1e9 : 0.0;
+    if (!starved && elapsed_s > 0.0) {
+      /* schedstat run time is in ns; fall back to clock ticks without CONFIG_SCHED_INFO. */
+      t->cpu_percent = t->has_schedstat
+                           ? SELF_DELTA(run_ns) / (elapsed_s * 1e7)
+                           : SELF_DELTA(cpu_ticks) * 100.0 / (st->ticks_per_sec * elapsed_s);
+      t->run_delay_percent = t->has_schedstat ? SELF_DELTA(wait_ns) / (elapsed_s * 1e7) : 0.0;
+      t->voluntary_rate = SELF_DELTA(voluntary) / elapsed_s;
+      t->involuntary_rate = SELF_DELTA(involuntary) / elapsed_s;
+    }
+#undef SELF_DELTA
+    st->cpu_percent += t->cpu_percent;
+    st->run_delay_percent += t->run_delay_percent;
+    st->voluntary_rate += t->voluntary_rate;
+    st->involuntary_rate += t->involuntary_rate;
+    sysmon_topk_offer(&st->top, t->cpu_percent, (uint32_t)i);
+    if (!starved) {
+      t->prev = t->cur;
+      t->prev_ns = now_ns;
+      t->has_prev = true;
+    }
+    i++;
+  }
+  sysmon_topk_sort_desc(&st->top);
+  st->has_data = true;
+  return true;
+}
+#endif
+
+static void self_destroy(void *state) {
+  self_state_t *st = (self_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  for (size_t i = 0; i < st->count; i++) release_thread(st, &st->threads[i]);
+  if (st->task_fd >= 0) close(st->task_fd);
+#endif
+  sysmon_u64map_destroy(&st->by_tid);
+  sysmon_topk_destroy(&st->top);
+  free(st->threads);
+  free(st->dents);
+  free(st);
+}
+
+static sysmon_result_t self_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                   const char *section, void **out_state, char **out_error) {
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  bool ok = true;
+  const uint32_t top_n = sysmon_ini_get_u32(ini, section, "top_n", 5, &ok);
+  if (!ok || top_n == 0 || top_n > SELF_MAX_TOP_N) {
+    sysmon_set_error(out_error, "invalid top_n (must be 1..64)");
+    return SYSMON_ERR_PARSE;
+  }
+  const uint32_t fd_budget =
+      sysmon_ini_get_u32(ini, section, "fd_budget", SELF_DEFAULT_FD_BUDGET, &ok);
+  if (!ok) {
+    sysmon_set_error(out_error, "invalid fd_budget (must be an integer)");
+    return SYSMON_ERR_PARSE;
+  }
+
+  self_state_t *st = (self_state_t *)calloc(1, sizeof(*st));
+  if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+  char path[SYSMON_PATH_LEN];
+  sysmon_proc_path(paths, "self/task", path, sizeof(path));
+  st->task_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  st->dents = (char *)malloc(SELF_GETDENTS_BUF);
+  if (!st->dents || !sysmon_u64map_init(&st->by_tid, 64) || !sysmon_topk_init(&st->top, top_n)) {
+    self_destroy(st);
+    return SYSMON_ERR_OUT_OF_MEMORY;
+  }
+  if (st->task_fd < 0) {
+    sysmon_set_path_error(out_error, "failed to open", path);
+    self_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+  st->fd_budget = sysmon_fd_budget(fd_budget);
+  const long hz = sysconf(_SC_CLK_TCK);
+  st->ticks_per_sec = hz > 0 ? (double)hz : 100.0;
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)paths;
+  (void)ini;
+  (void)section;
+  sysmon_set_error(out_error, "self module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static sysmon_result_t self_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                 sysmon_snapshot_builder_t *builder, char **out_error) {
+  self_state_t *st = (self_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+
+#if defined(__linux__)
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data) &&
+      !refresh(st, now_ns, out_error))
+    return SYSMON_ERR_IO;
+
+  sysmon_result_t rc = sysmon_snapshot_builder_add_u64(builder, "self.thread_count", NULL, st->count);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "self.cpu_percent", "%", st->cpu_percent);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "self.run_delay_percent", "%",
+                                          st->run_delay_percent);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "self.voluntary_ctxt_switches_per_sec", "/s",
+                                          st->voluntary_rate);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "self.nonvoluntary_ctxt_switches_per_sec", "/s",
+                                          st->involuntary_rate);
+  if (rc != SYSMON_OK) return rc;
+
+  char name[96];
+#define SELF_ADD(kind, rank, metric, unit, value)                            \
+  do {                                                                       \
+    snprintf(name, sizeof(name), "self.top.%zu.%s", rank, metric);           \
+    rc = sysmon_snapshot_builder_add_##kind(builder, name, unit, value);     \
+    if (rc != SYSMON_OK) return rc;                                          \
+  } while (0)
+  for (size_t i = 0; i < st->top.count; i++) {
+    const self_thread_t *t = &st->threads[st->top.items[i].index];
+    SELF_ADD(u64, i, "tid", NULL, t->tid);
+    SELF_ADD(string, i, "name", NULL, t->comm);
+    SELF_ADD(double, i, "cpu_percent", "%", t->cpu_percent);
+    SELF_ADD(double, i, "run_delay_percent", "%", t->run_delay_percent);
+    SELF_ADD(double, i, "voluntary_ctxt_switches_per_sec", "/s", t->voluntary_rate);
+    SELF_ADD(double, i, "nonvoluntary_ctxt_switches_per_sec", "/s", t->involuntary_rate);
+  }
+#undef SELF_ADD
+  return SYSMON_OK;
+#else
+  (void)now_ns;
+  (void)refresh_now;
+  sysmon_set_error(out_error, "self module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_self_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "self",
+      .create = self_create,
+      .poll = self_poll,
+      .destroy = self_destroy,
+      .opt_in = true,
+  };
+  return &vtable;
+}
@@ -0,0 +1,386 @@
+#include "../sysmon_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <linux/inet_diag.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/tcp.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#define SOCKETS_TCP_STATES 12 /* TCP_ESTABLISHED (1) .. TCP_CLOSING (11) */
+#define SOCKETS_TCP_LISTEN 10
+#define SOCKETS_RTT_BUCKETS 13
+#define SOCKETS_CWND_BUCKETS 11
+#define SOCKETS_RECV_BUF (64 * 1024)
+
+static const char *const sockets_state_names[SOCKETS_TCP_STATES] = {
+    NULL,        "established", "syn_sent",   "syn_recv", "fin_wait1", "fin_wait2",
+    "time_wait", "close",       "close_wait", "last_ack", "listen",    "closing"};
+
+/* Upper bounds in microseconds; the last bucket is open-ended. */
+static const uint32_t sockets_rtt_bounds_us[SOCKETS_RTT_BUCKETS - 1] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000};
+
+/* Upper bounds in segments; the last bucket is open-ended. */
+static const uint32_t sockets_cwnd_bounds[SOCKETS_CWND_BUCKETS - 1] = {1,  2,  4,   8,   16,
+                                                                      32, 64, 128, 256, 512};
+
+typedef struct sockets_stats {
+  uint64_t states[SOCKETS_TCP_STATES];
+  uint64_t rtt_hist[SOCKETS_RTT_BUCKETS];
+  uint64_t cwnd_hist[SOCKETS_CWND_BUCKETS];
+  uint64_t rtt_sum_us;
+  uint64_t with_info;
+  uint64_t retrans_total;
+  uint64_t retransmitting;
+  uint64_t accept_queue;
+  double listen_max_queue_percent;
+} sockets_stats_t;
+
+typedef struct sockets_state {
+  int fd;
+  uint32_t seq;
+  uint32_t state_mask;
+  bool tcp_info;
+  bool inet4;
+  bool inet6;
+  unsigned char bytecode[32];
+  size_t bytecode_len;
+  char *buf;
+  sockets_stats_t stats;
+  bool has_data;
+} sockets_state_t;
+
+#if defined(__linux__)
+static size_t bucket_for(const uint32_t *bounds, size_t count, uint32_t v) {
+  size_t i = 0;
+  while (i < count && v > bounds[i]) i++;
+  return i;
+}
+
+static void account_socket(sockets_stats_t *s, const struct inet_diag_msg *msg, size_t len) {
+  if (msg->idiag_state < SOCKETS_TCP_STATES) s->states[msg->idiag_state]++;
+  if (msg->idiag_state == SOCKETS_TCP_LISTEN) {
+    s->accept_queue += msg->idiag_rqueue;
+    if (msg->idiag_wqueue > 0) {
+      const double pct = (double)msg->idiag_rqueue * 100.0 / (double)msg->idiag_wqueue;
+      if (pct > s->listen_max_queue_percent) s->listen_max_queue_percent = pct;
+    }
+    return;
+  }
+
+  const struct rtattr *attr = (const struct rtattr *)(msg + 1);
+  size_t rem = len - NLMSG_ALIGN(sizeof(*msg));
+  for (; RTA_OK(attr, rem); attr = RTA_NEXT(attr, rem)) {
+    if (attr->rta_type != INET_DIAG_INFO) continue;
+    struct tcp_info info;
+    memset(&info, 0, sizeof(info));
+    const size_t n = RTA_PAYLOAD(attr) < sizeof(info) ? RTA_PAYLOAD(attr) : sizeof(info);
+    memcpy(&info, RTA_DATA(attr), n);
+    s->with_info++;
+    s->rtt_sum_us += info.tcpi_rtt;
+    s->rtt_hist[bucket_for(sockets_rtt_bounds_us, SOCKETS_RTT_BUCKETS - 1, info.tcpi_rtt)]++;
+    s->cwnd_hist[bucket_for(sockets_cwnd_bounds, SOCKETS_CWND_BUCKETS - 1, info.tcpi_snd_cwnd)]++;
+    s->retrans_total += info.tcpi_total_retrans;
+    if (info.tcpi_retransmits > 0) s->retransmitting++;
+    break;
+  }
+}
+
+static bool dump_family(sockets_state_t *st, uint8_t family, char **out_error) {
+  struct {
+    struct nlmsghdr nlh;
+    struct inet_diag_req_v2 req;
+    struct rtattr bc;
+    unsigned char bytecode[sizeof(st->bytecode)];
+  } msg;
+  memset(&msg, 0, sizeof(msg));
+  const size_t bc_len = st->bytecode_len ? RTA_LENGTH(st->bytecode_len) : 0;
+  msg.nlh.nlmsg_len = (uint32_t)(NLMSG_LENGTH(sizeof(msg.req)) + bc_len);
+  msg.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+  msg.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  msg.nlh.nlmsg_seq = ++st->seq;
+  msg.req.sdiag_family = family;
+  msg.req.sdiag_protocol = IPPROTO_TCP;
+  msg.req.idiag_states = st->state_mask;
+  if (st->tcp_info) msg.req.idiag_ext = 1u << (INET_DIAG_INFO - 1);
+  if (st->bytecode_len) {
+    msg.bc.rta_type = INET_DIAG_REQ_BYTECODE;
+    msg.bc.rta_len = (unsigned short)bc_len;
+    memcpy(msg.bytecode, st->bytecode, st->bytecode_len);
+  }
+
+  struct sockaddr_nl kernel = {.nl_family = AF_NETLINK};
+  if (sendto(st->fd, &msg, msg.nlh.nlmsg_len, 0, (struct sockaddr *)&kernel, sizeof(kernel)) < 0) {
+    sysmon_set_error(out_error, "sock_diag request failed");
+    return false;
+  }
+
+  /* Each datagram is folded into the counters and the buffer reused: no per-socket state. */
+  for (;;) {
+    const ssize_t n = recv(st->fd, st->buf, SOCKETS_RECV_BUF, 0);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      sysmon_set_error(out_error, "sock_diag receive failed");
+      return false;
+    }
+    size_t rem = (size_t)n;
+    for (const struct nlmsghdr *h = (const struct nlmsghdr *)st->buf; NLMSG_OK(h, rem);
+         h = NLMSG_NEXT(h, rem)) {
+      if (h->nlmsg_seq != st->seq) continue;
+      if (h->nlmsg_type == NLMSG_DONE) return true;
+      if (h->nlmsg_type == NLMSG_ERROR) {
+        const struct nlmsgerr *e = (const struct nlmsgerr *)NLMSG_DATA(h);
+        char buf[96];
+        snprintf(buf, sizeof(buf), "sock_diag dump failed: %s", strerror(-e->error));
+        sysmon_set_error(out_error, buf);
+        return false;
+      }
+      if (h->nlmsg_type != SOCK_DIAG_BY_FAMILY) continue;
+      account_socket(&st->stats, (const struct inet_diag_msg *)NLMSG_DATA(h),
+                     h->nlmsg_len - NLMSG_HDRLEN);
+    }
+  }
+}
+
+/* AND of "port >= lo" / "port <= hi" tests; a failed test jumps past the end (reject). */
+static void append_port_test(sockets_state_t *st, uint8_t code, uint16_t port, size_t total) {
+  struct inet_diag_bc_op *op = (struct inet_diag_bc_op *)(st->bytecode + st->bytecode_len);
+  op[0].code = code;
+  op[0].yes = 2 * sizeof(*op);
+  op[0].no = (unsigned short)(total - st->bytecode_len + 4);
+  op[1].code = 0;
+  op[1].yes = 0;
+  op[1].no = port;
+  st->bytecode_len += 2 * sizeof(*op);
+}
+
+static bool parse_port_range(const char *s, uint16_t *lo, uint16_t *hi) {
+  char *end = NULL;
+  unsigned long a = strtoul(s, &end, 10), b = a;
+  if (end == s) return false;
+  if (*end == '-') {
+    const char *p = end + 1;
+    b = strtoul(p, &end, 10);
+    if (end == p) return false;
+  }
+  if (*end != '\0' || a > 65535 || b > 65535 || a > b) return false;
+  *lo = (uint16_t)a;
+  *hi = (uint16_t)b;
+  return true;
+}
+
+static bool parse_states(const char *list, uint32_t *out_mask) {
+  uint32_t mask = 0;
+  for (const char *p = list; *p;) {
+    while (*p == ' ' || *p == ',') p++;
+    const char *end = p;
+    while (*end && *end != ',' && *end != ' ') end++;
+    const size_t n = (size_t)(end - p);
+    if (n == 0) break;
+    size_t i = 1;
+    for (; i < SOCKETS_TCP_STATES; i++) {
+      if (strlen(sockets_state_names[i]) == n && strncmp(p, sockets_state_names[i], n) == 0) break;
+    }
+    if (i == SOCKETS_TCP_STATES) return false;
+    mask |= 1u << i;
+    p = end;
+  }
+  *out_mask = mask;
+  return mask != 0;
+}
+
+static uint32_t histogram_quantile(const uint64_t *hist, size_t buckets, const uint32_t *bounds,
+                                   uint64_t total, double q) {
+  if (total == 0) return 0;
+  const uint64_t rank = (uint64_t)(q * (double)total + 0.5);
+  uint64_t seen = 0;
+  for (size_t i = 0; i + 1 < buckets; i++) {
+    seen += hist[i];
+    if (seen >= rank) return bounds[i];
+  }
+  return bounds[buckets - 2];
+}
+
+static sysmon_result_t add_histogram(sysmon_snapshot_builder_t *builder, const char *prefix,
+                                     const char *unit, const uint64_t *hist, size_t buckets,
+                                     const uint32_t *bounds) {
+  char name[96];
+  for (size_t i = 0; i < buckets; i++) {
+    if (i + 1 < buckets) snprintf(name, sizeof(name), "%s.le_%u", prefix, (unsigned)bounds[i]);
+    else snprintf(name, sizeof(name), "%s.inf", prefix);
+    sysmon_result_t rc = sysmon_snapshot_builder_add_u64(builder, name, unit, hist[i]);
+    if (rc != SYSMON_OK) return rc;
+  }
+  return SYSMON_OK;
+}
+#endif
+
+static void sockets_destroy(void *state) {
+  sockets_state_t *st = (sockets_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  if (st->fd >= 0) close(st->fd);
+#endif
+  free(st->buf);
+  free(st);
+}
+
+static sysmon_result_t sockets_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                      const char *section, void **out_state, char **out_error) {
+  (void)paths;
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  sockets_state_t *st = (sockets_state_t *)calloc(1, sizeof(*st));
+  if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+  st->fd = -1;
+  st->state_mask = ~0u;
+  st->tcp_info = sysmon_ini_get_bool(ini, section, "tcp_info", true);
+
+  const char *states = sysmon_ini_get(ini, section, "states");
+  if (states && *states && !parse_states(states, &st->state_mask)) {
+    sysmon_set_error(out_error, "invalid states (expected e.g. established,listen,time_wait)");
+    sockets_destroy(st);
+    return SYSMON_ERR_PARSE;
+  }
+
+  const char *families = sysmon_ini_get(ini, section, "families");
+  st->inet4 = !families || !*families || strstr(families, "inet4") || strstr(families, "ipv4");
+  st->inet6 = !families || !*families || strstr(families, "inet6") || strstr(families, "ipv6");
+
+  uint16_t ranges[2][2];
+  bool have[2] = {false, false};
+  static const char *const port_keys[2] = {"sport", "dport"};
+  for (size_t i = 0; i < 2; i++) {
+    const char *v = sysmon_ini_get(ini, section, port_keys[i]);
+    if (!v || !*v) continue;
+    if (!parse_port_range(v, &ranges[i][0], &ranges[i][1])) {
+      char buf[96];
+      snprintf(buf, sizeof(buf), "invalid %s (expected <port> or <lo>-<hi>)", port_keys[i]);
+      sysmon_set_error(out_error, buf);
+      sockets_destroy(st);
+      return SYSMON_ERR_PARSE;
+    }
+    have[i] = true;
+  }
+  const size_t total = (have[0] ? 16u : 0u) + (have[1] ? 16u : 0u);
+  if (have[0]) {
+    append_port_test(st, INET_DIAG_BC_S_GE, ranges[0][0], total);
+    append_port_test(st, INET_DIAG_BC_S_LE, ranges[0][1], total);
+  }
+  if (have[1]) {
+    append_port_test(st, INET_DIAG_BC_D_GE, ranges[1][0], total);
+    append_port_test(st, INET_DIAG_BC_D_LE, ranges[1][1], total);
+  }
+
+  st->buf = (char *)malloc(SOCKETS_RECV_BUF);
+  if (!st->buf) {
+    sockets_destroy(st);
+    return SYSMON_ERR_OUT_OF_MEMORY;
+  }
+  st->fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+  if (st->fd < 0) {
+    sysmon_set_error(out_error, "NETLINK_SOCK_DIAG not available");
+    sockets_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)ini;
+  (void)section;
+  sysmon_set_error(out_error, "sockets module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static sysmon_result_t sockets_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                    sysmon_snapshot_builder_t *builder, char **out_error) {
+#if !defined(__linux__)
+  (void)now_ns;
+#endif
+  sockets_state_t *st = (sockets_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+
+#if defined(__linux__)
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
+    memset(&st->stats, 0, sizeof(st->stats));
+    if ((st->inet4 && !dump_family(st, AF_INET, out_error)) ||
+        (st->inet6 && !dump_family(st, AF_INET6, out_error)))
+      return SYSMON_ERR_IO;
+    st->has_data = true;
+  }
+
+  const sockets_stats_t *s = &st->stats;
+  char name[96];
+  uint64_t total = 0;
+  for (size_t i = 1; i < SOCKETS_TCP_STATES; i++) {
+    total += s->states[i];
+    if (!(st->state_mask & (1u << i))) continue;
+    snprintf(name, sizeof(name), "sockets.tcp.%s", sockets_state_names[i]);
+    sysmon_result_t rc = sysmon_snapshot_builder_add_u64(builder, name, NULL, s->states[i]);
+    if (rc != SYSMON_OK) return rc;
+  }
+  sysmon_result_t rc = sysmon_snapshot_builder_add_u64(builder, "sockets.tcp.total", NULL, total);
+  if (rc != SYSMON_OK) return rc;
+  if (st->state_mask & (1u << SOCKETS_TCP_LISTEN)) {
+    rc = sysmon_snapshot_builder_add_u64(builder, "sockets.tcp.listen_accept_queue", NULL,
+                                         s->accept_queue);
+    if (rc != SYSMON_OK) return rc;
+    rc = sysmon_snapshot_builder_add_double(builder, "sockets.tcp.listen_max_queue_percent", "%",
+                                            s->listen_max_queue_percent);
+    if (rc != SYSMON_OK) return rc;
+  }
+  if (!st->tcp_info) return SYSMON_OK;
+
+  rc = sysmon_snapshot_builder_add_u64(builder, "sockets.tcp.retrans_total", NULL, s->retrans_total);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_u64(builder, "sockets.tcp.retransmitting", NULL, s->retransmitting);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_double(builder, "sockets.tcp.rtt_avg_us", "us",
+                                          s->with_info ? (double)s->rtt_sum_us / (double)s->with_info
+                                                       : 0.0);
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_u64(
+      builder, "sockets.tcp.rtt_p50_us", "us",
+      histogram_quantile(s->rtt_hist, SOCKETS_RTT_BUCKETS, sockets_rtt_bounds_us, s->with_info, 0.5));
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_u64(
+      builder, "sockets.tcp.rtt_p99_us", "us",
+      histogram_quantile(s->rtt_hist, SOCKETS_RTT_BUCKETS, sockets_rtt_bounds_us, s->with_info, 0.99));
+  if (rc != SYSMON_OK) return rc;
+  rc = sysmon_snapshot_builder_add_u64(
+      builder, "sockets.tcp.cwnd_p50", NULL,
+      histogram_quantile(s->cwnd_hist, SOCKETS_CWND_BUCKETS, sockets_cwnd_bounds, s->with_info, 0.5));
+  if (rc != SYSMON_OK) return rc;
+  rc = add_histogram(builder, "sockets.tcp.rtt_us", NULL, s->rtt_hist, SOCKETS_RTT_BUCKETS,
+                     sockets_rtt_bounds_us);
+  if (rc != SYSMON_OK) return rc;
+  return add_histogram(builder, "sockets.tcp.cwnd", NULL, s->cwnd_hist, SOCKETS_CWND_BUCKETS,
+                       sockets_cwnd_bounds);
+#else
+  (void)refresh_now;
+  sysmon_set_error(out_error, "sockets module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_sockets_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "sockets",
+      .create = sockets_create,
+      .poll = sockets_poll,
+      .destroy = sockets_destroy,
+      .opt_in = true,
+  };
+  return &vtable;
+}
@@ -9,15 +9,96 @@
 #include <sys/statvfs.h>
 #endif
 
+#if defined(__linux__)
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
 #define SYSMON_STORAGE_PATH_LEN 256
+#define SYSMON_STORAGE_FSTYPE_LEN 32
+
+/* Pseudo and in-memory filesystems skipped in mounts mode unless exclude_fstypes overrides it. */
+#define SYSMON_STORAGE_DEFAULT_EXCLUDE_FSTYPES                                                     \
+  "autofs,binfmt_misc,bpf,cgroup,cgroup2,configfs,debugfs,devpts,devtmpfs,efivarfs,fusectl,"     \
+  "hugetlbfs,mqueue,nsfs,overlay,proc,pstore,ramfs,rpc_pipefs,securityfs,selinuxfs,squashfs,"   \
+  "sysfs,tmpfs,tracefs"
+
+typedef struct storage_usage {
+  uint64_t total_bytes;
+  uint64_t free_bytes;
+  uint64_t avail_bytes;
+  uint64_t used_bytes;
+  double used_percent;
+  uint64_t inodes_total;
+  uint64_t inodes_free;
+  uint64_t inodes_used;
+  double inodes_used_percent;
+} storage_usage_t;
+
+#if defined(__linux__)
+typedef struct storage_job {
+  struct storage_job *next;
+  unsigned refs;
+  bool started;
+  bool done;
+  int err;
+  uint64_t start_ns;
+  struct statvfs vfs;
+  char path[SYSMON_STORAGE_PATH_LEN];
+} storage_job_t;
+
+/* Persistent statvfs workers, started on demand up to max_threads. Shared by the module and
+ * every worker and freed by whichever drops the last reference, so a worker stuck on a dead
+ * NFS server can safely outlive the module. */
+typedef struct storage_pool {
+  pthread_mutex_t mu;
+  pthread_cond_t work_cv;
+  pthread_cond_t done_cv;
+  storage_job_t *head;
+  storage_job_t *tail;
+  size_t queued;
+  unsigned threads;
+  unsigned idle;
+  unsigned max_threads;
+  unsigned refs;
+  bool stopping;
+} storage_pool_t;
+
+typedef struct storage_mount {
+  char path[SYSMON_STORAGE_PATH_LEN];
+  char fstype[SYSMON_STORAGE_FSTYPE_LEN];
+  uint64_t dev;
+  storage_job_t *job;
+  bool launched;
+  bool timed_out;
+  bool has_data;
+  int err; /* errno of the last completed statvfs, 0 on success */
+  storage_usage_t usage;
+} storage_mount_t;
+#endif
 
 typedef struct storage_state {
   char path[SYSMON_STORAGE_PATH_LEN];
-  uint64_t last_total_bytes;
-  uint64_t last_free_bytes;
-  uint64_t last_avail_bytes;
-  uint64_t last_used_bytes;
-  double last_used_percent;
+#if defined(__linux__)
+  int path_fd;
+  sysmon_file_t mountinfo;
+  bool mounts_dirty;
+
+  bool all_mounts;
+  char *fstypes;
+  char *exclude_fstypes;
+  char *paths;
+  char *exclude_paths;
+  bool bind_mounts;
+  uint32_t timeout_ms;
+  storage_pool_t *pool;
+  storage_mount_t *mounts;
+  size_t mount_count;
+#endif
+  storage_usage_t last;
   bool has_data;
 } storage_state_t;
 
@@ -30,34 +111,512 @@ static void copy_path(char *dst, size_t dst_len, const char *src) {
   snprintf(dst, dst_len, "%s", src);
 }
 
-static bool read_storage_stats(const char *path, uint64_t *out_total, uint64_t *out_free,
-                               uint64_t *out_avail, char **out_error) {
 #if defined(__APPLE__) || defined(__linux__)
-  if (!path || !out_total || !out_free || !out_avail) return false;
+static void usage_from_statvfs(const struct statvfs *vfs, storage_usage_t *out) {
+  const uint64_t block_size = vfs->f_frsize ? (uint64_t)vfs->f_frsize : (uint64_t)vfs->f_bsize;
+  out->total_bytes = (uint64_t)vfs->f_blocks * block_size;
+  out->free_bytes = (uint64_t)vfs->f_bfree * block_size;
+  out->avail_bytes = (uint64_t)vfs->f_bavail * block_size;
+  out->used_bytes = out->total_bytes >= out->free_bytes ? out->total_bytes - out->free_bytes : 0;
+  out->used_percent =
+      out->total_bytes > 0 ? (double)out->used_bytes * 100.0 / (double)out->total_bytes : 0.0;
+  out->inodes_total = (uint64_t)vfs->f_files;
+  out->inodes_free = (uint64_t)vfs->f_ffree;
+  out->inodes_used = out->inodes_total >= out->inodes_free ? out->inodes_total - out->inodes_free : 0;
+  out->inodes_used_percent = out->inodes_total > 0
+                                 ? (double)out->inodes_used * 100.0 / (double)out->inodes_total
+                                 : 0.0;
+}
+#endif
+
+static sysmon_result_t add_usage_metrics(sysmon_snapshot_builder_t *builder, const char *prefix,
+                                         const storage_usage_t *u) {
+  char name[SYSMON_STORAGE_PATH_LEN + 64];
+#define STORAGE_ADD(kind, metric, unit, value)                                              \
+  do {                                                                                      \
+    snprintf(name, sizeof(name), "%s.%s", prefix, metric);                                  \
+    sysmon_result_t rc_ = sysmon_snapshot_builder_add_##kind(builder, name, unit, (value)); \
+    if (rc_ != SYSMON_OK) return rc_;                                                       \
+  } while (0)
+
+  STORAGE_ADD(u64, "total_bytes", "B", u->total_bytes);
+  STORAGE_ADD(u64, "used_bytes", "B", u->used_bytes);
+  STORAGE_ADD(u64, "free_bytes", "B", u->free_bytes);
+  STORAGE_ADD(u64, "available_bytes", "B", u->avail_bytes);
+  STORAGE_ADD(double, "used_percent", "%", u->used_percent);
+  STORAGE_ADD(u64, "inodes_total", NULL, u->inodes_total);
+  STORAGE_ADD(u64, "inodes_used", NULL, u->inodes_used);
+  STORAGE_ADD(u64, "inodes_free", NULL, u->inodes_free);
+  STORAGE_ADD(double, "inodes_used_percent", "%", u->inodes_used_percent);
+#undef STORAGE_ADD
+  return SYSMON_OK;
+}
+
+#if defined(__linux__)
+static bool open_path_fd(const char *path, int *out_fd, char **out_error) {
+  int fd = open(path, O_PATH | O_CLOEXEC);
+  if (fd < 0) {
+    char buf[SYSMON_PATH_LEN];
+    snprintf(buf, sizeof(buf), "open(%s) failed: %s", path, strerror(errno));
+    sysmon_set_error(out_error, buf);
+    return false;
+  }
+  *out_fd = fd;
+  return true;
+}
+
+static bool mount_table_changed(storage_state_t *st) {
+  if (st->mounts_dirty) {
+    st->mounts_dirty = false;
+    return true;
+  }
+  if (st->mountinfo.fd < 0) return false;
+  struct pollfd pfd = {.fd = st->mountinfo.fd, .events = POLLPRI, .revents = 0};
+  if (poll(&pfd, 1, 0) <= 0) return false;
+  return (pfd.revents & (POLLPRI | POLLERR)) != 0;
+}
+
+static size_t storage_event_sources(void *state, sysmon_event_source_t *out, size_t max) {
+  storage_state_t *st = (storage_state_t *)state;
+  if (!st || st->mountinfo.fd < 0) return 0;
+  if (out && max > 0) {
+    out[0].fd = st->mountinfo.fd;
+    out[0].events = POLLPRI;
+    out[0].revents = 0;
+  }
+  return 1;
+}
+
+static bool storage_on_event(void *state, const sysmon_event_source_t *source) {
+  storage_state_t *st = (storage_state_t *)state;
+  if (!st || !(source->revents & (POLLPRI | POLLERR))) return false;
+  st->mounts_dirty = true;
+  return true;
+}
+
+static bool reresolve_path(storage_state_t *st, char **out_error) {
+  int fd = -1;
+  if (!open_path_fd(st->path, &fd, out_error)) return false;
+  if (st->path_fd >= 0) close(st->path_fd);
+  st->path_fd = fd;
+  return true;
+}
+
+static void destroy_pool(storage_pool_t *pool) {
+  pthread_mutex_destroy(&pool->mu);
+  pthread_cond_destroy(&pool->work_cv);
+  pthread_cond_destroy(&pool->done_cv);
+  free(pool);
+}
+
+static void release_job(storage_pool_t *pool, storage_job_t *job) {
+  pthread_mutex_lock(&pool->mu);
+  const bool free_job = --job->refs == 0;
+  pthread_mutex_unlock(&pool->mu);
+  if (free_job) free(job);
+}
+
+/* Called with pool->mu held. */
+static void run_job(storage_pool_t *pool, storage_job_t *job) {
+  job->started = true;
+  job->start_ns = sysmon_now_ns(false);
+  pthread_mutex_unlock(&pool->mu);
   struct statvfs vfs;
-  if (statvfs(path, &vfs) != 0) {
-    char buf[256];
-    snprintf(buf, sizeof(buf), "statvfs(%s) failed: %s", path, strerror(errno));
+  const int err = statvfs(job->path, &vfs) == 0 ? 0 : errno;
+  pthread_mutex_lock(&pool->mu);
+  job->vfs = vfs;
+  job->err = err;
+  job->done = true;
+  pthread_cond_broadcast(&pool->done_cv);
+  if (--job->refs == 0) free(job);
+}
+
+static void *statvfs_worker(void *arg) {
+  storage_pool_t *pool = (storage_pool_t *)arg;
+  pthread_mutex_lock(&pool->mu);
+  for (;;) {
+    while (!pool->head && !pool->stopping) {
+      pool->idle++;
+      pthread_cond_wait(&pool->work_cv, &pool->mu);
+      pool->idle--;
+    }
+    if (pool->stopping) break;
+    storage_job_t *job = pool->head;
+    pool->head = job->next;
+    if (!pool->head) pool->tail = NULL;
+    pool->queued--;
+    run_job(pool, job);
+  }
+  pool->threads--;
+  const bool free_pool = --pool->refs == 0;
+  pthread_mutex_unlock(&pool->mu);
+  if (free_pool) destroy_pool(pool);
+  return NULL;
+}
+
+static storage_pool_t *create_pool(unsigned max_threads) {
+  storage_pool_t *pool = (storage_pool_t *)calloc(1, sizeof(*pool));
+  if (!pool) return NULL;
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_mutex_init(&pool->mu, NULL);
+  pthread_cond_init(&pool->work_cv, NULL);
+  pthread_cond_init(&pool->done_cv, &attr);
+  pthread_condattr_destroy(&attr);
+  pool->max_threads = max_threads;
+  pool->refs = 1;
+  return pool;
+}
+
+/* Drops queued jobs and lets idle workers exit; a worker still inside statvfs exits when the
+ * call returns. */
+static void stop_pool(storage_pool_t *pool) {
+  pthread_mutex_lock(&pool->mu);
+  pool->stopping = true;
+  storage_job_t *job = pool->head;
+  while (job) {
+    storage_job_t *next = job->next;
+    if (--job->refs == 0) free(job);
+    job = next;
+  }
+  pool->head = pool->tail = NULL;
+  pool->queued = 0;
+  pthread_cond_broadcast(&pool->work_cv);
+  const bool free_pool = --pool->refs == 0;
+  pthread_mutex_unlock(&pool->mu);
+  if (free_pool) destroy_pool(pool);
+}
+
+/* Queues statvfs for a pool worker, starting one if none is idle; runs it on the calling
+ * thread if the pool has no thread at all and none can be made. */
+static bool launch_job(storage_state_t *st, storage_mount_t *m) {
+  storage_pool_t *pool = st->pool;
+  storage_job_t *job = (storage_job_t *)calloc(1, sizeof(*job));
+  if (!job) return false;
+  job->refs = 2;
+  copy_path(job->path, sizeof(job->path), m->path);
+  m->job = job;
+  m->launched = true;
+
+  pthread_mutex_lock(&pool->mu);
+  if (pool->tail)
+    pool->tail->next = job;
+  else
+    pool->head = job;
+  pool->tail = job;
+  pool->queued++;
+  if (pool->queued > pool->idle && pool->threads < pool->max_threads) {
+    pthread_attr_t attr;
+    pthread_t tid;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&tid, &attr, statvfs_worker, pool) == 0) {
+      pool->threads++;
+      pool->refs++;
+    }
+    pthread_attr_destroy(&attr);
+  }
+  if (pool->threads == 0) {
+    pool->head = pool->tail = NULL;
+    pool->queued = 0;
+    run_job(pool, job);
+  } else {
+    pthread_cond_signal(&pool->work_cv);
+  }
+  pthread_mutex_unlock(&pool->mu);
+  return true;
+}
+
+/* Each statvfs gets timeout_ms from the moment a worker picks it up; a job still queued
+ * timeout_ms after the batch was launched (every worker busy or hung) is given up on too. */
+static void wait_for_jobs(storage_state_t *st) {
+  const uint64_t timeout_ns = (uint64_t)st->timeout_ms * SYSMON_NS_PER_MS;
+  const uint64_t queued_deadline = sysmon_now_ns(false) + timeout_ns;
+
+  pthread_mutex_lock(&st->pool->mu);
+  for (;;) {
+    const uint64_t now = sysmon_now_ns(false);
+    uint64_t next = UINT64_MAX;
+    for (size_t i = 0; i < st->mount_count; i++) {
+      const storage_mount_t *m = &st->mounts[i];
+      if (!m->launched || m->job->done) continue;
+      const uint64_t deadline = m->job->started ? m->job->start_ns + timeout_ns : queued_deadline;
+      if (deadline > now && deadline < next) next = deadline;
+    }
+    if (next == UINT64_MAX) break;
+    const struct timespec ts = {.tv_sec = (time_t)(next / SYSMON_NS_PER_SEC),
+                                .tv_nsec = (long)(next % SYSMON_NS_PER_SEC)};
+    pthread_cond_timedwait(&st->pool->done_cv, &st->pool->mu, &ts);
+  }
+  for (size_t i = 0; i < st->mount_count; i++) {
+    storage_mount_t *m = &st->mounts[i];
+    if (!m->launched) continue;
+    m->launched = false;
+    m->timed_out = !m->job->done;
+    if (m->timed_out) continue;
+    m->err = m->job->err;
+    if (m->err != 0) continue;
+    usage_from_statvfs(&m->job->vfs, &m->usage);
+    m->has_data = true;
+  }
+  pthread_mutex_unlock(&st->pool->mu);
+}
+
+static bool refresh_mount_usage(storage_state_t *st) {
+  for (size_t i = 0; i < st->mount_count; i++) {
+    storage_mount_t *m = &st->mounts[i];
+    if (m->job) {
+      pthread_mutex_lock(&st->pool->mu);
+      const bool busy = !m->job->done;
+      pthread_mutex_unlock(&st->pool->mu);
+      /* Never queue a second statvfs on a mount whose previous one is still hung or queued. */
+      if (busy) {
+        m->timed_out = true;
+        continue;
+      }
+      /* A job that missed its deadline still delivers a (late) sample. */
+      if (m->timed_out) {
+        m->err = m->job->err;
+        if (m->err == 0) {
+          usage_from_statvfs(&m->job->vfs, &m->usage);
+          m->has_data = true;
+        }
+      }
+      release_job(st->pool, m->job);
+      m->job = NULL;
+    }
+    if (!launch_job(st, m)) return false;
+  }
+  wait_for_jobs(st);
+  return true;
+}
+
+/* mountinfo escapes blanks and backslashes as \ooo. */
+static size_t unescape_field(const char *src, size_t len, char *dst, size_t dst_len) {
+  size_t n = 0;
+  for (size_t i = 0; i < len && n + 1 < dst_len; i++) {
+    if (src[i] == '\\' && i + 3 < len && src[i + 1] >= '0' && src[i + 1] <= '3' &&
+        src[i + 2] >= '0' && src[i + 2] <= '7' && src[i + 3] >= '0' && src[i + 3] <= '7') {
+      dst[n++] = (char)(((src[i + 1] - '0') << 6) | ((src[i + 2] - '0') << 3) | (src[i + 3] - '0'));
+      i += 3;
+    } else {
+      dst[n++] = src[i];
+    }
+  }
+  dst[n] = '\0';
+  return n;
+}
+
+static const char *next_field(const char *p, const char **out_start, size_t *out_len) {
+  while (*p == ' ') p++;
+  *out_start = p;
+  while (*p && *p != ' ' && *p != '\n') p++;
+  *out_len = (size_t)(p - *out_start);
+  return p;
+}
+
+static bool mount_selected(const storage_state_t *st, const char *path, const char *fstype) {
+  if (st->fstypes && !sysmon_glob_list_match(st->fstypes, fstype, 0)) return false;
+  if (st->exclude_fstypes && sysmon_glob_list_match(st->exclude_fstypes, fstype, 0)) return false;
+  if (st->paths && !sysmon_glob_list_match(st->paths, path, 0)) return false;
+  return !st->exclude_paths || !sysmon_glob_list_match(st->exclude_paths, path, 0);
+}
+
+/* "36 35 98:0 /mnt1 /mnt/parent rw,noatime master:1 - ext3 /dev/root rw,errors=continue" */
+static bool load_mounts(storage_state_t *st, char **out_error) {
+  if (!sysmon_file_read(&st->mountinfo)) {
+    sysmon_set_error(out_error, "failed to read mountinfo");
+    return false;
+  }
+  size_t lines = 0;
+  for (const char *p = st->mountinfo.buf; *p; p++) lines += *p == '\n';
+  storage_mount_t *mounts = (storage_mount_t *)calloc(lines + 1, sizeof(*mounts));
+  if (!mounts) {
+    sysmon_set_error(out_error, "out of memory loading mounts");
+    return false;
+  }
+
+  size_t count = 0;
+  for (const char *line = st->mountinfo.buf; *line;) {
+    const char *eol = strchr(line, '\n');
+    if (!eol) eol = line + strlen(line);
+    const char *f[5];
+    size_t flen[5];
+    const char *p = line;
+    for (size_t i = 0; i < 5; i++) p = next_field(p, &f[i], &flen[i]);
+    const char *sep = strstr(p, " - ");
+    if (sep && sep < eol) {
+      const char *fstype;
+      size_t fstype_len;
+      next_field(sep + 3, &fstype, &fstype_len);
+      storage_mount_t *m = &mounts[count];
+      unescape_field(f[4], flen[4], m->path, sizeof(m->path));
+      if (fstype_len >= sizeof(m->fstype)) fstype_len = sizeof(m->fstype) - 1;
+      memcpy(m->fstype, fstype, fstype_len);
+      m->fstype[fstype_len] = '\0';
+      unsigned major = 0, minor = 0;
+      sscanf(f[2], "%u:%u", &major, &minor);
+      m->dev = (uint64_t)major << 32 | minor;
+
+      bool keep = mount_selected(st, m->path, m->fstype);
+      /* One entry per filesystem unless bind_mounts=1: later mount points of the same device
+       * (bind mounts) are dropped in favour of the first one. */
+      for (size_t i = 0; keep && !st->bind_mounts && i < count; i++) keep = mounts[i].dev != m->dev;
+      if (keep) count++;
+    }
+    line = *eol ? eol + 1 : eol;
+  }
+
+  /* Carry over cached values and any still-running worker for mounts that survived. */
+  for (size_t i = 0; i < count; i++) {
+    for (size_t j = 0; j < st->mount_count; j++) {
+      storage_mount_t *old = &st->mounts[j];
+      if (old->dev != mounts[i].dev || strcmp(old->path, mounts[i].path) != 0) continue;
+      mounts[i].job = old->job;
+      mounts[i].usage = old->usage;
+      mounts[i].has_data = old->has_data;
+      mounts[i].timed_out = old->timed_out;
+      mounts[i].err = old->err;
+      old->job = NULL;
+      break;
+    }
+  }
+  for (size_t j = 0; j < st->mount_count; j++) {
+    if (st->mounts[j].job) release_job(st->pool, st->mounts[j].job);
+  }
+  free(st->mounts);
+  st->mounts = mounts;
+  st->mount_count = count;
+  return true;
+}
+
+static sysmon_result_t poll_mounts(storage_state_t *st, uint64_t now_ns, bool refresh_now,
+                                   sysmon_snapshot_builder_t *builder, char **out_error) {
+  const bool reload = !st->has_data || mount_table_changed(st);
+  if (reload && !load_mounts(st, out_error)) return SYSMON_ERR_IO;
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, reload) && !refresh_mount_usage(st)) {
+    sysmon_set_error(out_error, "out of memory starting statvfs workers");
+    return SYSMON_ERR_OUT_OF_MEMORY;
+  }
+  st->has_data = true;
+
+  uint64_t reported = 0, timed_out = 0;
+  char prefix[SYSMON_STORAGE_PATH_LEN + 16], name[SYSMON_STORAGE_PATH_LEN + 64];
+  for (size_t i = 0; i < st->mount_count; i++) {
+    const storage_mount_t *m = &st->mounts[i];
+    if (m->timed_out) timed_out++;
+    snprintf(prefix, sizeof(prefix), "storage.%s", m->path);
+    snprintf(name, sizeof(name), "%s.fstype", prefix);
+    sysmon_result_t rc = sysmon_snapshot_builder_add_string(builder, name, NULL, m->fstype);
+    if (rc != SYSMON_OK) return rc;
+    snprintf(name, sizeof(name), "%s.timed_out", prefix);
+    rc = sysmon_snapshot_builder_add_i64(builder, name, NULL, m->timed_out ? 1 : 0);
+    if (rc != SYSMON_OK) return rc;
+    /* A mount that never answered, or whose statvfs fails, is still listed by name. */
+    if (m->err != 0) {
+      snprintf(name, sizeof(name), "%s.error", prefix);
+      rc = sysmon_snapshot_builder_add_string(builder, name, NULL, strerror(m->err));
+      if (rc != SYSMON_OK) return rc;
+    }
+    if (!m->has_data) continue;
+    rc = add_usage_metrics(builder, prefix, &m->usage);
+    if (rc != SYSMON_OK) return rc;
+    reported++;
+  }
+  sysmon_result_t rc = sysmon_snapshot_builder_add_u64(builder, "storage.mount_count", NULL, reported);
+  if (rc != SYSMON_OK) return rc;
+  return sysmon_snapshot_builder_add_u64(builder, "storage.timed_out_count", NULL, timed_out);
+}
+#endif
+
+static bool read_storage_stats(const storage_state_t *st, storage_usage_t *out, char **out_error) {
+#if defined(__APPLE__) || defined(__linux__)
+  if (!st || !out) return false;
+  struct statvfs vfs;
+#if defined(__linux__)
+  const char *fn = "fstatvfs";
+  const int vrc = fstatvfs(st->path_fd, &vfs);
+#else
+  const char *fn = "statvfs";
+  const int vrc = statvfs(st->path, &vfs);
+#endif
+  if (vrc != 0) {
+    char buf[SYSMON_STORAGE_PATH_LEN + 64];
+    snprintf(buf, sizeof(buf), "%s(%s) failed: %s", fn, st->path, strerror(errno));
     sysmon_set_error(out_error, buf);
     return false;
   }
-  const uint64_t block_size = vfs.f_frsize ? (uint64_t)vfs.f_frsize : (uint64_t)vfs.f_bsize;
-  *out_total = (uint64_t)vfs.f_blocks * block_size;
-  *out_free = (uint64_t)vfs.f_bfree * block_size;
-  *out_avail = (uint64_t)vfs.f_bavail * block_size;
+  usage_from_statvfs(&vfs, out);
   return true;
 #else
-  (void)path;
-  (void)out_total;
-  (void)out_free;
-  (void)out_avail;
+  (void)st;
+  (void)out;
   sysmon_set_error(out_error, "storage module not supported on this platform");
   return false;
 #endif
 }
 
-static sysmon_result_t storage_create(const sysmon_ini_t *ini, const char *section,
-                                      void **out_state, char **out_error) {
+static void storage_destroy(void *state) {
+  storage_state_t *st = (storage_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  if (st->path_fd >= 0) close(st->path_fd);
+  sysmon_file_close(&st->mountinfo);
+  for (size_t i = 0; i < st->mount_count; i++) {
+    if (st->mounts[i].job) release_job(st->pool, st->mounts[i].job);
+  }
+  if (st->pool) stop_pool(st->pool);
+  free(st->mounts);
+  free(st->fstypes);
+  free(st->exclude_fstypes);
+  free(st->paths);
+  free(st->exclude_paths);
+#endif
+  free(st);
+}
+
+#if defined(__linux__)
+static bool dup_option(const sysmon_ini_t *ini, const char *section, const char *key,
+                       const char *default_value, char **out) {
+  const char *v = sysmon_ini_get(ini, section, key);
+  if (!v) v = default_value;
+  *out = v && *v ? sysmon_strdup(v) : NULL;
+  return !(v && *v) || *out;
+}
+
+static sysmon_result_t create_mounts_mode(storage_state_t *st, const sysmon_ini_t *ini,
+                                          const char *section, char **out_error) {
+  bool ok = true;
+  st->timeout_ms = sysmon_ini_get_u32(ini, section, "timeout_ms", 1000, &ok);
+  if (!ok || st->timeout_ms == 0) {
+    sysmon_set_error(out_error, "invalid timeout_ms (must be > 0)");
+    return SYSMON_ERR_PARSE;
+  }
+  const uint32_t workers = sysmon_ini_get_u32(ini, section, "workers", 4, &ok);
+  if (!ok || workers == 0) {
+    sysmon_set_error(out_error, "invalid workers (must be > 0)");
+    return SYSMON_ERR_PARSE;
+  }
+  st->bind_mounts = sysmon_ini_get_bool(ini, section, "bind_mounts", false);
+  if (!dup_option(ini, section, "fstypes", NULL, &st->fstypes) ||
+      !dup_option(ini, section, "exclude_fstypes", SYSMON_STORAGE_DEFAULT_EXCLUDE_FSTYPES,
+                  &st->exclude_fstypes) ||
+      !dup_option(ini, section, "paths", NULL, &st->paths) ||
+      !dup_option(ini, section, "exclude_paths", NULL, &st->exclude_paths) ||
+      !(st->pool = create_pool(workers)))
+    return SYSMON_ERR_OUT_OF_MEMORY;
+  if (st->mountinfo.fd < 0) {
+    sysmon_set_error(out_error, "failed to open mountinfo");
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+  st->all_mounts = true;
+  return SYSMON_OK;
+}
+#endif
+
+static sysmon_result_t storage_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                      const char *section, void **out_state, char **out_error) {
   if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
 
   storage_state_t *st = (storage_state_t *)calloc(1, sizeof(*st));
@@ -67,12 +626,50 @@ static sysmon_result_t storage_create(const sysmon_ini_t *ini, const char *secti
   if (!path || !*path) path = "/";
   copy_path(st->path, sizeof(st->path), path);
 
-  uint64_t total = 0, free_b = 0, avail = 0;
+  const char *mode = sysmon_ini_get(ini, section, "mode");
+  const bool mounts_mode = mode && strcmp(mode, "mounts") == 0;
+  if (mode && *mode && !mounts_mode && strcmp(mode, "path") != 0) {
+    sysmon_set_error(out_error, "invalid mode (must be path|mounts)");
+    free(st);
+    return SYSMON_ERR_PARSE;
+  }
+
   char *err = NULL;
-  if (!read_storage_stats(st->path, &total, &free_b, &avail, &err)) {
+#if !defined(__linux__)
+  (void)paths;
+  if (mounts_mode) {
+    sysmon_set_error(out_error, "storage mode=mounts not supported on this platform");
+    free(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+#else
+  st->path_fd = -1;
+  char mountinfo_path[SYSMON_PATH_LEN];
+  sysmon_proc_path(paths, "self/mountinfo", mountinfo_path, sizeof(mountinfo_path));
+  sysmon_file_init(&st->mountinfo);
+  sysmon_file_open(&st->mountinfo, mountinfo_path);
+  if (mounts_mode) {
+    const sysmon_result_t rc = create_mounts_mode(st, ini, section, out_error);
+    if (rc != SYSMON_OK) {
+      storage_destroy(st);
+      return rc;
+    }
+    *out_state = st;
+    return SYSMON_OK;
+  }
+  if (!open_path_fd(st->path, &st->path_fd, &err)) {
+    sysmon_set_error(out_error, err ? err : "failed to open storage path");
+    free(err);
+    storage_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+#endif
+
+  storage_usage_t usage;
+  if (!read_storage_stats(st, &usage, &err)) {
     sysmon_set_error(out_error, err ? err : "failed to read storage stats");
     free(err);
-    free(st);
+    storage_destroy(st);
     return SYSMON_ERR_NOT_SUPPORTED;
   }
   free(err);
@@ -82,50 +679,47 @@ static sysmon_result_t storage_create(const sysmon_ini_t *ini, const char *secti
   return SYSMON_OK;
 }
 
-static sysmon_result_t storage_poll(void *state, uint64_t now_ms, bool refresh_now,
+static sysmon_result_t storage_poll(void *state, uint64_t now_ns, bool refresh_now,
                                     sysmon_snapshot_builder_t *builder, char **out_error) {
-  (void)now_ms;
   storage_state_t *st = (storage_state_t *)state;
   if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  if (st->all_mounts) return poll_mounts(st, now_ns, refresh_now, builder, out_error);
+#endif
 
-  if (refresh_now || !st->has_data) {
-    uint64_t total = 0, free_b = 0, avail = 0;
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
     char *err = NULL;
-    if (!read_storage_stats(st->path, &total, &free_b, &avail, &err)) {
+#if defined(__linux__)
+    if ((st->path_fd < 0 || mount_table_changed(st)) && !reresolve_path(st, &err)) {
+      sysmon_set_error(out_error, err ? err : "failed to re-resolve storage path");
+      free(err);
+      return SYSMON_ERR_IO;
+    }
+#endif
+    if (!read_storage_stats(st, &st->last, &err)) {
       sysmon_set_error(out_error, err ? err : "failed to read storage stats");
       free(err);
       return SYSMON_ERR_IO;
     }
     free(err);
-
-    st->last_total_bytes = total;
-    st->last_free_bytes = free_b;
-    st->last_avail_bytes = avail;
-    st->last_used_bytes = total >= free_b ? (total - free_b) : 0;
-    st->last_used_percent =
-        total > 0 ? (double)st->last_used_bytes * 100.0 / (double)total : 0.0;
     st->has_data = true;
   }
 
   sysmon_result_t rc = sysmon_snapshot_builder_add_string(builder, "storage.path", NULL, st->path);
   if (rc != SYSMON_OK) return rc;
-  rc = sysmon_snapshot_builder_add_u64(builder, "storage.total_bytes", "B", st->last_total_bytes);
-  if (rc != SYSMON_OK) return rc;
-  rc = sysmon_snapshot_builder_add_u64(builder, "storage.used_bytes", "B", st->last_used_bytes);
-  if (rc != SYSMON_OK) return rc;
-  rc = sysmon_snapshot_builder_add_u64(builder, "storage.free_bytes", "B", st->last_free_bytes);
-  if (rc != SYSMON_OK) return rc;
-  rc = sysmon_snapshot_builder_add_u64(builder, "storage.available_bytes", "B", st->last_avail_bytes);
-  if (rc != SYSMON_OK) return rc;
-  rc = sysmon_snapshot_builder_add_double(builder, "storage.used_percent", "%", st->last_used_percent);
-  if (rc != SYSMON_OK) return rc;
-  return SYSMON_OK;
+  return add_usage_metrics(builder, "storage", &st->last);
 }
 
-static void storage_destroy(void *state) { free(state); }
-
 const sysmon_module_vtable_t *sysmon_storage_module(void) {
   static const sysmon_module_vtable_t vtable = {
-      .name = "storage", .create = storage_create, .poll = storage_poll, .destroy = storage_destroy};
+      .name = "storage",
+      .create = storage_create,
+      .poll = storage_poll,
+      .destroy = storage_destroy,
+#if defined(__linux__)
+      .event_sources = storage_event_sources,
+      .on_event = storage_on_event,
+#endif
+  };
   return &vtable;
 }
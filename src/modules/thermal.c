@@ -0,0 +1,350 @@
+#include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define THERMAL_TYPE_LEN 32
+
+typedef struct thermal_cpu {
+  int id;
+  uint64_t package_id;
+  uint64_t core_id;
+  int freq_fd;
+  int core_throttle_fd;
+  int package_throttle_fd;
+  uint64_t max_khz;
+  uint64_t cur_khz;
+  uint64_t core_throttle;
+  uint64_t package_throttle;
+  bool valid;
+} thermal_cpu_t;
+
+typedef struct thermal_zone {
+  int index;
+  int temp_fd;
+  char type[THERMAL_TYPE_LEN];
+  double temp_c;
+  bool valid;
+} thermal_zone_t;
+
+typedef struct thermal_state {
+  thermal_cpu_t *cpus;
+  size_t cpu_count;
+  size_t freq_count;
+  thermal_zone_t *zones;
+  size_t zone_count;
+  bool per_cpu;
+  bool has_throttle;
+  double freq_min_mhz;
+  double freq_avg_mhz;
+  double freq_max_mhz;
+  double freq_avg_percent;
+  uint64_t core_throttle_total;
+  uint64_t package_throttle_total;
+  double core_throttle_rate;
+  double package_throttle_rate;
+  uint64_t last_ts_ns;
+  bool has_data;
+} thermal_state_t;
+
+#if defined(__linux__)
+static int open_sys(const sysmon_paths_t *paths, const char *rel) {
+  char path[SYSMON_PATH_LEN];
+  sysmon_sys_path(paths, rel, path, sizeof(path));
+  return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+static uint64_t read_once(const sysmon_paths_t *paths, const char *rel) {
+  const int fd = open_sys(paths, rel);
+  int64_t v = 0;
+  if (fd < 0) return 0;
+  if (!sysmon_pread_i64(fd, &v) || v < 0) v = 0;
+  close(fd);
+  return (uint64_t)v;
+}
+
+static int cmp_zone(const void *a, const void *b) {
+  return ((const thermal_zone_t *)a)->index - ((const thermal_zone_t *)b)->index;
+}
+
+static bool open_zones(thermal_state_t *st, const sysmon_paths_t *paths) {
+  char dir[SYSMON_PATH_LEN];
+  sysmon_sys_path(paths, "class/thermal", dir, sizeof(dir));
+  DIR *d = opendir(dir);
+  if (!d) return true;
+  size_t cap = 0;
+  struct dirent *de;
+  while ((de = readdir(d)) != NULL) {
+    if (strncmp(de->d_name, "thermal_zone", 12) != 0) continue;
+    const char *idx = de->d_name + 12;
+    uint64_t index = 0;
+    if (!sysmon_parse_u64(&idx, &index) || *idx) continue;
+
+    char rel[SYSMON_PATH_LEN];
+    snprintf(rel, sizeof(rel), "class/thermal/%s/temp", de->d_name);
+    const int fd = open_sys(paths, rel);
+    if (fd < 0) continue;
+    if (st->zone_count == cap) {
+      cap = cap ? cap * 2 : 16;
+      thermal_zone_t *grown = (thermal_zone_t *)realloc(st->zones, cap * sizeof(*grown));
+      if (!grown) {
+        close(fd);
+        closedir(d);
+        return false;
+      }
+      st->zones = grown;
+    }
+    thermal_zone_t *z = &st->zones[st->zone_count++];
+    memset(z, 0, sizeof(*z));
+    z->index = (int)index;
+    z->temp_fd = fd;
+    snprintf(rel, sizeof(rel), "class/thermal/%s/type", de->d_name);
+    const int type_fd = open_sys(paths, rel);
+    ssize_t n = type_fd >= 0 ? pread(type_fd, z->type, sizeof(z->type) - 1, 0) : -1;
+    if (type_fd >= 0) close(type_fd);
+    if (n < 0) n = 0;
+    while (n > 0 && (z->type[n - 1] == '\n' || z->type[n - 1] == ' ')) n--;
+    z->type[n] = '\0';
+  }
+  closedir(d);
+  if (st->zone_count > 1) qsort(st->zones, st->zone_count, sizeof(*st->zones), cmp_zone);
+  return true;
+}
+
+static void sample(thermal_state_t *st, double seconds) {
+  uint64_t sum = 0, min = UINT64_MAX, max = 0, core = 0, package = 0;
+  double pct = 0.0;
+  size_t n = 0, n_pct = 0;
+  for (size_t i = 0; i < st->cpu_count; i++) {
+    thermal_cpu_t *c = &st->cpus[i];
+    int64_t v = 0;
+    c->valid = c->freq_fd >= 0 && sysmon_pread_i64(c->freq_fd, &v) && v > 0;
+    if (c->valid) {
+      c->cur_khz = (uint64_t)v;
+      sum += c->cur_khz;
+      if (c->cur_khz < min) min = c->cur_khz;
+      if (c->cur_khz > max) max = c->cur_khz;
+      n++;
+      if (c->max_khz) {
+        pct += (double)c->cur_khz * 100.0 / (double)c->max_khz;
+        n_pct++;
+      }
+    }
+    if (c->core_throttle_fd >= 0 && sysmon_pread_i64(c->core_throttle_fd, &v) && v >= 0)
+      c->core_throttle = (uint64_t)v;
+    if (c->package_throttle_fd >= 0 && sysmon_pread_i64(c->package_throttle_fd, &v) && v >= 0)
+      c->package_throttle = (uint64_t)v;
+    core += c->core_throttle;
+    package += c->package_throttle;
+  }
+  st->freq_count = n;
+  st->freq_min_mhz = n ? (double)min / 1000.0 : 0.0;
+  st->freq_max_mhz = (double)max / 1000.0;
+  st->freq_avg_mhz = n ? (double)sum / (double)n / 1000.0 : 0.0;
+  st->freq_avg_percent = n_pct ? pct / (double)n_pct : 0.0;
+
+  st->core_throttle_rate =
+      seconds > 0.0 && core >= st->core_throttle_total
+          ? (double)(core - st->core_throttle_total) / seconds
+          : 0.0;
+  st->package_throttle_rate =
+      seconds > 0.0 && package >= st->package_throttle_total
+          ? (double)(package - st->package_throttle_total) / seconds
+          : 0.0;
+  st->core_throttle_total = core;
+  st->package_throttle_total = package;
+
+  for (size_t i = 0; i < st->zone_count; i++) {
+    thermal_zone_t *z = &st->zones[i];
+    int64_t v = 0;
+    z->valid = sysmon_pread_i64(z->temp_fd, &v);
+    z->temp_c = z->valid ? (double)v / 1000.0 : 0.0;
+  }
+}
+#endif
+
+static void thermal_destroy(void *state) {
+  thermal_state_t *st = (thermal_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  for (size_t i = 0; i < st->cpu_count; i++) {
+    sysmon_close_fd(&st->cpus[i].freq_fd);
+    sysmon_close_fd(&st->cpus[i].core_throttle_fd);
+    sysmon_close_fd(&st->cpus[i].package_throttle_fd);
+  }
+  for (size_t i = 0; i < st->zone_count; i++) sysmon_close_fd(&st->zones[i].temp_fd);
+#endif
+  free(st->cpus);
+  free(st->zones);
+  free(st);
+}
+
+static sysmon_result_t thermal_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                      const char *section, void **out_state, char **out_error) {
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  thermal_state_t *st = (thermal_state_t *)calloc(1, sizeof(*st));
+  if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+  st->per_cpu = sysmon_ini_get_bool(ini, section, "per_cpu", false);
+
+  char path[SYSMON_PATH_LEN];
+  sysmon_sys_path(paths, "devices/system/cpu/online", path, sizeof(path));
+  int *ids = NULL;
+  size_t n = 0;
+  if (!sysmon_read_id_list(path, &ids, &n)) n = 0;
+  st->cpus = n ? (thermal_cpu_t *)calloc(n, sizeof(*st->cpus)) : NULL;
+  if (n && !st->cpus) {
+    free(ids);
+    thermal_destroy(st);
+    return SYSMON_ERR_OUT_OF_MEMORY;
+  }
+
+  size_t freq_files = 0;
+  for (size_t i = 0; i < n; i++) {
+    thermal_cpu_t *c = &st->cpus[st->cpu_count++];
+    char rel[128];
+    c->id = ids[i];
+    snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq", c->id);
+    c->freq_fd = open_sys(paths, rel);
+    /* package_throttle_count is one counter per package mirrored on each of its CPUs, and
+     * core_throttle_count one per core mirrored on its SMT siblings, so each is only read
+     * from the first online CPU of its physical_package_id (and core_id). */
+    snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/topology/physical_package_id", c->id);
+    c->package_id = read_once(paths, rel);
+    snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/topology/core_id", c->id);
+    c->core_id = read_once(paths, rel);
+    bool first_in_package = true, first_in_core = true;
+    for (size_t j = 0; j + 1 < st->cpu_count && first_in_core; j++) {
+      if (st->cpus[j].package_id != c->package_id) continue;
+      first_in_package = false;
+      first_in_core = st->cpus[j].core_id != c->core_id;
+    }
+    c->core_throttle_fd = -1;
+    if (first_in_core) {
+      snprintf(rel, sizeof(rel),
+               "devices/system/cpu/cpu%d/thermal_throttle/core_throttle_count", c->id);
+      c->core_throttle_fd = open_sys(paths, rel);
+    }
+    c->package_throttle_fd = -1;
+    if (first_in_package) {
+      snprintf(rel, sizeof(rel),
+               "devices/system/cpu/cpu%d/thermal_throttle/package_throttle_count", c->id);
+      c->package_throttle_fd = open_sys(paths, rel);
+    }
+    snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", c->id);
+    c->max_khz = c->freq_fd >= 0 ? read_once(paths, rel) : 0;
+    if (c->freq_fd >= 0) freq_files++;
+    if (c->core_throttle_fd >= 0 || c->package_throttle_fd >= 0) st->has_throttle = true;
+  }
+  free(ids);
+
+  if (!open_zones(st, paths)) {
+    thermal_destroy(st);
+    return SYSMON_ERR_OUT_OF_MEMORY;
+  }
+  if (freq_files == 0 && st->zone_count == 0 && !st->has_throttle) {
+    sysmon_set_error(out_error, "no cpufreq, thermal zone or throttle counters in sysfs");
+    thermal_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)paths;
+  (void)ini;
+  (void)section;
+  sysmon_set_error(out_error, "thermal module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static sysmon_result_t thermal_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                    sysmon_snapshot_builder_t *builder, char **out_error) {
+  (void)out_error;
+  thermal_state_t *st = (thermal_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+
+#if defined(__linux__)
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
+    const double seconds = st->has_data && now_ns > st->last_ts_ns
+                               ? (double)(now_ns - st->last_ts_ns) / (double)SYSMON_NS_PER_SEC
+                               : 0.0;
+    sample(st, seconds);
+    st->last_ts_ns = now_ns;
+    st->has_data = true;
+  }
+
+  sysmon_result_t rc;
+  char name[96];
+  if (st->freq_count > 0) {
+    rc = sysmon_snapshot_builder_add_double(builder, "thermal.freq_min_mhz", "MHz", st->freq_min_mhz);
+    if (rc != SYSMON_OK) return rc;
+    rc = sysmon_snapshot_builder_add_double(builder, "thermal.freq_avg_mhz", "MHz", st->freq_avg_mhz);
+    if (rc != SYSMON_OK) return rc;
+    rc = sysmon_snapshot_builder_add_double(builder, "thermal.freq_max_mhz", "MHz", st->freq_max_mhz);
+    if (rc != SYSMON_OK) return rc;
+    rc = sysmon_snapshot_builder_add_double(builder, "thermal.freq_avg_percent", "%",
+                                            st->freq_avg_percent);
+    if (rc != SYSMON_OK) return rc;
+    for (size_t i = 0; st->per_cpu && i < st->cpu_count; i++) {
+      const thermal_cpu_t *c = &st->cpus[i];
+      if (!c->valid) continue;
+      snprintf(name, sizeof(name), "thermal.cpu.%d.freq_mhz", c->id);
+      rc = sysmon_snapshot_builder_add_double(builder, name, "MHz", (double)c->cur_khz / 1000.0);
+      if (rc != SYSMON_OK) return rc;
+    }
+  }
+  if (st->has_throttle) {
+    rc = sysmon_snapshot_builder_add_u64(builder, "thermal.core_throttle_count", NULL,
+                                         st->core_throttle_total);
+    if (rc != SYSMON_OK) return rc;
+    rc = sysmon_snapshot_builder_add_double(builder, "thermal.core_throttle_per_sec", "/s",
+                                            st->core_throttle_rate);
+    if (rc != SYSMON_OK) return rc;
+    rc = sysmon_snapshot_builder_add_double(builder, "thermal.package_throttle_per_sec", "/s",
+                                            st->package_throttle_rate);
+    if (rc != SYSMON_OK) return rc;
+  }
+
+  const thermal_zone_t *hottest = NULL;
+  for (size_t i = 0; i < st->zone_count; i++) {
+    const thermal_zone_t *z = &st->zones[i];
+    if (!z->valid) continue;
+    if (!hottest || z->temp_c > hottest->temp_c) hottest = z;
+    snprintf(name, sizeof(name), "thermal.zone.%d.temp_c", z->index);
+    rc = sysmon_snapshot_builder_add_double(builder, name, "C", z->temp_c);
+    if (rc != SYSMON_OK) return rc;
+    snprintf(name, sizeof(name), "thermal.zone.%d.type", z->index);
+    rc = sysmon_snapshot_builder_add_string(builder, name, NULL, z->type);
+    if (rc != SYSMON_OK) return rc;
+  }
+  if (!hottest) return SYSMON_OK;
+  rc = sysmon_snapshot_builder_add_double(builder, "thermal.max_temp_c", "C", hottest->temp_c);
+  if (rc != SYSMON_OK) return rc;
+  return sysmon_snapshot_builder_add_string(builder, "thermal.hottest_zone", NULL, hottest->type);
+#else
+  (void)now_ns;
+  (void)refresh_now;
+  sysmon_set_error(out_error, "thermal module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_thermal_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "thermal",
+      .create = thermal_create,
+      .poll = thermal_poll,
+      .destroy = thermal_destroy,
+  };
+  return &vtable;
+}
@@ -0,0 +1,314 @@
+#include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VMSTAT_SLOT_BITS 8
+#define VMSTAT_SLOTS (1u << VMSTAT_SLOT_BITS)
+#define VMSTAT_NONE 0xff
+
+typedef struct vmstat_counter {
+  const char *name;
+  bool gauge; /* current value rather than a monotonic event count */
+} vmstat_counter_t;
+
+enum {
+  VM_PGFAULT,
+  VM_PGMAJFAULT,
+  VM_PGPGIN,
+  VM_PGPGOUT,
+  VM_PSWPIN,
+  VM_PSWPOUT,
+  VM_ALLOCSTALL,
+  VM_PGSCAN,
+  VM_PGSCAN_KSWAPD,
+  VM_PGSCAN_DIRECT,
+  VM_PGSTEAL,
+  VM_PGSTEAL_KSWAPD,
+  VM_PGSTEAL_DIRECT,
+  VM_PGREFILL,
+  VM_OOM_KILL,
+  VM_COMPACT_STALL,
+  VM_THP_FAULT_ALLOC,
+  VM_THP_FAULT_FALLBACK,
+  VM_WORKINGSET_REFAULT,
+  VM_NR_DIRTY,
+  VM_NR_WRITEBACK,
+  VM_COUNTERS
+};
+
+static const vmstat_counter_t vmstat_counters[VM_COUNTERS] = {
+    [VM_PGFAULT] = {"pgfault", false},
+    [VM_PGMAJFAULT] = {"pgmajfault", false},
+    [VM_PGPGIN] = {"pgpgin", false},
+    [VM_PGPGOUT] = {"pgpgout", false},
+    [VM_PSWPIN] = {"pswpin", false},
+    [VM_PSWPOUT] = {"pswpout", false},
+    [VM_ALLOCSTALL] = {"allocstall", false},
+    [VM_PGSCAN] = {"pgscan", false},
+    [VM_PGSCAN_KSWAPD] = {"pgscan_kswapd", false},
+    [VM_PGSCAN_DIRECT] = {"pgscan_direct", false},
+    [VM_PGSTEAL] = {"pgsteal", false},
+    [VM_PGSTEAL_KSWAPD] = {"pgsteal_kswapd", false},
+    [VM_PGSTEAL_DIRECT] = {"pgsteal_direct", false},
+    [VM_PGREFILL] = {"pgrefill", false},
+    [VM_OOM_KILL] = {"oom_kill", false},
+    [VM_COMPACT_STALL] = {"compact_stall", false},
+    [VM_THP_FAULT_ALLOC] = {"thp_fault_alloc", false},
+    [VM_THP_FAULT_FALLBACK] = {"thp_fault_fallback", false},
+    [VM_WORKINGSET_REFAULT] = {"workingset_refault", false},
+    [VM_NR_DIRTY] = {"nr_dirty", true},
+    [VM_NR_WRITEBACK] = {"nr_writeback", true},
+};
+
+/* /proc/vmstat keys feeding each counter; a key may also feed an aggregate (e.g. pgscan). */
+typedef struct vmstat_key {
+  const char *key;
+  uint8_t counter;
+  uint8_t total;
+} vmstat_key_t;
+
+static const vmstat_key_t vmstat_keys[] = {
+    {"pgfault", VM_PGFAULT, VMSTAT_NONE},
+    {"pgmajfault", VM_PGMAJFAULT, VMSTAT_NONE},
+    {"pgpgin", VM_PGPGIN, VMSTAT_NONE},
+    {"pgpgout", VM_PGPGOUT, VMSTAT_NONE},
+    {"pswpin", VM_PSWPIN, VMSTAT_NONE},
+    {"pswpout", VM_PSWPOUT, VMSTAT_NONE},
+    {"allocstall", VM_ALLOCSTALL, VMSTAT_NONE}, /* before 4.8 */
+    {"allocstall_dma", VM_ALLOCSTALL, VMSTAT_NONE},
+    {"allocstall_dma32", VM_ALLOCSTALL, VMSTAT_NONE},
+    {"allocstall_normal", VM_ALLOCSTALL, VMSTAT_NONE},
+    {"allocstall_movable", VM_ALLOCSTALL, VMSTAT_NONE},
+    {"allocstall_device", VM_ALLOCSTALL, VMSTAT_NONE},
+    {"pgscan_kswapd", VM_PGSCAN_KSWAPD, VM_PGSCAN},
+    {"pgscan_direct", VM_PGSCAN_DIRECT, VM_PGSCAN},
+    {"pgscan_khugepaged", VM_PGSCAN, VMSTAT_NONE},
+    {"pgscan_proactive", VM_PGSCAN, VMSTAT_NONE},
+    {"pgsteal_kswapd", VM_PGSTEAL_KSWAPD, VM_PGSTEAL},
+    {"pgsteal_direct", VM_PGSTEAL_DIRECT, VM_PGSTEAL},
+    {"pgsteal_khugepaged", VM_PGSTEAL, VMSTAT_NONE},
+    {"pgsteal_proactive", VM_PGSTEAL, VMSTAT_NONE},
+    {"pgrefill", VM_PGREFILL, VMSTAT_NONE},
+    {"oom_kill", VM_OOM_KILL, VMSTAT_NONE},
+    {"compact_stall", VM_COMPACT_STALL, VMSTAT_NONE},
+    {"thp_fault_alloc", VM_THP_FAULT_ALLOC, VMSTAT_NONE},
+    {"thp_fault_fallback", VM_THP_FAULT_FALLBACK, VMSTAT_NONE},
+    {"workingset_refault", VM_WORKINGSET_REFAULT, VMSTAT_NONE}, /* before 5.9 */
+    {"workingset_refault_anon", VM_WORKINGSET_REFAULT, VMSTAT_NONE},
+    {"workingset_refault_file", VM_WORKINGSET_REFAULT, VMSTAT_NONE},
+    {"nr_dirty", VM_NR_DIRTY, VMSTAT_NONE},
+    {"nr_writeback", VM_NR_WRITEBACK, VMSTAT_NONE},
+};
+
+#define VMSTAT_KEY_COUNT (sizeof(vmstat_keys) / sizeof(vmstat_keys[0]))
+
+static const char *const vmstat_default_counters =
+    "pgfault,pgmajfault,pswpin,pswpout,allocstall,pgscan,pgsteal,oom_kill";
+
+/* Keys are identified by length plus their first 16 and last 8 bytes, which is exact for
+ * every key up to 24 characters and never needs a string compare. */
+typedef struct vmstat_fingerprint {
+  uint64_t w[3];
+  uint32_t len;
+} vmstat_fingerprint_t;
+
+typedef struct vmstat_slot {
+  vmstat_fingerprint_t fp;
+  uint8_t counter;
+  uint8_t total;
+} vmstat_slot_t;
+
+typedef struct vmstat_state {
+  sysmon_file_t file;
+  vmstat_slot_t slots[VMSTAT_SLOTS];
+  uint64_t seed;
+  bool selected[VM_COUNTERS];
+  uint64_t values[VM_COUNTERS];
+  uint64_t prev[VM_COUNTERS];
+  double rates[VM_COUNTERS];
+  uint64_t last_ts_ns;
+  bool has_data;
+} vmstat_state_t;
+
+#if defined(__linux__)
+static void fingerprint(const char *key, size_t len, vmstat_fingerprint_t *fp) {
+  memset(fp, 0, sizeof(*fp));
+  fp->len = (uint32_t)len;
+  memcpy(&fp->w[0], key, len < 8 ? len : 8);
+  if (len > 8) memcpy(&fp->w[1], key + 8, len < 16 ? len - 8 : 8);
+  if (len > 16) memcpy(&fp->w[2], key + len - 8, 8);
+}
+
+static inline uint32_t slot_of(const vmstat_fingerprint_t *fp, uint64_t seed) {
+  uint64_t h = fp->w[0] ^ ((fp->w[1] << 21) | (fp->w[1] >> 43)) ^
+               ((fp->w[2] << 42) | (fp->w[2] >> 22)) ^ fp->len;
+  h ^= h >> 29;
+  return (uint32_t)((h * seed) >> (64 - VMSTAT_SLOT_BITS));
+}
+
+static inline bool fingerprint_eq(const vmstat_fingerprint_t *a, const vmstat_fingerprint_t *b) {
+  return a->len == b->len && a->w[0] == b->w[0] && a->w[1] == b->w[1] && a->w[2] == b->w[2];
+}
+
+/* Searches for a multiplier that maps every selected key to its own slot. */
+static bool build_perfect_hash(vmstat_state_t *st) {
+  uint64_t seed = 0x9e3779b97f4a7c15ull;
+  for (int attempt = 0; attempt < 100000; attempt++) {
+    seed += 0x9e3779b97f4a7c15ull;
+    const uint64_t mult = seed | 1u;
+    memset(st->slots, 0, sizeof(st->slots));
+    bool ok = true;
+    for (size_t i = 0; i < VMSTAT_KEY_COUNT && ok; i++) {
+      const vmstat_key_t *k = &vmstat_keys[i];
+      if (!st->selected[k->counter] && (k->total == VMSTAT_NONE || !st->selected[k->total]))
+        continue;
+      vmstat_fingerprint_t fp;
+      fingerprint(k->key, strlen(k->key), &fp);
+      vmstat_slot_t *slot = &st->slots[slot_of(&fp, mult)];
+      if (slot->fp.len != 0) {
+        ok = false;
+        break;
+      }
+      slot->fp = fp;
+      slot->counter = k->counter;
+      slot->total = k->total;
+    }
+    if (ok) {
+      st->seed = mult;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void parse_vmstat(vmstat_state_t *st, const char *p) {
+  memset(st->values, 0, sizeof(st->values));
+  while (*p) {
+    const char *key = p;
+    while (*p && *p != ' ' && *p != '\n') p++;
+    vmstat_fingerprint_t fp;
+    fingerprint(key, (size_t)(p - key), &fp);
+    const vmstat_slot_t *slot = &st->slots[slot_of(&fp, st->seed)];
+    uint64_t v = 0;
+    if (slot->fp.len != 0 && fingerprint_eq(&slot->fp, &fp) && sysmon_parse_u64(&p, &v)) {
+      st->values[slot->counter] += v;
+      if (slot->total != VMSTAT_NONE) st->values[slot->total] += v;
+    }
+    p = sysmon_next_line(p);
+  }
+}
+#endif
+
+static void vmstat_destroy(void *state) {
+  vmstat_state_t *st = (vmstat_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  sysmon_file_close(&st->file);
+#endif
+  free(st);
+}
+
+static sysmon_result_t vmstat_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                     const char *section, void **out_state, char **out_error) {
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  vmstat_state_t *st = (vmstat_state_t *)calloc(1, sizeof(*st));
+  if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+  sysmon_file_init(&st->file);
+
+  const char *list = sysmon_ini_get(ini, section, "counters");
+  if (!list || !*list) list = vmstat_default_counters;
+  if (!sysmon_select_names(list, vmstat_counters, VM_COUNTERS, sizeof(vmstat_counters[0]),
+                           st->selected, "vmstat counter", out_error)) {
+    vmstat_destroy(st);
+    return SYSMON_ERR_PARSE;
+  }
+  if (!build_perfect_hash(st)) {
+    sysmon_set_error(out_error, "failed to build vmstat key table");
+    vmstat_destroy(st);
+    return SYSMON_ERR_IO;
+  }
+
+  char path[SYSMON_PATH_LEN];
+  sysmon_proc_path(paths, "vmstat", path, sizeof(path));
+  if (!sysmon_file_open(&st->file, path)) {
+    sysmon_set_path_error(out_error, "cannot open", path);
+    vmstat_destroy(st);
+    return SYSMON_ERR_NOT_SUPPORTED;
+  }
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)paths;
+  (void)ini;
+  (void)section;
+  sysmon_set_error(out_error, "vmstat module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static sysmon_result_t vmstat_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                   sysmon_snapshot_builder_t *builder, char **out_error) {
+  vmstat_state_t *st = (vmstat_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+
+#if defined(__linux__)
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
+    if (!sysmon_file_read(&st->file)) {
+      sysmon_set_path_error(out_error, "failed to read", st->file.path);
+      return SYSMON_ERR_IO;
+    }
+    parse_vmstat(st, st->file.buf);
+    const double seconds = st->has_data && now_ns > st->last_ts_ns
+                               ? (double)(now_ns - st->last_ts_ns) / (double)SYSMON_NS_PER_SEC
+                               : 0.0;
+    for (size_t i = 0; i < VM_COUNTERS; i++) {
+      st->rates[i] = seconds > 0.0 && st->values[i] >= st->prev[i]
+                         ? (double)(st->values[i] - st->prev[i]) / seconds
+                         : 0.0;
+      st->prev[i] = st->values[i];
+    }
+    st->last_ts_ns = now_ns;
+    st->has_data = true;
+  }
+
+  char name[96];
+  sysmon_result_t rc;
+  for (size_t i = 0; i < VM_COUNTERS; i++) {
+    if (!st->selected[i]) continue;
+    if (vmstat_counters[i].gauge) {
+      snprintf(name, sizeof(name), "vmstat.%s", vmstat_counters[i].name);
+      rc = sysmon_snapshot_builder_add_u64(builder, name, "pages", st->values[i]);
+    } else {
+      snprintf(name, sizeof(name), "vmstat.%s_per_sec", vmstat_counters[i].name);
+      rc = sysmon_snapshot_builder_add_double(builder, name, "/s", st->rates[i]);
+    }
+    if (rc != SYSMON_OK) return rc;
+  }
+  if (st->selected[VM_PGSCAN] && st->selected[VM_PGSTEAL]) {
+    const double scan = st->rates[VM_PGSCAN];
+    rc = sysmon_snapshot_builder_add_double(builder, "vmstat.reclaim_efficiency_percent", "%",
+                                            scan > 0.0 ? st->rates[VM_PGSTEAL] * 100.0 / scan : 0.0);
+    if (rc != SYSMON_OK) return rc;
+  }
+  return SYSMON_OK;
+#else
+  (void)now_ns;
+  (void)refresh_now;
+  sysmon_set_error(out_error, "vmstat module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_vmstat_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "vmstat",
+      .create = vmstat_create,
+      .poll = vmstat_poll,
+      .destroy = vmstat_destroy,
+  };
+  return &vtable;
+}
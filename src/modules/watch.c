@@ -0,0 +1,514 @@
+#include "../sysmon_internal.h"
+#include "../sysmon_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define WATCH_MAX_TARGETS 32
+#define WATCH_LABEL_LEN 64
+#define WATCH_BUF 4096
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+typedef enum { WATCH_PID, WATCH_PIDFILE, WATCH_EXE } watch_kind_t;
+
+enum { WATCH_STAT, WATCH_STATM, WATCH_STATUS, WATCH_IO, WATCH_SMAPS, WATCH_FILES };
+
+static const char *const watch_file_names[WATCH_FILES] = {"stat", "statm", "status", "io",
+                                                          "smaps_rollup"};
+
+typedef struct watch_sample {
+  uint64_t cpu_ticks;
+  uint64_t threads;
+  uint64_t rss_pages;
+  uint64_t shared_pages;
+  uint64_t pss_kb;
+  uint64_t fds;
+  uint64_t read_bytes;
+  uint64_t write_bytes;
+  uint64_t voluntary;
+  uint64_t involuntary;
+} watch_sample_t;
+
+typedef struct watch_target {
+  watch_kind_t kind;
+  char *arg;
+  char label[WATCH_LABEL_LEN];
+  uint32_t pid;
+  int pidfd;
+  int dir_fd;
+  int fds[WATCH_FILES];
+  bool io_blocked;
+  bool exited;
+  bool lost; /* was attached once; the next attach counts as a restart */
+  uint64_t restarts;
+  uint64_t next_resolve_ns;
+  watch_sample_t cur;
+  watch_sample_t prev;
+  bool has_prev;
+  double cpu_percent;
+  double read_rate;
+  double write_rate;
+  double voluntary_rate;
+  double involuntary_rate;
+} watch_target_t;
+
+typedef struct watch_state {
+  sysmon_paths_t paths;
+  watch_target_t targets[WATCH_MAX_TARGETS];
+  size_t count;
+  bool pss;
+  uint64_t retry_ns;
+  uint64_t page_size;
+  double ticks_per_sec;
+  char buf[WATCH_BUF + SYSMON_PARSE_PADDING + 1];
+  uint64_t last_ts_ns;
+  bool has_data;
+} watch_state_t;
+
+#if defined(__linux__)
+static void release_target(watch_target_t *t) {
+  for (size_t i = 0; i < WATCH_FILES; i++) sysmon_close_fd(&t->fds[i]);
+  sysmon_close_fd(&t->dir_fd);
+  sysmon_close_fd(&t->pidfd);
+  t->pid = 0;
+  t->has_prev = false;
+}
+
+static ssize_t read_file(watch_state_t *st, watch_target_t *t, size_t which) {
+  if (t->fds[which] < 0) {
+    t->fds[which] = openat(t->dir_fd, watch_file_names[which], O_RDONLY | O_CLOEXEC);
+    if (t->fds[which] < 0) return -1;
+  }
+  ssize_t n;
+  do {
+    n = pread(t->fds[which], st->buf, WATCH_BUF, 0);
+  } while (n < 0 && errno == EINTR);
+  if (n >= 0) memset(st->buf + n, 0, SYSMON_PARSE_PADDING + 1);
+  return n;
+}
+
+/* Start time (field 22) distinguishes the oldest match, normally the daemon's main process. */
+static bool read_start_time(int proc_fd, const char *pid, uint64_t *out) {
+  char rel[SYSMON_PATH_LEN];
+  snprintf(rel, sizeof(rel), "%s/stat", pid);
+  const int fd = openat(proc_fd, rel, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  char buf[1024 + SYSMON_PARSE_PADDING + 1];
+  const ssize_t n = pread(fd, buf, 1024, 0);
+  close(fd);
+  if (n <= 0) return false;
+  memset(buf + n, 0, SYSMON_PARSE_PADDING + 1);
+  const char *close_paren = strrchr(buf, ')');
+  if (!close_paren) return false;
+  const char *p = sysmon_skip_fields(close_paren + 2, 19);
+  return sysmon_parse_u64(&p, out);
+}
+
+static bool exe_matches(int proc_fd, const char *pid, const char *name) {
+  char rel[SYSMON_PATH_LEN], target[SYSMON_PATH_LEN];
+  snprintf(rel, sizeof(rel), "%s/exe", pid);
+  const ssize_t n = readlinkat(proc_fd, rel, target, sizeof(target) - 1);
+  if (n > 0) {
+    target[n] = '\0';
+    char *deleted = strstr(target, " (deleted)");
+    if (deleted) *deleted = '\0';
+    const char *base = strrchr(target, '/');
+    return strcmp(base ? base + 1 : target, name) == 0;
+  }
+  /* No ptrace access to exe: fall back to comm, which the kernel truncates to 15 chars. */
+  snprintf(rel, sizeof(rel), "%s/comm", pid);
+  const int fd = openat(proc_fd, rel, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  char comm[32];
+  const ssize_t len = read(fd, comm, sizeof(comm) - 1);
+  close(fd);
+  if (len <= 0) return false;
+  comm[comm[len - 1] == '\n' ? len - 1 : len] = '\0';
+  return strncmp(comm, name, 15) == 0;
+}
+
+static uint32_t find_exe(const sysmon_paths_t *paths, const char *name) {
+  char root[SYSMON_PATH_LEN];
+  sysmon_proc_path(paths, "", root, sizeof(root));
+  DIR *d = opendir(root);
+  if (!d) return 0;
+  uint32_t best = 0;
+  uint64_t best_start = UINT64_MAX;
+  struct dirent *de;
+  while ((de = readdir(d)) != NULL) {
+    if (de->d_name[0] < '1' || de->d_name[0] > '9') continue;
+    if (!exe_matches(dirfd(d), de->d_name, name)) continue;
+    uint64_t start = 0;
+    if (!read_start_time(dirfd(d), de->d_name, &start) || start >= best_start) continue;
+    best_start = start;
+    best = (uint32_t)strtoul(de->d_name, NULL, 10);
+  }
+  closedir(d);
+  return best;
+}
+
+static uint32_t read_pidfile(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) return 0;
+  unsigned long pid = 0;
+  if (fscanf(f, "%lu", &pid) != 1) pid = 0;
+  fclose(f);
+  return pid > 0 && pid <= UINT32_MAX ? (uint32_t)pid : 0;
+}
+
+/* pidfd first, then the /proc dir: if the pidfd is still not readable afterwards, the
+ * directory belongs to the same process and not to a recycled PID. */
+static bool attach(watch_state_t *st, watch_target_t *t) {
+  uint32_t pid = 0;
+  switch (t->kind) {
+  case WATCH_PID: pid = (uint32_t)strtoul(t->arg, NULL, 10); break;
+  case WATCH_PIDFILE: pid = read_pidfile(t->arg); break;
+  case WATCH_EXE: pid = find_exe(&st->paths, t->arg); break;
+  }
+  if (pid == 0) return false;
+
+  t->pidfd = (int)syscall(SYS_pidfd_open, (int)pid, 0);
+  char rel[32], path[SYSMON_PATH_LEN];
+  snprintf(rel, sizeof(rel), "%u", (unsigned)pid);
+  sysmon_proc_path(&st->paths, rel, path, sizeof(path));
+  t->dir_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (t->dir_fd < 0) {
+    sysmon_close_fd(&t->pidfd);
+    return false;
+  }
+  if (t->pidfd >= 0) {
+    struct pollfd pfd = {.fd = t->pidfd, .events = POLLIN};
+    if (poll(&pfd, 1, 0) > 0) {
+      release_target(t);
+      return false;
+    }
+  }
+  t->pid = pid;
+  t->exited = false;
+  t->io_blocked = false;
+  return true;
+}
+
+static bool sample_target(watch_state_t *st, watch_target_t *t) {
+  watch_sample_t *s = &t->cur;
+  ssize_t n = read_file(st, t, WATCH_STAT);
+  if (n <= 0) return false; /* ESRCH once the process is gone */
+  const char *close_paren = memrchr(st->buf, ')', (size_t)n);
+  if (!close_paren) return false;
+  const char *p = sysmon_skip_fields(close_paren + 2, 11);
+  uint64_t utime = 0, stime = 0;
+  if (!sysmon_parse_u64(&p, &utime) || !sysmon_parse_u64(&p, &stime)) return false;
+  s->cpu_ticks = utime + stime;
+  p = sysmon_skip_fields(p + 1, 4);
+  sysmon_parse_u64(&p, &s->threads);
+
+  if (read_file(st, t, WATCH_STATM) > 0) {
+    p = st->buf;
+    uint64_t size = 0;
+    if (sysmon_parse_u64(&p, &size) && sysmon_parse_u64(&p, &s->rss_pages))
+      sysmon_parse_u64(&p, &s->shared_pages);
+  }
+  if (read_file(st, t, WATCH_STATUS) > 0) {
+    s->voluntary = sysmon_status_value(st->buf, "voluntary_ctxt_switches");
+    s->involuntary = sysmon_status_value(st->buf, "nonvoluntary_ctxt_switches");
+  }
+  if (!t->io_blocked) {
+    if (read_file(st, t, WATCH_IO) > 0) {
+      s->read_bytes = sysmon_status_value(st->buf, "read_bytes");
+      s->write_bytes = sysmon_status_value(st->buf, "write_bytes");
+    } else if (errno == EACCES || errno == EPERM) {
+      t->io_blocked = true;
+    }
+  }
+  if (st->pss && read_file(st, t, WATCH_SMAPS) > 0) {
+    const char *line = strstr(st->buf, "\nPss:");
+    if (line) s->pss_kb = sysmon_status_value(line + 1, "Pss");
+  }
+
+  /* Since Linux 6.2 the size of /proc/<pid>/fd is its number of open descriptors. */
+  struct stat sb;
+  s->fds = 0;
+  if (fstatat(t->dir_fd, "fd", &sb, 0) == 0 && sb.st_size > 0) {
+    s->fds = (uint64_t)sb.st_size;
+  } else {
+    const int fd = openat(t->dir_fd, "fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    DIR *d = fd >= 0 ? fdopendir(fd) : NULL;
+    if (!d && fd >= 0) close(fd);
+    for (struct dirent *de; d && (de = readdir(d)) != NULL;)
+      if (de->d_name[0] != '.') s->fds++;
+    if (d) closedir(d);
+  }
+  return true;
+}
+
+static void update_rates(watch_state_t *st, watch_target_t *t, double seconds) {
+  const watch_sample_t *c = &t->cur, *p = &t->prev;
+#define WATCH_RATE(field) \
+  (c->field >= p->field ? (double)(c->field - p->field) / seconds : 0.0)
+  if (t->has_prev && seconds > 0.0) {
+    t->cpu_percent = WATCH_RATE(cpu_ticks) / st->ticks_per_sec * 100.0;
+    t->read_rate = WATCH_RATE(read_bytes);
+    t->write_rate = WATCH_RATE(write_bytes);
+    t->voluntary_rate = WATCH_RATE(voluntary);
+    t->involuntary_rate = WATCH_RATE(involuntary);
+  } else {
+    t->cpu_percent = t->read_rate = t->write_rate = 0.0;
+    t->voluntary_rate = t->involuntary_rate = 0.0;
+  }
+#undef WATCH_RATE
+  t->prev = t->cur;
+  t->has_prev = true;
+}
+
+/* "[<label>=]pid:<n>|pidfile:<path>|exe:<name>" */
+static bool parse_target(watch_target_t *t, const char *spec, size_t len) {
+  const char *eq = memchr(spec, '=', len);
+  if (eq) {
+    const size_t label_len = (size_t)(eq - spec);
+    if (label_len == 0 || label_len >= WATCH_LABEL_LEN) return false;
+    memcpy(t->label, spec, label_len);
+    t->label[label_len] = '\0';
+    len -= label_len + 1;
+    spec = eq + 1;
+  }
+  static const struct {
+    const char *prefix;
+    watch_kind_t kind;
+  } kinds[] = {{"pid:", WATCH_PID}, {"pidfile:", WATCH_PIDFILE}, {"exe:", WATCH_EXE}};
+  for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+    const size_t plen = strlen(kinds[i].prefix);
+    if (len <= plen || strncmp(spec, kinds[i].prefix, plen) != 0) continue;
+    t->kind = kinds[i].kind;
+    t->arg = (char *)malloc(len - plen + 1);
+    if (!t->arg) return false;
+    memcpy(t->arg, spec + plen, len - plen);
+    t->arg[len - plen] = '\0';
+
+    /* Default label: exe name, pidfile basename without ".pid", or the pid itself. */
+    if (t->label[0]) return true;
+    const char *base = strrchr(t->arg, '/');
+    base = base ? base + 1 : t->arg;
+    size_t blen = strlen(base);
+    if (t->kind == WATCH_PIDFILE && blen > 4 && strcmp(base + blen - 4, ".pid") == 0) blen -= 4;
+    if (blen >= WATCH_LABEL_LEN) blen = WATCH_LABEL_LEN - 1;
+    memcpy(t->label, base, blen);
+    t->label[blen] = '\0';
+    return blen > 0;
+  }
+  return false;
+}
+#endif
+
+static void watch_destroy(void *state) {
+  watch_state_t *st = (watch_state_t *)state;
+  if (!st) return;
+#if defined(__linux__)
+  for (size_t i = 0; i < st->count; i++) {
+    release_target(&st->targets[i]);
+    free(st->targets[i].arg);
+  }
+#endif
+  free(st);
+}
+
+static sysmon_result_t watch_create(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                                    const char *section, void **out_state, char **out_error) {
+  if (!out_state) return SYSMON_ERR_INVALID_ARGUMENT;
+#if defined(__linux__)
+  const char *list = sysmon_ini_get(ini, section, "targets");
+  if (!list || !*list) {
+    sysmon_set_error(out_error, "watch module needs targets (pid:<n>, pidfile:<path>, exe:<name>)");
+    return SYSMON_ERR_PARSE;
+  }
+  bool ok = true;
+  const uint32_t retry_ms = sysmon_ini_get_u32(ini, section, "retry_ms", 5000, &ok);
+  if (!ok) {
+    sysmon_set_error(out_error, "invalid retry_ms");
+    return SYSMON_ERR_PARSE;
+  }
+
+  watch_state_t *st = (watch_state_t *)calloc(1, sizeof(*st));
+  if (!st) return SYSMON_ERR_OUT_OF_MEMORY;
+  st->paths = *paths;
+  st->pss = sysmon_ini_get_bool(ini, section, "pss", false);
+  st->retry_ns = (uint64_t)retry_ms * SYSMON_NS_PER_MS;
+  const long hz = sysconf(_SC_CLK_TCK);
+  st->ticks_per_sec = hz > 0 ? (double)hz : 100.0;
+  const long page = sysconf(_SC_PAGESIZE);
+  st->page_size = page > 0 ? (uint64_t)page : 4096u;
+
+  for (const char *p = list; *p;) {
+    while (*p == ' ' || *p == ',') p++;
+    const char *end = p;
+    while (*end && *end != ',') end++;
+    size_t len = (size_t)(end - p);
+    while (len > 0 && p[len - 1] == ' ') len--;
+    if (len == 0) break;
+    if (st->count == WATCH_MAX_TARGETS) {
+      sysmon_set_error(out_error, "too many watch targets (max 32)");
+      watch_destroy(st);
+      return SYSMON_ERR_PARSE;
+    }
+    watch_target_t *t = &st->targets[st->count];
+    t->pidfd = t->dir_fd = -1;
+    for (size_t i = 0; i < WATCH_FILES; i++) t->fds[i] = -1;
+    if (!parse_target(t, p, len)) {
+      free(t->arg);
+      t->arg = NULL;
+      char buf[128];
+      snprintf(buf, sizeof(buf), "invalid watch target '%.*s'", (int)(len < 64 ? len : 64), p);
+      sysmon_set_error(out_error, buf);
+      watch_destroy(st);
+      return SYSMON_ERR_PARSE;
+    }
+    for (size_t i = 0; i < st->count; i++) {
+      if (strcmp(st->targets[i].label, t->label) != 0) continue;
+      char buf[128];
+      snprintf(buf, sizeof(buf), "duplicate watch label '%s' (use <label>=<target>)", t->label);
+      sysmon_set_error(out_error, buf);
+      free(t->arg);
+      t->arg = NULL;
+      watch_destroy(st);
+      return SYSMON_ERR_PARSE;
+    }
+    st->count++;
+    p = end;
+  }
+  for (size_t i = 0; i < st->count; i++) attach(st, &st->targets[i]);
+  *out_state = st;
+  return SYSMON_OK;
+#else
+  (void)paths;
+  (void)ini;
+  (void)section;
+  sysmon_set_error(out_error, "watch module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+#if defined(__linux__)
+static size_t watch_event_sources(void *state, sysmon_event_source_t *out, size_t max) {
+  watch_state_t *st = (watch_state_t *)state;
+  size_t n = 0;
+  for (size_t i = 0; st && i < st->count; i++) {
+    const watch_target_t *t = &st->targets[i];
+    if (t->pidfd < 0 || t->exited) continue; /* stays readable after exit */
+    if (out && n < max) {
+      out[n].fd = t->pidfd;
+      out[n].events = POLLIN;
+      out[n].revents = 0;
+    }
+    n++;
+  }
+  return n;
+}
+
+static bool watch_on_event(void *state, const sysmon_event_source_t *source) {
+  watch_state_t *st = (watch_state_t *)state;
+  if (!st || !(source->revents & (POLLIN | POLLHUP))) return false;
+  for (size_t i = 0; i < st->count; i++) {
+    if (st->targets[i].pidfd == source->fd) st->targets[i].exited = true;
+  }
+  return true;
+}
+#endif
+
+static sysmon_result_t watch_poll(void *state, uint64_t now_ns, bool refresh_now,
+                                  sysmon_snapshot_builder_t *builder, char **out_error) {
+  (void)out_error;
+  watch_state_t *st = (watch_state_t *)state;
+  if (!st || !builder) return SYSMON_ERR_INVALID_ARGUMENT;
+
+#if defined(__linux__)
+  if (sysmon_refresh_due(builder, now_ns, refresh_now, !st->has_data)) {
+    const double seconds = st->has_data && now_ns > st->last_ts_ns
+                               ? (double)(now_ns - st->last_ts_ns) / (double)SYSMON_NS_PER_SEC
+                               : 0.0;
+    for (size_t i = 0; i < st->count; i++) {
+      watch_target_t *t = &st->targets[i];
+      if (t->pid != 0 && (t->exited || !sample_target(st, t))) {
+        release_target(t);
+        t->lost = true;
+        t->next_resolve_ns = 0;
+      }
+      if (t->pid == 0) {
+        if (now_ns < t->next_resolve_ns) continue;
+        t->next_resolve_ns = now_ns + st->retry_ns;
+        if (!attach(st, t) || !sample_target(st, t)) {
+          release_target(t);
+          continue;
+        }
+        if (t->lost) t->restarts++;
+        t->lost = false;
+      }
+      update_rates(st, t, seconds);
+    }
+    st->last_ts_ns = now_ns;
+    st->has_data = true;
+  }
+
+  char name[128];
+  sysmon_result_t rc;
+#define WATCH_ADD(kind, metric, unit, value)                                  \
+  do {                                                                        \
+    snprintf(name, sizeof(name), "watch.%s.%s", t->label, metric);            \
+    rc = sysmon_snapshot_builder_add_##kind(builder, name, unit, value);      \
+    if (rc != SYSMON_OK) return rc;                                           \
+  } while (0)
+  for (size_t i = 0; i < st->count; i++) {
+    const watch_target_t *t = &st->targets[i];
+    WATCH_ADD(u64, "up", NULL, t->pid != 0);
+    WATCH_ADD(u64, "restarts", NULL, t->restarts);
+    if (t->pid == 0) continue;
+    const watch_sample_t *s = &t->cur;
+    WATCH_ADD(i64, "pid", NULL, (int64_t)t->pid);
+    WATCH_ADD(double, "cpu_percent", "%", t->cpu_percent);
+    WATCH_ADD(u64, "rss_bytes", "B", s->rss_pages * st->page_size);
+    WATCH_ADD(u64, "shared_bytes", "B", s->shared_pages * st->page_size);
+    if (st->pss) WATCH_ADD(u64, "pss_bytes", "B", s->pss_kb * 1024u);
+    WATCH_ADD(u64, "threads", NULL, s->threads);
+    WATCH_ADD(u64, "fds", NULL, s->fds);
+    WATCH_ADD(double, "voluntary_ctxt_switches_per_sec", "/s", t->voluntary_rate);
+    WATCH_ADD(double, "nonvoluntary_ctxt_switches_per_sec", "/s", t->involuntary_rate);
+    if (t->io_blocked) continue;
+    WATCH_ADD(double, "read_bytes_per_sec", "B/s", t->read_rate);
+    WATCH_ADD(double, "write_bytes_per_sec", "B/s", t->write_rate);
+  }
+#undef WATCH_ADD
+  return SYSMON_OK;
+#else
+  (void)now_ns;
+  (void)refresh_now;
+  sysmon_set_error(out_error, "watch module not supported on this platform");
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
+
+const sysmon_module_vtable_t *sysmon_watch_module(void) {
+  static const sysmon_module_vtable_t vtable = {
+      .name = "watch",
+      .create = watch_create,
+      .poll = watch_poll,
+      .destroy = watch_destroy,
+#if defined(__linux__)
+      .event_sources = watch_event_sources,
+      .on_event = watch_on_event,
+#endif
+      .opt_in = true,
+  };
+  return &vtable;
+}
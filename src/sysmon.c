@@ -1,14 +1,24 @@
 #include "sysmon_internal.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__linux__) || defined(__APPLE__)
+#include <poll.h>
+#include <time.h>
+#endif
+
 struct sysmon {
   sysmon_config_t config;
+  sysmon_paths_t paths;
   sysmon_ini_t *ini;
   sysmon_module_instance_t *modules;
   size_t module_count;
+  sysmon_event_source_t *sources;
+  size_t *source_owner;
+  size_t source_cap;
   char *last_error;
 };
 
@@ -27,6 +37,12 @@ void sysmon_set_error(char **target, const char *message) {
   *target = message ? sysmon_strdup(message) : NULL;
 }
 
+void sysmon_set_path_error(char **target, const char *what, const char *path) {
+  char buf[SYSMON_PATH_LEN + 64];
+  snprintf(buf, sizeof(buf), "%s %s", what, path ? path : "(null)");
+  sysmon_set_error(target, buf);
+}
+
 static sysmon_result_t init_modules(sysmon_t *sysmon) {
   size_t builtin_count = 0;
   const sysmon_module_vtable_t *builtins = sysmon_builtin_modules(&builtin_count);
@@ -41,11 +57,11 @@ static sysmon_result_t init_modules(sysmon_t *sysmon) {
     inst->vtable = &builtins[i];
     inst->enabled = true;
     inst->refresh_ms = 0;
-    inst->last_refresh_ms = 0;
+    inst->last_refresh_ns = 0;
 
     char section[128];
     snprintf(section, sizeof(section), "module.%s", inst->vtable->name);
-    inst->enabled = sysmon_ini_get_bool(sysmon->ini, section, "enabled", true);
+    inst->enabled = sysmon_ini_get_bool(sysmon->ini, section, "enabled", !inst->vtable->opt_in);
 
     bool ok = true;
     inst->refresh_ms = sysmon_ini_get_u32(sysmon->ini, section, "refresh_ms", 0, &ok);
@@ -57,7 +73,8 @@ static sysmon_result_t init_modules(sysmon_t *sysmon) {
     if (!inst->enabled) continue;
 
     char *err = NULL;
-    sysmon_result_t rc = inst->vtable->create(sysmon->ini, section, &inst->state, &err);
+    sysmon_result_t rc =
+        inst->vtable->create(&sysmon->paths, sysmon->ini, section, &inst->state, &err);
     if (rc == SYSMON_ERR_NOT_SUPPORTED) {
       inst->enabled = false;
       free(err);
@@ -84,8 +101,16 @@ sysmon_result_t sysmon_create(const sysmon_create_options_t *options, sysmon_t *
   const char *ini_path = options ? options->ini_path : NULL;
   if (!ini_path) ini_path = "sysmon.ini";
 
+  sysmon_result_t rc = sysmon_paths_init(&sysmon->paths, options ? options->proc_root : NULL,
+                                         options ? options->sys_root : NULL);
+  if (rc != SYSMON_OK) {
+    sysmon_set_error(&sysmon->last_error, "proc_root/sys_root path too long");
+    sysmon_destroy(sysmon);
+    return rc;
+  }
+
   char *err = NULL;
-  sysmon_result_t rc = sysmon_ini_load_file(ini_path, &sysmon->ini, &err);
+  rc = sysmon_ini_load_file(ini_path, &sysmon->ini, &err);
   if (rc != SYSMON_OK) {
     sysmon_set_error(&sysmon->last_error, err ? err : "failed to load ini");
     free(err);
@@ -122,6 +147,8 @@ void sysmon_destroy(sysmon_t *sysmon) {
     }
   }
   free(sysmon->modules);
+  free(sysmon->sources);
+  free(sysmon->source_owner);
   sysmon_ini_destroy(sysmon->ini);
   free(sysmon->last_error);
   free(sysmon);
@@ -149,18 +176,20 @@ sysmon_result_t sysmon_poll(sysmon_t *sysmon, sysmon_snapshot_t **out_snapshot)
   sysmon_result_t rc = sysmon_snapshot_builder_create(&builder);
   if (rc != SYSMON_OK) return rc;
 
-  const uint64_t now_ms = sysmon_now_ms();
   for (size_t i = 0; i < sysmon->module_count; i++) {
     sysmon_module_instance_t *inst = &sysmon->modules[i];
     if (!inst->enabled || !inst->vtable || !inst->vtable->poll) continue;
 
-    const bool refresh_now = inst->refresh_ms == 0 || inst->last_refresh_ms == 0 ||
-                             now_ms - inst->last_refresh_ms >= inst->refresh_ms;
+    const uint64_t now_ns = sysmon_now_ns(sysmon->config.coarse_clock);
+    const bool refresh_now =
+        inst->refresh_ms == 0 || inst->last_refresh_ns == 0 ||
+        now_ns - inst->last_refresh_ns >= (uint64_t)inst->refresh_ms * SYSMON_NS_PER_MS;
+    sysmon_snapshot_builder_set_sample_ns(builder, refresh_now ? now_ns : inst->last_refresh_ns);
 
     char *module_err = NULL;
-    sysmon_result_t mrc = inst->vtable->poll(inst->state, now_ms, refresh_now, builder, &module_err);
+    sysmon_result_t mrc = inst->vtable->poll(inst->state, now_ns, refresh_now, builder, &module_err);
     if (mrc == SYSMON_OK) {
-      if (refresh_now) inst->last_refresh_ms = now_ms;
+      if (sysmon_snapshot_builder_sample_ns(builder) == now_ns) inst->last_refresh_ns = now_ns;
       free(module_err);
       continue;
     }
@@ -175,7 +204,83 @@ sysmon_result_t sysmon_poll(sysmon_t *sysmon, sysmon_snapshot_t **out_snapshot)
     free(module_err);
   }
 
-  rc = sysmon_snapshot_builder_finalize(builder, out_snapshot);
+  rc = sysmon_snapshot_builder_finalize(builder, sysmon_now_ns(sysmon->config.coarse_clock),
+                                        out_snapshot);
   sysmon_snapshot_builder_destroy(builder);
   return rc;
 }
+
+static sysmon_result_t collect_event_sources(sysmon_t *sysmon, size_t *out_count) {
+  size_t total = 0;
+  for (size_t i = 0; i < sysmon->module_count; i++) {
+    const sysmon_module_instance_t *inst = &sysmon->modules[i];
+    if (!inst->enabled || !inst->vtable->event_sources) continue;
+    total += inst->vtable->event_sources(inst->state, NULL, 0);
+  }
+  if (total > sysmon->source_cap) {
+    void *sources = realloc(sysmon->sources, total * sizeof(*sysmon->sources));
+    if (sources) sysmon->sources = (sysmon_event_source_t *)sources;
+    void *owners = realloc(sysmon->source_owner, total * sizeof(*sysmon->source_owner));
+    if (owners) sysmon->source_owner = (size_t *)owners;
+    if (!sources || !owners) return SYSMON_ERR_OUT_OF_MEMORY;
+    sysmon->source_cap = total;
+  }
+
+  size_t n = 0;
+  for (size_t i = 0; i < sysmon->module_count && n < total; i++) {
+    const sysmon_module_instance_t *inst = &sysmon->modules[i];
+    if (!inst->enabled || !inst->vtable->event_sources) continue;
+    size_t got = inst->vtable->event_sources(inst->state, sysmon->sources + n, total - n);
+    if (got > total - n) got = total - n;
+    for (size_t k = 0; k < got; k++) sysmon->source_owner[n + k] = i;
+    n += got;
+  }
+  *out_count = n;
+  return SYSMON_OK;
+}
+
+sysmon_result_t sysmon_wait(sysmon_t *sysmon, uint32_t timeout_ms, bool *out_changed) {
+  if (!sysmon) return SYSMON_ERR_INVALID_ARGUMENT;
+  if (out_changed) *out_changed = false;
+#if defined(__linux__) || defined(__APPLE__)
+  size_t count = 0;
+  sysmon_result_t rc = collect_event_sources(sysmon, &count);
+  if (rc != SYSMON_OK) return rc;
+
+  if (count == 0) {
+    struct timespec ts = {.tv_sec = (time_t)(timeout_ms / 1000u),
+                          .tv_nsec = (long)((timeout_ms % 1000u) * 1000000u)};
+    nanosleep(&ts, NULL);
+    return SYSMON_OK;
+  }
+
+  struct pollfd stack_fds[32];
+  struct pollfd *fds = count <= 32 ? stack_fds : (struct pollfd *)calloc(count, sizeof(*fds));
+  if (!fds) return SYSMON_ERR_OUT_OF_MEMORY;
+  for (size_t i = 0; i < count; i++) {
+    fds[i].fd = sysmon->sources[i].fd;
+    fds[i].events = sysmon->sources[i].events;
+    fds[i].revents = 0;
+  }
+
+  int ready = poll(fds, (nfds_t)count, timeout_ms > 0x7fffffffu ? -1 : (int)timeout_ms);
+  if (ready < 0 && errno != EINTR) {
+    if (fds != stack_fds) free(fds);
+    sysmon_set_error(&sysmon->last_error, "poll failed while waiting for module events");
+    return SYSMON_ERR_IO;
+  }
+  for (size_t i = 0; ready > 0 && i < count; i++) {
+    if (!fds[i].revents) continue;
+    sysmon_event_source_t *src = &sysmon->sources[i];
+    src->revents = fds[i].revents;
+    const sysmon_module_instance_t *inst = &sysmon->modules[sysmon->source_owner[i]];
+    if (inst->vtable->on_event && inst->vtable->on_event(inst->state, src) && out_changed)
+      *out_changed = true;
+  }
+  if (fds != stack_fds) free(fds);
+  return SYSMON_OK;
+#else
+  (void)timeout_ms;
+  return SYSMON_ERR_NOT_SUPPORTED;
+#endif
+}
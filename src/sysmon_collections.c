@@ -0,0 +1,166 @@
+#include "sysmon_internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t hash_u64(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return x;
+}
+
+bool sysmon_u64map_init(sysmon_u64map_t *map, size_t initial_capacity) {
+  if (!map) return false;
+  memset(map, 0, sizeof(*map));
+  size_t cap = 16;
+  while (cap < initial_capacity * 2) cap *= 2;
+  map->keys = (uint64_t *)calloc(cap, sizeof(*map->keys));
+  map->values = (uint32_t *)calloc(cap, sizeof(*map->values));
+  map->used = (unsigned char *)calloc(cap, 1);
+  if (!map->keys || !map->values || !map->used) {
+    sysmon_u64map_destroy(map);
+    return false;
+  }
+  map->capacity = cap;
+  return true;
+}
+
+void sysmon_u64map_destroy(sysmon_u64map_t *map) {
+  if (!map) return;
+  free(map->keys);
+  free(map->values);
+  free(map->used);
+  memset(map, 0, sizeof(*map));
+}
+
+void sysmon_u64map_clear(sysmon_u64map_t *map) {
+  if (!map || !map->used) return;
+  memset(map->used, 0, map->capacity);
+  map->count = 0;
+}
+
+bool sysmon_u64map_get(const sysmon_u64map_t *map, uint64_t key, uint32_t *out_value) {
+  if (!map || map->capacity == 0) return false;
+  const size_t mask = map->capacity - 1;
+  for (size_t i = (size_t)hash_u64(key) & mask;; i = (i + 1) & mask) {
+    if (!map->used[i]) return false;
+    if (map->keys[i] == key) {
+      if (out_value) *out_value = map->values[i];
+      return true;
+    }
+  }
+}
+
+static bool grow(sysmon_u64map_t *map) {
+  sysmon_u64map_t bigger;
+  if (!sysmon_u64map_init(&bigger, map->capacity)) return false;
+  for (size_t i = 0; i < map->capacity; i++) {
+    if (map->used[i]) sysmon_u64map_put(&bigger, map->keys[i], map->values[i]);
+  }
+  sysmon_u64map_destroy(map);
+  *map = bigger;
+  return true;
+}
+
+bool sysmon_u64map_put(sysmon_u64map_t *map, uint64_t key, uint32_t value) {
+  if (!map || map->capacity == 0) return false;
+  if ((map->count + 1) * 10 > map->capacity * 7 && !grow(map)) return false;
+  const size_t mask = map->capacity - 1;
+  size_t i = (size_t)hash_u64(key) & mask;
+  while (map->used[i] && map->keys[i] != key) i = (i + 1) & mask;
+  if (!map->used[i]) {
+    map->used[i] = 1;
+    map->keys[i] = key;
+    map->count++;
+  }
+  map->values[i] = value;
+  return true;
+}
+
+/* Linear probing with backward-shift deletion, so lookups never need tombstones. */
+bool sysmon_u64map_remove(sysmon_u64map_t *map, uint64_t key) {
+  if (!map || map->capacity == 0) return false;
+  const size_t mask = map->capacity - 1;
+  size_t i = (size_t)hash_u64(key) & mask;
+  while (map->used[i] && map->keys[i] != key) i = (i + 1) & mask;
+  if (!map->used[i]) return false;
+
+  for (size_t j = (i + 1) & mask; map->used[j]; j = (j + 1) & mask) {
+    const size_t home = (size_t)hash_u64(map->keys[j]) & mask;
+    const bool movable = i <= j ? (home <= i || home > j) : (home <= i && home > j);
+    if (!movable) continue;
+    map->keys[i] = map->keys[j];
+    map->values[i] = map->values[j];
+    i = j;
+  }
+  map->used[i] = 0;
+  map->count--;
+  return true;
+}
+
+bool sysmon_topk_init(sysmon_topk_t *topk, size_t k) {
+  if (!topk) return false;
+  memset(topk, 0, sizeof(*topk));
+  if (k == 0) return true;
+  topk->items = (sysmon_topk_item_t *)calloc(k, sizeof(*topk->items));
+  if (!topk->items) return false;
+  topk->k = k;
+  return true;
+}
+
+void sysmon_topk_destroy(sysmon_topk_t *topk) {
+  if (!topk) return;
+  free(topk->items);
+  memset(topk, 0, sizeof(*topk));
+}
+
+static void sift_down(sysmon_topk_item_t *h, size_t n, size_t i) {
+  for (;;) {
+    size_t smallest = i;
+    const size_t l = 2 * i + 1, r = l + 1;
+    if (l < n && h[l].score < h[smallest].score) smallest = l;
+    if (r < n && h[r].score < h[smallest].score) smallest = r;
+    if (smallest == i) return;
+    const sysmon_topk_item_t tmp = h[i];
+    h[i] = h[smallest];
+    h[smallest] = tmp;
+    i = smallest;
+  }
+}
+
+void sysmon_topk_offer(sysmon_topk_t *topk, double score, uint32_t index) {
+  if (!topk || topk->k == 0) return;
+  sysmon_topk_item_t *h = topk->items;
+  if (topk->count < topk->k) {
+    size_t i = topk->count++;
+    h[i].score = score;
+    h[i].index = index;
+    while (i > 0) {
+      const size_t parent = (i - 1) / 2;
+      if (h[parent].score <= h[i].score) break;
+      const sysmon_topk_item_t tmp = h[i];
+      h[i] = h[parent];
+      h[parent] = tmp;
+      i = parent;
+    }
+    return;
+  }
+  if (score <= h[0].score) return;
+  h[0].score = score;
+  h[0].index = index;
+  sift_down(h, topk->count, 0);
+}
+
+void sysmon_topk_sort_desc(sysmon_topk_t *topk) {
+  if (!topk) return;
+  /* Heap-sort in place: repeatedly move the minimum to the end. */
+  for (size_t n = topk->count; n > 1; n--) {
+    const sysmon_topk_item_t tmp = topk->items[0];
+    topk->items[0] = topk->items[n - 1];
+    topk->items[n - 1] = tmp;
+    sift_down(topk->items, n - 1, 0);
+  }
+}
@@ -1,12 +1,14 @@
 #include "sysmon_internal.h"
 
 #include <stdio.h>
+#include <string.h>
 
 sysmon_result_t sysmon_config_load_from_ini(const sysmon_ini_t *ini, sysmon_config_t *out_config,
                                            char **out_error) {
   if (!out_config) return SYSMON_ERR_INVALID_ARGUMENT;
 
   out_config->interval_ms = 1000;
+  out_config->coarse_clock = false;
   if (!ini) return SYSMON_OK;
 
   bool ok = true;
@@ -17,6 +19,18 @@ sysmon_result_t sysmon_config_load_from_ini(const sysmon_ini_t *ini, sysmon_conf
     return SYSMON_ERR_PARSE;
   }
   out_config->interval_ms = interval_ms;
+
+  const char *clock = sysmon_ini_get(ini, "sysmon", "clock");
+  if (clock && *clock) {
+    if (strcmp(clock, "monotonic") == 0) {
+      out_config->coarse_clock = false;
+    } else if (strcmp(clock, "monotonic_coarse") == 0) {
+      out_config->coarse_clock = true;
+    } else {
+      sysmon_set_error(out_error, "invalid sysmon.clock (must be monotonic or monotonic_coarse)");
+      return SYSMON_ERR_PARSE;
+    }
+  }
   return SYSMON_OK;
 }
 
@@ -0,0 +1,337 @@
+#include "sysmon_internal.h"
+#include "sysmon_parse.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static bool copy_root(char *dst, size_t dst_len, const char *root, const char *default_root) {
+  if (!root || !*root) root = default_root;
+  size_t n = strlen(root);
+  while (n > 1 && root[n - 1] == '/') n--;
+  if (n >= dst_len) return false;
+  memcpy(dst, root, n);
+  dst[n] = '\0';
+  return true;
+}
+
+sysmon_result_t sysmon_paths_init(sysmon_paths_t *paths, const char *proc_root,
+                                  const char *sys_root) {
+  if (!paths) return SYSMON_ERR_INVALID_ARGUMENT;
+  if (!copy_root(paths->proc_root, sizeof(paths->proc_root), proc_root, "/proc") ||
+      !copy_root(paths->sys_root, sizeof(paths->sys_root), sys_root, "/sys"))
+    return SYSMON_ERR_INVALID_ARGUMENT;
+  return SYSMON_OK;
+}
+
+static bool join_path(const char *root, const char *rel, char *out, size_t out_len) {
+  const int n = snprintf(out, out_len, "%s/%s", root, rel ? rel : "");
+  if (n >= 0 && (size_t)n < out_len) return true;
+  if (out_len > 0) out[0] = '\0';
+  return false;
+}
+
+bool sysmon_proc_path(const sysmon_paths_t *paths, const char *rel, char *out, size_t out_len) {
+  return join_path(paths ? paths->proc_root : "/proc", rel, out, out_len);
+}
+
+bool sysmon_sys_path(const sysmon_paths_t *paths, const char *rel, char *out, size_t out_len) {
+  return join_path(paths ? paths->sys_root : "/sys", rel, out, out_len);
+}
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+size_t sysmon_fd_budget(uint32_t requested) {
+  struct rlimit rl;
+  if (getrlimit(RLIMIT_NOFILE, &rl) != 0 || rl.rlim_cur == RLIM_INFINITY) return requested;
+  const rlim_t share = rl.rlim_cur / SYSMON_FD_BUDGET_SHARE;
+  return (rlim_t)requested < share ? (size_t)requested : (size_t)share;
+}
+
+bool sysmon_out_of_fds(void) { return errno == EMFILE || errno == ENFILE; }
+
+bool sysmon_glob_list_match(const char *list, const char *s, int fnmatch_flags) {
+  char pattern[SYSMON_PATH_LEN];
+  for (const char *p = list ? list : ""; *p;) {
+    while (*p == ' ' || *p == ',') p++;
+    const char *end = p;
+    while (*end && *end != ',') end++;
+    size_t n = (size_t)(end - p);
+    while (n > 0 && p[n - 1] == ' ') n--;
+    if (n > 0 && n < sizeof(pattern)) {
+      memcpy(pattern, p, n);
+      pattern[n] = '\0';
+      if (fnmatch(pattern, s, fnmatch_flags) == 0) return true;
+    }
+    p = end;
+  }
+  return false;
+}
+
+bool sysmon_select_names(const char *list, const void *table, size_t count, size_t stride,
+                         bool *selected, const char *what, char **out_error) {
+  for (const char *p = list; *p;) {
+    while (*p == ' ' || *p == ',') p++;
+    const char *end = p;
+    while (*end && *end != ',' && *end != ' ') end++;
+    const size_t n = (size_t)(end - p);
+    if (n == 0) break;
+    size_t i = 0;
+    for (; i < count; i++) {
+      const char *name = *(const char *const *)((const char *)table + i * stride);
+      if (strlen(name) == n && strncmp(p, name, n) == 0) break;
+    }
+    if (i == count) {
+      char buf[128];
+      snprintf(buf, sizeof(buf), "unknown %s '%.*s'", what, (int)(n < 64 ? n : 64), p);
+      sysmon_set_error(out_error, buf);
+      return false;
+    }
+    selected[i] = true;
+    p = end;
+  }
+  return true;
+}
+
+void sysmon_file_init(sysmon_file_t *file) {
+  if (!file) return;
+  memset(file, 0, sizeof(*file));
+  file->fd = -1;
+}
+
+bool sysmon_file_open(sysmon_file_t *file, const char *path) {
+  if (!file || !path) return false;
+  if (file->fd >= 0) close(file->fd);
+  free(file->path);
+  file->path = sysmon_strdup(path);
+  file->fd = open(path, O_RDONLY | O_CLOEXEC);
+  file->len = 0;
+  return file->fd >= 0;
+}
+
+bool sysmon_file_read(sysmon_file_t *file) {
+  if (!file || file->fd < 0) return false;
+  file->len = 0;
+  for (;;) {
+    if (file->cap - file->len < SYSMON_PARSE_PADDING + 2) {
+      const size_t new_cap = file->cap ? file->cap * 2 : 4096;
+      char *p = (char *)realloc(file->buf, new_cap);
+      if (!p) return false;
+      file->buf = p;
+      file->cap = new_cap;
+    }
+    const ssize_t n = pread(file->fd, file->buf + file->len,
+                            file->cap - file->len - SYSMON_PARSE_PADDING - 1, (off_t)file->len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    if (n == 0) break;
+    file->len += (size_t)n;
+  }
+  memset(file->buf + file->len, 0, SYSMON_PARSE_PADDING + 1);
+  return true;
+}
+
+void sysmon_file_close(sysmon_file_t *file) {
+  if (!file) return;
+  if (file->fd >= 0) close(file->fd);
+  free(file->path);
+  free(file->buf);
+  sysmon_file_init(file);
+}
+
+void sysmon_close_fd(int *fd) {
+  if (*fd >= 0) close(*fd);
+  *fd = -1;
+}
+
+bool sysmon_pread_i64(int fd, int64_t *out) {
+  char buf[32 + SYSMON_PARSE_PADDING + 1];
+  ssize_t len;
+  do {
+    len = pread(fd, buf, 32, 0);
+  } while (len < 0 && errno == EINTR);
+  if (len <= 0) return false;
+  memset(buf + len, 0, SYSMON_PARSE_PADDING + 1);
+  const char *p = buf;
+  const bool neg = *p == '-';
+  if (neg) p++;
+  uint64_t v = 0;
+  if (!sysmon_parse_u64(&p, &v)) return false;
+  *out = neg ? -(int64_t)v : (int64_t)v;
+  return true;
+}
+
+bool sysmon_read_id_list(const char *path, int **out, size_t *out_count) {
+  sysmon_file_t f;
+  sysmon_file_init(&f);
+  if (!sysmon_file_open(&f, path) || !sysmon_file_read(&f)) {
+    sysmon_file_close(&f);
+    return false;
+  }
+  size_t count = 0, cap = 0;
+  int *ids = NULL;
+  const char *p = f.buf;
+  while (*p && *p != '\n') {
+    char *end = NULL;
+    long lo = strtol(p, &end, 10), hi = lo;
+    if (end == p || lo < 0) break;
+    p = end;
+    if (*p == '-') {
+      hi = strtol(p + 1, &end, 10);
+      if (end == p + 1 || hi < lo) break;
+      p = end;
+    }
+    for (long id = lo; id <= hi; id++) {
+      if (count == cap) {
+        cap = cap ? cap * 2 : 16;
+        int *grown = (int *)realloc(ids, cap * sizeof(*ids));
+        if (!grown) {
+          free(ids);
+          sysmon_file_close(&f);
+          return false;
+        }
+        ids = grown;
+      }
+      ids[count++] = (int)id;
+    }
+    if (*p == ',') p++;
+  }
+  sysmon_file_close(&f);
+  *out = ids;
+  *out_count = count;
+  return true;
+}
+#endif
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+
+/* Directories are only watched for the limit file appearing or going away (a controller
+ * enabled in the parent); writes are caught on the file itself, so bumps to memory.events
+ * and the like never queue anything. */
+#define SYSMON_CGROUP_DIR_MASK (IN_CREATE | IN_DELETE | IN_ONLYDIR)
+
+static void cgroup_limit_watch(sysmon_cgroup_limit_t *limit) {
+  char path[SYSMON_PATH_LEN + 64];
+  size_t len = strlen(limit->dir);
+  for (;;) {
+    snprintf(path, sizeof(path), "%.*s", (int)len, limit->dir);
+    inotify_add_watch(limit->inotify_fd, path, SYSMON_CGROUP_DIR_MASK);
+    snprintf(path, sizeof(path), "%.*s/%s", (int)len, limit->dir, limit->file);
+    inotify_add_watch(limit->inotify_fd, path, IN_MODIFY); /* absent at the root */
+    if (len <= limit->root_len) break;
+    while (len > limit->root_len && limit->dir[len - 1] != '/') len--;
+    if (len > limit->root_len) len--;
+  }
+}
+
+bool sysmon_cgroup_limit_open(sysmon_cgroup_limit_t *limit, const sysmon_paths_t *paths,
+                              const char *file) {
+  memset(limit, 0, sizeof(*limit));
+  limit->inotify_fd = -1;
+  limit->file = file;
+  limit->dirty = true;
+
+  /* Unified hierarchy at fs/cgroup, or fs/cgroup/unified on hybrid v1/v2 hosts. */
+  static const char *const candidates[] = {"fs/cgroup", "fs/cgroup/unified"};
+  char root[SYSMON_PATH_LEN], probe[SYSMON_PATH_LEN + 32];
+  bool found = false;
+  for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]) && !found; i++) {
+    sysmon_sys_path(paths, candidates[i], root, sizeof(root));
+    snprintf(probe, sizeof(probe), "%s/cgroup.controllers", root);
+    found = access(probe, R_OK) == 0;
+  }
+  if (!found) return false;
+
+  /* "0::/system.slice/foo.service" */
+  char path[SYSMON_PATH_LEN];
+  sysmon_proc_path(paths, "self/cgroup", path, sizeof(path));
+  sysmon_file_t f;
+  sysmon_file_init(&f);
+  const char *rel = NULL;
+  if (sysmon_file_open(&f, path) && sysmon_file_read(&f)) {
+    for (const char *p = f.buf; *p; p = sysmon_next_line(p)) {
+      if (strncmp(p, "0::", 3) == 0) {
+        rel = p + 3;
+        break;
+      }
+    }
+  }
+  size_t rel_len = 0;
+  if (rel) {
+    while (rel[rel_len] && rel[rel_len] != '\n') rel_len++;
+    while (rel_len > 0 && rel[rel_len - 1] == '/') rel_len--;
+  }
+  const int n = rel ? snprintf(limit->dir, sizeof(limit->dir), "%s%.*s", root, (int)rel_len, rel)
+                    : -1;
+  sysmon_file_close(&f);
+  if (n < 0 || (size_t)n >= sizeof(limit->dir)) return false;
+  limit->root_len = strlen(root);
+
+  limit->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (limit->inotify_fd < 0) return false;
+  cgroup_limit_watch(limit);
+  return true;
+}
+
+bool sysmon_cgroup_limit_changed(sysmon_cgroup_limit_t *limit) {
+  _Alignas(struct inotify_event) char buf[4096];
+  bool rewatch = false;
+  for (;;) {
+    const ssize_t len = read(limit->inotify_fd, buf, sizeof(buf));
+    if (len < 0 && errno == EINTR) continue;
+    if (len <= 0) break;
+    for (ssize_t off = 0; off < len;) {
+      const struct inotify_event *ev = (const struct inotify_event *)(buf + off);
+      off += (ssize_t)(sizeof(*ev) + ev->len);
+      if (ev->mask & IN_IGNORED) continue;
+      if (!ev->len || strcmp(ev->name, limit->file) == 0 || (ev->mask & IN_Q_OVERFLOW))
+        limit->dirty = true;
+      if (ev->len && (ev->mask & IN_CREATE) && strcmp(ev->name, limit->file) == 0)
+        rewatch = true;
+    }
+  }
+  if (rewatch) cgroup_limit_watch(limit);
+  const bool changed = limit->dirty;
+  limit->dirty = false;
+  return changed;
+}
+
+bool sysmon_cgroup_limit_read(const sysmon_cgroup_limit_t *limit, double (*parse)(const char *),
+                              double *out) {
+  char path[SYSMON_PATH_LEN + 64];
+  char text[128 + SYSMON_PARSE_PADDING];
+  size_t len = strlen(limit->dir);
+  bool found = false;
+  for (;;) {
+    snprintf(path, sizeof(path), "%.*s/%s", (int)len, limit->dir, limit->file);
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+      const ssize_t n = read(fd, text, 127);
+      close(fd);
+      memset(text + (n > 0 ? n : 0), 0, SYSMON_PARSE_PADDING + 1);
+      const double v = parse(text);
+      if (v >= 0.0 && (!found || v < *out)) {
+        *out = v;
+        found = true;
+      }
+    }
+    if (len <= limit->root_len) break;
+    while (len > limit->root_len && limit->dir[len - 1] != '/') len--;
+    if (len > limit->root_len) len--;
+  }
+  return found;
+}
+
+void sysmon_cgroup_limit_close(sysmon_cgroup_limit_t *limit) {
+  if (limit->inotify_fd >= 0) close(limit->inotify_fd);
+  limit->inotify_fd = -1;
+}
+#endif
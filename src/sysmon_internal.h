@@ -6,17 +6,39 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#define SYSMON_PATH_LEN 512
+
 typedef struct sysmon_ini sysmon_ini_t;
 
+typedef struct sysmon_paths {
+  char proc_root[SYSMON_PATH_LEN];
+  char sys_root[SYSMON_PATH_LEN];
+} sysmon_paths_t;
+
 typedef struct sysmon_snapshot_builder sysmon_snapshot_builder_t;
 
+/* A kernel notification fd owned by a module. events/revents use poll(2) bits. */
+typedef struct sysmon_event_source {
+  int fd;
+  short events;
+  short revents;
+} sysmon_event_source_t;
+
 typedef struct sysmon_module_vtable {
   const char *name;
-  sysmon_result_t (*create)(const sysmon_ini_t *ini, const char *section, void **out_state,
-                            char **out_error);
-  sysmon_result_t (*poll)(void *state, uint64_t now_ms, bool refresh_now,
+  sysmon_result_t (*create)(const sysmon_paths_t *paths, const sysmon_ini_t *ini,
+                            const char *section, void **out_state, char **out_error);
+  sysmon_result_t (*poll)(void *state, uint64_t now_ns, bool refresh_now,
                           sysmon_snapshot_builder_t *builder, char **out_error);
   void (*destroy)(void *state);
+  /* Optional. Fills up to max sources and returns how many the module has (out may be NULL).
+   * sysmon_wait() polls them and hands ready ones to on_event; modules must record the event
+   * there since poll(2) consumes edge notifications such as PSI triggers. on_event returns
+   * true only when the event changes what the module reports. */
+  size_t (*event_sources)(void *state, sysmon_event_source_t *out, size_t max);
+  bool (*on_event)(void *state, const sysmon_event_source_t *source);
+  /* Expensive modules are only created when their section sets enabled=1. */
+  bool opt_in;
 } sysmon_module_vtable_t;
 
 typedef struct sysmon_module_instance {
@@ -24,11 +46,12 @@ typedef struct sysmon_module_instance {
   void *state;
   bool enabled;
   uint32_t refresh_ms;
-  uint64_t last_refresh_ms;
+  uint64_t last_refresh_ns;
 } sysmon_module_instance_t;
 
 typedef struct sysmon_config {
   uint32_t interval_ms;
+  bool coarse_clock;
 } sysmon_config_t;
 
 sysmon_result_t sysmon_config_load_from_ini(const sysmon_ini_t *ini, sysmon_config_t *out_config,
@@ -45,7 +68,10 @@ uint32_t sysmon_ini_get_u32(const sysmon_ini_t *ini, const char *section, const
 
 sysmon_result_t sysmon_snapshot_builder_create(sysmon_snapshot_builder_t **out_builder);
 sysmon_result_t sysmon_snapshot_builder_finalize(sysmon_snapshot_builder_t *builder,
+                                                uint64_t timestamp_ns,
                                                 sysmon_snapshot_t **out_snapshot);
+void sysmon_snapshot_builder_set_sample_ns(sysmon_snapshot_builder_t *builder, uint64_t sample_ns);
+uint64_t sysmon_snapshot_builder_sample_ns(const sysmon_snapshot_builder_t *builder);
 void sysmon_snapshot_builder_destroy(sysmon_snapshot_builder_t *builder);
 
 sysmon_result_t sysmon_snapshot_builder_add_double(sysmon_snapshot_builder_t *builder,
@@ -61,9 +87,128 @@ sysmon_result_t sysmon_snapshot_builder_add_string(sysmon_snapshot_builder_t *bu
                                                    const char *name, const char *unit,
                                                    const char *value);
 
-uint64_t sysmon_now_ms(void);
+#define SYSMON_NS_PER_MS 1000000ull
+#define SYSMON_NS_PER_SEC 1000000000ull
+
+uint64_t sysmon_now_ns(bool coarse);
+
+/* True when a module should re-read its sources: on the scheduler's refresh_now, or on its own
+ * when its cached data is stale (first poll, kernel event, retry). Stamps the metrics added
+ * from here on with now_ns, so an unscheduled refresh is not reported as the previous one. */
+static inline bool sysmon_refresh_due(sysmon_snapshot_builder_t *builder, uint64_t now_ns,
+                                      bool refresh_now, bool stale) {
+  if (!refresh_now && !stale) return false;
+  sysmon_snapshot_builder_set_sample_ns(builder, now_ns);
+  return true;
+}
+
+/* Open-addressed uint64 -> uint32 map (linear probing, power-of-two capacity). */
+typedef struct sysmon_u64map {
+  uint64_t *keys;
+  uint32_t *values;
+  unsigned char *used;
+  size_t capacity;
+  size_t count;
+} sysmon_u64map_t;
+
+bool sysmon_u64map_init(sysmon_u64map_t *map, size_t initial_capacity);
+void sysmon_u64map_destroy(sysmon_u64map_t *map);
+void sysmon_u64map_clear(sysmon_u64map_t *map);
+bool sysmon_u64map_get(const sysmon_u64map_t *map, uint64_t key, uint32_t *out_value);
+bool sysmon_u64map_put(sysmon_u64map_t *map, uint64_t key, uint32_t value);
+bool sysmon_u64map_remove(sysmon_u64map_t *map, uint64_t key);
+
+/* Bounded min-heap keeping the k highest scores seen since the last reset. */
+typedef struct sysmon_topk_item {
+  double score;
+  uint32_t index;
+} sysmon_topk_item_t;
+
+typedef struct sysmon_topk {
+  sysmon_topk_item_t *items;
+  size_t count;
+  size_t k;
+} sysmon_topk_t;
+
+bool sysmon_topk_init(sysmon_topk_t *topk, size_t k);
+void sysmon_topk_destroy(sysmon_topk_t *topk);
+static inline void sysmon_topk_reset(sysmon_topk_t *topk) { topk->count = 0; }
+void sysmon_topk_offer(sysmon_topk_t *topk, double score, uint32_t index);
+void sysmon_topk_sort_desc(sysmon_topk_t *topk);
+
+sysmon_result_t sysmon_paths_init(sysmon_paths_t *paths, const char *proc_root,
+                                  const char *sys_root);
+/* <root>/<rel> into out. A path that does not fit leaves out empty, so opening it fails
+ * instead of reaching a truncated prefix, and returns false. */
+bool sysmon_proc_path(const sysmon_paths_t *paths, const char *rel, char *out, size_t out_len);
+bool sysmon_sys_path(const sysmon_paths_t *paths, const char *rel, char *out, size_t out_len);
+
+/* True if s matches one of the comma-separated fnmatch patterns in list. */
+bool sysmon_glob_list_match(const char *list, const char *s, int fnmatch_flags);
+
+/* Marks selected[i] for each name of a comma-separated list such as "pgfault,pswpin". table
+ * holds count entries of stride bytes whose first member is the `const char *` name; an unknown
+ * name fails with "unknown <what> '<name>'" (what: "vmstat counter", "psi resource"...). */
+bool sysmon_select_names(const char *list, const void *table, size_t count, size_t stride,
+                         bool *selected, const char *what, char **out_error);
+
+/* A file kept open across polls and re-read from offset 0 with pread. buf is NUL-terminated;
+ * path is the resolved path given to sysmon_file_open, kept for error messages. */
+typedef struct sysmon_file {
+  int fd;
+  char *path;
+  char *buf;
+  size_t len;
+  size_t cap;
+} sysmon_file_t;
+
+void sysmon_file_init(sysmon_file_t *file);
+bool sysmon_file_open(sysmon_file_t *file, const char *path);
+bool sysmon_file_read(sysmon_file_t *file);
+void sysmon_file_close(sysmon_file_t *file);
+
+/* Closes *fd if open and marks it closed (-1). */
+void sysmon_close_fd(int *fd);
+
+/* Single-value attribute ("1234\n", "-5\n") re-read at offset 0; sysfs regenerates the text on
+ * every pread. */
+bool sysmon_pread_i64(int fd, int64_t *out);
+
+/* Modules that cache descriptors between refreshes (process, cgroup, self) each keep at most
+ * 1/SYSMON_FD_BUDGET_SHARE of the RLIMIT_NOFILE soft limit, whatever fd_budget asks for, so the
+ * embedding application keeps most of its descriptors. */
+#define SYSMON_FD_BUDGET_SHARE 4
+size_t sysmon_fd_budget(uint32_t requested);
+
+/* errno is EMFILE/ENFILE: a failed open says nothing about the PID or TID it was for. */
+bool sysmon_out_of_fds(void);
+
+/* Parses a sysfs range list such as "0-3,6,8-11" (cpu/online, node/online) into a malloc'd array. */
+bool sysmon_read_id_list(const char *path, int **out, size_t *out_count);
+
+/* The caller's own cgroup v2 directory, with an inotify watch on it and each ancestor so a
+ * limit file such as cpu.max or memory.max is only re-read after somebody writes it. */
+typedef struct sysmon_cgroup_limit {
+  char dir[SYSMON_PATH_LEN];
+  size_t root_len;
+  const char *file;
+  int inotify_fd;
+  bool dirty;
+} sysmon_cgroup_limit_t;
+
+bool sysmon_cgroup_limit_open(sysmon_cgroup_limit_t *limit, const sysmon_paths_t *paths,
+                              const char *file);
+/* True on the first call and whenever `file` changed in the cgroup or one of its ancestors. */
+bool sysmon_cgroup_limit_changed(sysmon_cgroup_limit_t *limit);
+/* Smallest value `parse` returns over the hierarchy; false when no level sets a limit
+ * (parse returns a negative value for "max" or a missing file). */
+bool sysmon_cgroup_limit_read(const sysmon_cgroup_limit_t *limit, double (*parse)(const char *),
+                              double *out);
+void sysmon_cgroup_limit_close(sysmon_cgroup_limit_t *limit);
 
 const sysmon_module_vtable_t *sysmon_builtin_modules(size_t *out_count);
 
 char *sysmon_strdup(const char *s);
 void sysmon_set_error(char **target, const char *message);
+/* "<what> <path>", so errors name the file actually opened under proc_root / sys_root. */
+void sysmon_set_path_error(char **target, const char *what, const char *path);
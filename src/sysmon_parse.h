@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Minimal cursor-based parsers for procfs/sysfs text.
+ *
+ * Input must be NUL-terminated and followed by SYSMON_PARSE_PADDING readable bytes:
+ * sysmon_parse_u64 consumes eight digits at a time with a single 64-bit load.
+ * Buffers filled by sysmon_file_read satisfy this. */
+#define SYSMON_PARSE_PADDING 8
+
+static inline const char *sysmon_skip_blanks(const char *p) {
+  while (*p == ' ' || *p == '\t') p++;
+  return p;
+}
+
+static inline const char *sysmon_next_line(const char *p) {
+  while (*p && *p != '\n') p++;
+  return *p ? p + 1 : p;
+}
+
+/* Skips n space-separated fields, e.g. to reach a column of /proc/<pid>/stat past comm. */
+static inline const char *sysmon_skip_fields(const char *p, unsigned n) {
+  while (n-- > 0) {
+    while (*p && *p != ' ') p++;
+    if (*p) p++;
+  }
+  return p;
+}
+
+/* Like sysmon_skip_blanks but skips space runs eight bytes per load; the per-CPU matrices in
+ * /proc/interrupts and /proc/softirqs are mostly column padding. */
+static inline const char *sysmon_skip_spaces_wide(const char *p) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  for (;;) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    const uint64_t x = v ^ 0x2020202020202020ull;
+    if (x) {
+      p += __builtin_ctzll(x) >> 3;
+      break;
+    }
+    p += 8;
+  }
+#endif
+  return sysmon_skip_blanks(p);
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+static inline bool sysmon_parse_8_digits(const char *p, uint64_t *out) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  if ((((v & 0xf0f0f0f0f0f0f0f0ull) | (((v + 0x0606060606060606ull) & 0xf0f0f0f0f0f0f0f0ull) >> 4)) !=
+       0x3333333333333333ull))
+    return false;
+  v = ((v & 0x0f0f0f0f0f0f0f0full) * 2561) >> 8;
+  v = ((v & 0x00ff00ff00ff00ffull) * 6553601) >> 16;
+  *out = ((v & 0x0000ffff0000ffffull) * 42949672960001ull) >> 32;
+  return true;
+}
+#endif
+
+static inline bool sysmon_parse_u64(const char **cursor, uint64_t *out) {
+  const char *p = sysmon_skip_blanks(*cursor);
+  if (*p < '0' || *p > '9') return false;
+  uint64_t v = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  uint64_t chunk = 0;
+  while (sysmon_parse_8_digits(p, &chunk)) {
+    v = v * 100000000u + chunk;
+    p += 8;
+  }
+#endif
+  while (*p >= '0' && *p <= '9') v = v * 10u + (uint64_t)(*p++ - '0');
+  *out = v;
+  *cursor = p;
+  return true;
+}
+
+/* Value of a "Key:   123 kB" line in /proc/<pid>/status-style text, 0 if the key is absent. */
+static inline uint64_t sysmon_status_value(const char *p, const char *key) {
+  const size_t len = strlen(key);
+  for (; *p; p = sysmon_next_line(p)) {
+    if (strncmp(p, key, len) != 0 || p[len] != ':') continue;
+    const char *v = sysmon_skip_blanks(p + len + 1);
+    uint64_t out = 0;
+    sysmon_parse_u64(&v, &out);
+    return out;
+  }
+  return 0;
+}
@@ -6,12 +6,14 @@
 struct sysmon_snapshot {
   sysmon_metric_t *metrics;
   size_t count;
+  uint64_t timestamp_ns;
 };
 
 struct sysmon_snapshot_builder {
   sysmon_metric_t *metrics;
   size_t count;
   size_t capacity;
+  uint64_t sample_ns;
 };
 
 static sysmon_result_t ensure_capacity(sysmon_snapshot_builder_t *b, char **out_error) {
@@ -46,13 +48,23 @@ void sysmon_snapshot_builder_destroy(sysmon_snapshot_builder_t *builder) {
   free(builder);
 }
 
+void sysmon_snapshot_builder_set_sample_ns(sysmon_snapshot_builder_t *builder, uint64_t sample_ns) {
+  if (builder) builder->sample_ns = sample_ns;
+}
+
+uint64_t sysmon_snapshot_builder_sample_ns(const sysmon_snapshot_builder_t *builder) {
+  return builder ? builder->sample_ns : 0;
+}
+
 sysmon_result_t sysmon_snapshot_builder_finalize(sysmon_snapshot_builder_t *builder,
+                                                uint64_t timestamp_ns,
                                                 sysmon_snapshot_t **out_snapshot) {
   if (!builder || !out_snapshot) return SYSMON_ERR_INVALID_ARGUMENT;
   sysmon_snapshot_t *s = (sysmon_snapshot_t *)calloc(1, sizeof(*s));
   if (!s) return SYSMON_ERR_OUT_OF_MEMORY;
   s->metrics = builder->metrics;
   s->count = builder->count;
+  s->timestamp_ns = timestamp_ns;
   builder->metrics = NULL;
   builder->count = 0;
   builder->capacity = 0;
@@ -80,6 +92,7 @@ static sysmon_result_t add_common(sysmon_snapshot_builder_t *b, const char *name
   m->type = type;
   m->name = name_copy;
   m->unit = unit_copy;
+  m->sample_ns = b->sample_ns;
   return SYSMON_OK;
 }
 
@@ -148,6 +161,11 @@ const sysmon_metric_t *sysmon_snapshot_metric_at(const sysmon_snapshot_t *snapsh
   return &snapshot->metrics[index];
 }
 
+const sysmon_metric_t *sysmon_snapshot_metrics(const sysmon_snapshot_t *snapshot, size_t *out_count) {
+  if (out_count) *out_count = snapshot ? snapshot->count : 0;
+  return snapshot ? snapshot->metrics : NULL;
+}
+
 const sysmon_metric_t *sysmon_snapshot_find(const sysmon_snapshot_t *snapshot, const char *name) {
   if (!snapshot || !name) return NULL;
   for (size_t i = 0; i < snapshot->count; i++) {
@@ -156,3 +174,14 @@ const sysmon_metric_t *sysmon_snapshot_find(const sysmon_snapshot_t *snapshot, c
   }
   return NULL;
 }
+
+uint64_t sysmon_snapshot_timestamp_ns(const sysmon_snapshot_t *snapshot) {
+  return snapshot ? snapshot->timestamp_ns : 0;
+}
+
+uint64_t sysmon_snapshot_metric_age_ns(const sysmon_snapshot_t *snapshot,
+                                       const sysmon_metric_t *metric) {
+  if (!snapshot || !metric || metric->sample_ns == 0 || metric->sample_ns > snapshot->timestamp_ns)
+    return 0;
+  return snapshot->timestamp_ns - metric->sample_ns;
+}
@@ -2,9 +2,14 @@
 
 #include <time.h>
 
-uint64_t sysmon_now_ms(void) {
+uint64_t sysmon_now_ns(bool coarse) {
+  clockid_t clock = CLOCK_MONOTONIC;
+#if defined(CLOCK_MONOTONIC_COARSE)
+  if (coarse) clock = CLOCK_MONOTONIC_COARSE;
+#else
+  (void)coarse;
+#endif
   struct timespec ts;
-  if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) return 0;
-  return (uint64_t)ts.tv_sec * 1000ull + (uint64_t)ts.tv_nsec / 1000000ull;
+  if (clock_gettime(clock, &ts) != 0) return 0;
+  return (uint64_t)ts.tv_sec * SYSMON_NS_PER_SEC + (uint64_t)ts.tv_nsec;
 }
-
@@ -0,0 +1,177 @@
+#pragma once
+
+/* Fixture-driven module checks: each test writes kernel-format files under a temporary
+ * proc/sys root, drives one module's vtable with chosen timestamps and inspects the metrics
+ * it publishes. Header-only so every test stays a single translation unit. */
+
+#include <sysmon/sysmon.h>
+
+#include "sysmon_internal.h"
+
+#include <errno.h>
+#include <ftw.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ctest's SKIP_RETURN_CODE, for checks the sandbox cannot run (no netlink, ...). */
+#define TEST_SKIP 77
+
+static int test_failures;
+
+#define TEST_CHECK(cond)                                                  \
+  do {                                                                    \
+    if (!(cond)) {                                                        \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      test_failures++;                                                    \
+    }                                                                     \
+  } while (0)
+
+#define TEST_CHECK_NEAR(actual, expected)                                             \
+  do {                                                                                \
+    const double test_a_ = (actual), test_e_ = (expected);                            \
+    if (!(fabs(test_a_ - test_e_) <= 1e-6 * (fabs(test_e_) > 1.0 ? fabs(test_e_) : 1.0))) { \
+      fprintf(stderr, "%s:%d: %s = %g, expected %g\n", __FILE__, __LINE__, #actual,  \
+              test_a_, test_e_);                                                      \
+      test_failures++;                                                                \
+    }                                                                                 \
+  } while (0)
+
+static inline int test_finish(void) {
+  if (test_failures) fprintf(stderr, "%d check(s) failed\n", test_failures);
+  return test_failures ? 1 : 0;
+}
+
+typedef struct test_fixture {
+  char root[SYSMON_PATH_LEN - 8]; /* room for "/proc" in paths */
+  sysmon_paths_t paths;
+} test_fixture_t;
+
+static inline void test_fixture_init(test_fixture_t *fx) {
+  const char *tmp = getenv("TMPDIR");
+  snprintf(fx->root, sizeof(fx->root), "%s/sysmon-test-XXXXXX", tmp && *tmp ? tmp : "/tmp");
+  if (!mkdtemp(fx->root)) {
+    fprintf(stderr, "mkdtemp(%s) failed: %s\n", fx->root, strerror(errno));
+    exit(1);
+  }
+  snprintf(fx->paths.proc_root, sizeof(fx->paths.proc_root), "%s/proc", fx->root);
+  snprintf(fx->paths.sys_root, sizeof(fx->paths.sys_root), "%s/sys", fx->root);
+}
+
+/* Writes text to rel under the fixture root, creating parent directories. The file is
+ * truncated in place, so a module holding it open reads the new content on its next pread. */
+static inline void test_fixture_write(const test_fixture_t *fx, const char *rel, const char *text) {
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/%s", fx->root, rel);
+  for (char *slash = strchr(path + strlen(fx->root) + 1, '/'); slash; slash = strchr(slash + 1, '/')) {
+    *slash = '\0';
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+      fprintf(stderr, "mkdir(%s) failed: %s\n", path, strerror(errno));
+      exit(1);
+    }
+    *slash = '/';
+  }
+  FILE *f = fopen(path, "w");
+  if (!f || fputs(text, f) < 0 || fclose(f) != 0) {
+    fprintf(stderr, "cannot write %s: %s\n", path, strerror(errno));
+    exit(1);
+  }
+}
+
+static inline int test_remove_entry(const char *path, const struct stat *sb, int type, struct FTW *ftw) {
+  (void)sb;
+  (void)type;
+  (void)ftw;
+  return remove(path);
+}
+
+static inline void test_fixture_destroy(test_fixture_t *fx) {
+  nftw(fx->root, test_remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+typedef struct test_module {
+  const sysmon_module_vtable_t *vtable;
+  void *state;
+  sysmon_ini_t *ini;
+  char *error;
+} test_module_t;
+
+/* Creates the module from an ini body for its [module.<name>] section; on failure the
+ * module's message is left in m->error. */
+static inline sysmon_result_t test_module_create(const test_fixture_t *fx,
+                                                 const sysmon_module_vtable_t *vtable,
+                                                 const char *options, test_module_t *m) {
+  memset(m, 0, sizeof(*m));
+  m->vtable = vtable;
+  char section[128], text[4096], path[PATH_MAX];
+  snprintf(section, sizeof(section), "module.%s", vtable->name);
+  snprintf(text, sizeof(text), "[%s]\n%s\n", section, options ? options : "");
+  test_fixture_write(fx, "sysmon.ini", text);
+  snprintf(path, sizeof(path), "%s/sysmon.ini", fx->root);
+  sysmon_result_t rc = sysmon_ini_load_file(path, &m->ini, &m->error);
+  if (rc != SYSMON_OK) return rc;
+  return vtable->create(&fx->paths, m->ini, section, &m->state, &m->error);
+}
+
+static inline void test_module_destroy(test_module_t *m) {
+  if (m->state) m->vtable->destroy(m->state);
+  if (m->ini) sysmon_ini_destroy(m->ini);
+  free(m->error);
+  memset(m, 0, sizeof(*m));
+}
+
+/* One scheduled refresh at now_ns; NULL (and a counted failure) if the poll fails. */
+static inline sysmon_snapshot_t *test_module_poll(test_module_t *m, uint64_t now_ns) {
+  sysmon_snapshot_builder_t *builder = NULL;
+  sysmon_snapshot_t *snapshot = NULL;
+  if (sysmon_snapshot_builder_create(&builder) != SYSMON_OK) {
+    test_failures++;
+    return NULL;
+  }
+  free(m->error);
+  m->error = NULL;
+  sysmon_result_t rc = m->vtable->poll(m->state, now_ns, true, builder, &m->error);
+  if (rc == SYSMON_OK) rc = sysmon_snapshot_builder_finalize(builder, now_ns, &snapshot);
+  sysmon_snapshot_builder_destroy(builder);
+  if (rc != SYSMON_OK) {
+    fprintf(stderr, "%s poll failed (%d): %s\n", m->vtable->name, (int)rc,
+            m->error ? m->error : "");
+    test_failures++;
+    return NULL;
+  }
+  return snapshot;
+}
+
+static inline const sysmon_metric_t *test_metric(const sysmon_snapshot_t *s, const char *name,
+                                                 sysmon_metric_type_t type) {
+  const sysmon_metric_t *m = s ? sysmon_snapshot_find(s, name) : NULL;
+  if (!m || m->type != type) {
+    fprintf(stderr, "metric %s %s\n", name, m ? "has the wrong type" : "is missing");
+    test_failures++;
+    return NULL;
+  }
+  return m;
+}
+
+static inline double test_double(const sysmon_snapshot_t *s, const char *name) {
+  const sysmon_metric_t *m = test_metric(s, name, SYSMON_METRIC_DOUBLE);
+  return m ? m->value.f64 : NAN;
+}
+
+static inline uint64_t test_u64(const sysmon_snapshot_t *s, const char *name) {
+  const sysmon_metric_t *m = test_metric(s, name, SYSMON_METRIC_UINT64);
+  return m ? m->value.u64 : UINT64_MAX;
+}
+
+static inline const char *test_string(const sysmon_snapshot_t *s, const char *name) {
+  const sysmon_metric_t *m = test_metric(s, name, SYSMON_METRIC_STRING);
+  return m ? m->value.str : "";
+}
+
+static inline bool test_has(const sysmon_snapshot_t *s, const char *name) {
+  return s && sysmon_snapshot_find(s, name) != NULL;
+}
@@ -0,0 +1,173 @@
+#include "sysmon_test.h"
+
+const sysmon_module_vtable_t *sysmon_irq_module(void);
+
+/* One counter per (row, CPU column); the CPU ids name the columns of the header line. */
+typedef struct irq_fixture {
+  int cpu_ids[4];
+  size_t cpus;
+  uint64_t timer[4];
+  uint64_t kbd[4];
+  uint64_t loc[4];
+  uint64_t net_rx[4];
+  uint64_t sched[4];
+} irq_fixture_t;
+
+static size_t put_header(char *text, size_t len, size_t cap, const irq_fixture_t *f,
+                         const char *indent) {
+  len += (size_t)snprintf(text + len, cap - len, "%s", indent);
+  for (size_t c = 0; c < f->cpus; c++)
+    len += (size_t)snprintf(text + len, cap - len, "CPU%-8d", f->cpu_ids[c]);
+  return len + (size_t)snprintf(text + len, cap - len, "\n");
+}
+
+static size_t put_row(char *text, size_t len, size_t cap, const char *label, const uint64_t *v,
+                      size_t cpus, const char *desc) {
+  len += (size_t)snprintf(text + len, cap - len, "%s", label);
+  for (size_t c = 0; c < cpus; c++)
+    len += (size_t)snprintf(text + len, cap - len, " %10llu", (unsigned long long)v[c]);
+  return len + (size_t)snprintf(text + len, cap - len, "%s\n", desc);
+}
+
+static void write_irq(const test_fixture_t *fx, const irq_fixture_t *f) {
+  static const uint64_t zero[4] = {0, 0, 0, 0};
+  static const uint64_t err[1] = {0};
+  char text[4096];
+  size_t len = put_header(text, 0, sizeof(text), f, "           ");
+  len = put_row(text, len, sizeof(text), "  0:", f->timer, f->cpus, "   IO-APIC   2-edge      timer");
+  len = put_row(text, len, sizeof(text), "  1:", f->kbd, f->cpus, "   IO-APIC   1-edge      i8042");
+  len = put_row(text, len, sizeof(text), "NMI:", zero, f->cpus, "   Non-maskable interrupts");
+  len = put_row(text, len, sizeof(text), "LOC:", f->loc, f->cpus, "   Local timer interrupts");
+  len = put_row(text, len, sizeof(text), "ERR:", err, 1, "");
+  put_row(text, len, sizeof(text), "MIS:", err, 1, "");
+  test_fixture_write(fx, "proc/interrupts", text);
+
+  len = put_header(text, 0, sizeof(text), f, "                    ");
+  len = put_row(text, len, sizeof(text), "          HI:", zero, f->cpus, "");
+  len = put_row(text, len, sizeof(text), "      NET_RX:", f->net_rx, f->cpus, "");
+  put_row(text, len, sizeof(text), "       SCHED:", f->sched, f->cpus, "");
+  test_fixture_write(fx, "proc/softirqs", text);
+}
+
+static void advance(irq_fixture_t *f, size_t c, uint64_t timer, uint64_t kbd, uint64_t loc,
+                    uint64_t net_rx) {
+  f->timer[c] += timer;
+  f->kbd[c] += kbd;
+  f->loc[c] += loc;
+  f->net_rx[c] += net_rx;
+  f->sched[c] += 1;
+}
+
+static void test_rates(void) {
+  test_fixture_t fx;
+  test_fixture_init(&fx);
+  irq_fixture_t f = {.cpu_ids = {0, 1}, .cpus = 2, .timer = {44, 0}, .loc = {1000, 2000}};
+  write_irq(&fx, &f);
+
+  test_module_t m;
+  TEST_CHECK(test_module_create(&fx, sysmon_irq_module(), "top_n=2", &m) == SYSMON_OK);
+  sysmon_snapshot_t *s = test_module_poll(&m, SYSMON_NS_PER_SEC);
+  TEST_CHECK_NEAR(test_double(s, "irq.total_per_sec"), 0.0);
+  TEST_CHECK(!test_has(s, "irq.top.0.irq"));
+  sysmon_snapshot_destroy(s);
+
+  advance(&f, 0, 0, 10, 250, 300);
+  advance(&f, 1, 0, 30, 750, 100);
+  write_irq(&fx, &f);
+  s = test_module_poll(&m, 2 * SYSMON_NS_PER_SEC);
+  TEST_CHECK_NEAR(test_double(s, "irq.total_per_sec"), 1040.0);
+  TEST_CHECK(strcmp(test_string(s, "irq.top.0.irq"), "LOC") == 0);
+  TEST_CHECK(strcmp(test_string(s, "irq.top.0.name"), "Local timer interrupts") == 0);
+  TEST_CHECK_NEAR(test_double(s, "irq.top.0.per_sec"), 1000.0);
+  TEST_CHECK(test_has(s, "irq.top.0.busiest_cpu") &&
+             sysmon_snapshot_find(s, "irq.top.0.busiest_cpu")->value.i64 == 1);
+  TEST_CHECK_NEAR(test_double(s, "irq.top.0.busiest_cpu_percent"), 75.0);
+  TEST_CHECK(strcmp(test_string(s, "irq.top.1.irq"), "1") == 0);
+  TEST_CHECK(strcmp(test_string(s, "irq.top.1.name"), "i8042") == 0);
+  TEST_CHECK(!test_has(s, "irq.top.2.irq"));
+  TEST_CHECK_NEAR(test_double(s, "irq.softirq.net_rx_per_sec"), 400.0);
+  TEST_CHECK_NEAR(test_double(s, "irq.softirq.sched_per_sec"), 2.0);
+  TEST_CHECK_NEAR(test_double(s, "irq.softirq.hi_per_sec"), 0.0);
+  TEST_CHECK_NEAR(test_double(s, "irq.net_rx_max_cpu_share_percent"), 75.0);
+  TEST_CHECK_NEAR(test_double(s, "irq.cpu.0.net_rx_per_sec"), 300.0);
+  TEST_CHECK_NEAR(test_double(s, "irq.cpu.1.net_rx_per_sec"), 100.0);
+  sysmon_snapshot_destroy(s);
+  test_module_destroy(&m);
+  test_fixture_destroy(&fx);
+}
+
+/* CPU1 goes offline and CPU2/CPU3 come up: the columns no longer line up with the previous
+ * sample, so that refresh reports no rates rather than deltas across different CPUs. */
+static void test_column_change(void) {
+  test_fixture_t fx;
+  test_fixture_init(&fx);
+  irq_fixture_t f = {.cpu_ids = {0, 1}, .cpus = 2, .loc = {1000, 2000}, .net_rx = {10, 5000}};
+  write_irq(&fx, &f);
+
+  test_module_t m;
+  TEST_CHECK(test_module_create(&fx, sysmon_irq_module(), NULL, &m) == SYSMON_OK);
+  sysmon_snapshot_destroy(test_module_poll(&m, SYSMON_NS_PER_SEC));
+
+  irq_fixture_t g = {.cpu_ids = {0, 2, 3}, .cpus = 3, .loc = {1100, 50, 60},
+                     .net_rx = {20, 30, 40}};
+  write_irq(&fx, &g);
+  sysmon_snapshot_t *s = test_module_poll(&m, 2 * SYSMON_NS_PER_SEC);
+  TEST_CHECK_NEAR(test_double(s, "irq.total_per_sec"), 0.0);
+  TEST_CHECK_NEAR(test_double(s, "irq.softirq.net_rx_per_sec"), 0.0);
+  TEST_CHECK(test_has(s, "irq.cpu.3.net_rx_per_sec"));
+  TEST_CHECK(!test_has(s, "irq.cpu.1.net_rx_per_sec"));
+  sysmon_snapshot_destroy(s);
+
+  advance(&g, 2, 0, 0, 500, 70);
+  write_irq(&fx, &g);
+  s = test_module_poll(&m, 3 * SYSMON_NS_PER_SEC);
+  TEST_CHECK_NEAR(test_double(s, "irq.total_per_sec"), 500.0);
+  TEST_CHECK(sysmon_snapshot_find(s, "irq.top.0.busiest_cpu") &&
+             sysmon_snapshot_find(s, "irq.top.0.busiest_cpu")->value.i64 == 3);
+  TEST_CHECK_NEAR(test_double(s, "irq.cpu.3.net_rx_per_sec"), 70.0);
+  TEST_CHECK_NEAR(test_double(s, "irq.cpu.2.net_rx_per_sec"), 0.0);
+  TEST_CHECK_NEAR(test_double(s, "irq.net_rx_max_cpu_share_percent"), 100.0);
+  sysmon_snapshot_destroy(s);
+  test_module_destroy(&m);
+  test_fixture_destroy(&fx);
+}
+
+/* A new interrupt line shifts the rows below it: that refresh is a fresh baseline too. */
+static void test_row_change(void) {
+  test_fixture_t fx;
+  test_fixture_init(&fx);
+  irq_fixture_t f = {.cpu_ids = {0}, .cpus = 1, .timer = {5}, .loc = {1000}};
+  write_irq(&fx, &f);
+
+  test_module_t m;
+  TEST_CHECK(test_module_create(&fx, sysmon_irq_module(), NULL, &m) == SYSMON_OK);
+  sysmon_snapshot_destroy(test_module_poll(&m, SYSMON_NS_PER_SEC));
+
+  test_fixture_write(&fx, "proc/interrupts",
+                     "           CPU0\n"
+                     "  0:          5   IO-APIC   2-edge      timer\n"
+                     " 24:     999999   PCI-MSI 65536-edge      nvme0q0\n"
+                     "LOC:       1000   Local timer interrupts\n");
+  sysmon_snapshot_t *s = test_module_poll(&m, 2 * SYSMON_NS_PER_SEC);
+  TEST_CHECK_NEAR(test_double(s, "irq.total_per_sec"), 0.0);
+  sysmon_snapshot_destroy(s);
+
+  test_fixture_write(&fx, "proc/interrupts",
+                     "           CPU0\n"
+                     "  0:          5   IO-APIC   2-edge      timer\n"
+                     " 24:    1000009   PCI-MSI 65536-edge      nvme0q0\n"
+                     "LOC:       1000   Local timer interrupts\n");
+  s = test_module_poll(&m, 3 * SYSMON_NS_PER_SEC);
+  TEST_CHECK_NEAR(test_double(s, "irq.total_per_sec"), 10.0);
+  TEST_CHECK(strcmp(test_string(s, "irq.top.0.name"), "nvme0q0") == 0);
+  sysmon_snapshot_destroy(s);
+  test_module_destroy(&m);
+  test_fixture_destroy(&fx);
+}
+
+int main(void) {
+  test_rates();
+  test_column_change();
+  test_row_change();
+  return test_finish();
+}
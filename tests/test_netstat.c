@@ -0,0 +1,126 @@
+#include "sysmon_test.h"
+
+const sysmon_module_vtable_t *sysmon_netstat_module(void);
+
+/* /proc/net/snmp as the kernel lays it out: a header line then a value line per group, with
+ * Tcp MaxConn at -1 ahead of the selected columns. */
+static void write_snmp(const test_fixture_t *fx, uint64_t out_segs, uint64_t retrans,
+                       uint64_t estab, uint64_t udp_errors, bool extra_column) {
+  char text[2048];
+  snprintf(text, sizeof(text),
+           "Ip: Forwarding DefaultTTL InReceives InHdrErrors InAddrErrors ForwDatagrams "
+           "InUnknownProtos InDiscards InDelivers OutRequests OutDiscards OutNoRoutes "
+           "ReasmTimeout ReasmReqds ReasmOKs ReasmFails FragOKs FragCreates FragFails\n"
+           "Ip: 1 64 1000 0 0 0 0 0 1000 900 0 0 0 0 0 3 0 0 5\n"
+           "Icmp: InMsgs InErrors\n"
+           "Icmp: 7 0\n"
+           "Tcp: RtoAlgorithm RtoMin RtoMax MaxConn ActiveOpens PassiveOpens AttemptFails%s "
+           "EstabResets CurrEstab InSegs OutSegs RetransSegs InErrs OutRsts\n"
+           "Tcp: 1 200 120000 -1 10 20 0%s 4 %llu 5000 %llu %llu 0 0\n"
+           "Udp: InDatagrams NoPorts InErrors OutDatagrams RcvbufErrors SndbufErrors\n"
+           "Udp: 100 0 %llu 100 2 0\n",
+           extra_column ? " FutureCounter" : "", extra_column ? " 999" : "",
+           (unsigned long long)estab, (unsigned long long)out_segs, (unsigned long long)retrans,
+           (unsigned long long)udp_errors);
+  test_fixture_write(fx, "proc/net/snmp", text);
+}
+
+static void write_netstat(const test_fixture_t *fx, uint64_t overflows, uint64_t drops) {
+  char text[1024];
+  snprintf(text, sizeof(text),
+           "TcpExt: SyncookiesSent SyncookiesRecv ListenOverflows ListenDrops TCPTimeouts\n"
+           "TcpExt: 0 0 %llu %llu 11\n"
+           "IpExt: InNoRoutes InTruncatedPkts\n"
+           "IpExt: 0 0\n",
+           (unsigned long long)overflows, (unsigned long long)drops);
+  test_fixture_write(fx, "proc/net/netstat", text);
+}
+
+static void test_header_value_pairs(void) {
+  test_fixture_t fx;
+  test_fixture_init(&fx);
+  write_snmp(&fx, 1000, 10, 7, 1, false);
+  write_netstat(&fx, 100, 200);
+
+  test_module_t m;
+  TEST_CHECK(test_module_create(&fx, sysmon_netstat_module(), NULL, &m) == SYSMON_OK);
+  sysmon_snapshot_t *s = test_module_poll(&m, SYSMON_NS_PER_SEC);
+  TEST_CHECK(test_u64(s, "netstat.tcp_curr_estab") == 7);
+  TEST_CHECK_NEAR(test_double(s, "netstat.tcp_out_segs_per_sec"), 0.0);
+  sysmon_snapshot_destroy(s);
+
+  write_snmp(&fx, 1400, 30, 9, 5, false);
+  write_netstat(&fx, 104, 210);
+  s = test_module_poll(&m, 3 * SYSMON_NS_PER_SEC);
+  TEST_CHECK(test_u64(s, "netstat.tcp_curr_estab") == 9);
+  TEST_CHECK_NEAR(test_double(s, "netstat.tcp_out_segs_per_sec"), 200.0);
+  TEST_CHECK_NEAR(test_double(s, "netstat.tcp_retrans_segs_per_sec"), 10.0);
+  TEST_CHECK_NEAR(test_double(s, "netstat.tcp_retrans_percent"), 5.0);
+  TEST_CHECK_NEAR(test_double(s, "netstat.udp_in_errors_per_sec"), 2.0);
+  TEST_CHECK_NEAR(test_double(s, "netstat.udp_rcvbuf_errors_per_sec"), 0.0);
+  TEST_CHECK_NEAR(test_double(s, "netstat.tcp_listen_overflows_per_sec"), 2.0);
+  TEST_CHECK_NEAR(test_double(s, "netstat.tcp_listen_drops_per_sec"), 5.0);
+  TEST_CHECK_NEAR(test_double(s, "netstat.ip_reasm_fails_per_sec"), 0.0);
+  sysmon_snapshot_destroy(s);
+  test_module_destroy(&m);
+  test_fixture_destroy(&fx);
+}
+
+/* A kernel with one more Tcp column ahead of the selected ones changes the header length:
+ * the layout is resolved again instead of reading the neighbouring column. */
+static void test_header_change(void) {
+  test_fixture_t fx;
+  test_fixture_init(&fx);
+  write_snmp(&fx, 1000, 10, 7, 1, false);
+  write_netstat(&fx, 0, 0);
+
+  test_module_t m;
+  TEST_CHECK(test_module_create(&fx, sysmon_netstat_module(), "counters=tcp_out_segs,tcp_curr_estab",
+                                &m) == SYSMON_OK);
+  sysmon_snapshot_destroy(test_module_poll(&m, SYSMON_NS_PER_SEC));
+  write_snmp(&fx, 1100, 10, 8, 1, true);
+  sysmon_snapshot_t *s = test_module_poll(&m, 2 * SYSMON_NS_PER_SEC);
+  TEST_CHECK(test_u64(s, "netstat.tcp_curr_estab") == 8);
+  TEST_CHECK_NEAR(test_double(s, "netstat.tcp_out_segs_per_sec"), 100.0);
+  TEST_CHECK(!test_has(s, "netstat.tcp_retrans_percent"));
+  sysmon_snapshot_destroy(s);
+  test_module_destroy(&m);
+  test_fixture_destroy(&fx);
+}
+
+/* /proc/net/netstat is optional: its counters stay at zero without it. */
+static void test_snmp_only(void) {
+  test_fixture_t fx;
+  test_fixture_init(&fx);
+  write_snmp(&fx, 1000, 10, 7, 1, false);
+
+  test_module_t m;
+  TEST_CHECK(test_module_create(&fx, sysmon_netstat_module(), NULL, &m) == SYSMON_OK);
+  sysmon_snapshot_t *s = test_module_poll(&m, SYSMON_NS_PER_SEC);
+  TEST_CHECK(test_u64(s, "netstat.tcp_curr_estab") == 7);
+  TEST_CHECK_NEAR(test_double(s, "netstat.tcp_listen_drops_per_sec"), 0.0);
+  sysmon_snapshot_destroy(s);
+  test_module_destroy(&m);
+  test_fixture_destroy(&fx);
+}
+
+static void test_unknown_counter(void) {
+  test_fixture_t fx;
+  test_fixture_init(&fx);
+  write_snmp(&fx, 1000, 10, 7, 1, false);
+
+  test_module_t m;
+  TEST_CHECK(test_module_create(&fx, sysmon_netstat_module(), "counters=tcp_out_segs,tcp_bogus",
+                                &m) == SYSMON_ERR_PARSE);
+  TEST_CHECK(m.error && strstr(m.error, "unknown netstat counter 'tcp_bogus'"));
+  test_module_destroy(&m);
+  test_fixture_destroy(&fx);
+}
+
+int main(void) {
+  test_header_value_pairs();
+  test_header_change();
+  test_snmp_only();
+  test_unknown_counter();
+  return test_finish();
+}
@@ -0,0 +1,119 @@
+#include "sysmon_test.h"
+
+const sysmon_module_vtable_t *sysmon_schedstat_module(void);
+
+typedef struct cpu_line {
+  int id;
+  uint64_t run_ns;
+  uint64_t wait_ns;
+  uint64_t slices;
+} cpu_line_t;
+
+/* Version 15 layout: "cpu<N>" followed by 6 legacy counters, then run/wait/timeslices, each
+ * cpu line followed by its sched domains. */
+static void write_schedstat(const test_fixture_t *fx, unsigned version, const cpu_line_t *cpus,
+                            size_t count) {
+  char text[4096];
+  size_t len = (size_t)snprintf(text, sizeof(text), "version %u\ntimestamp 4295123456\n", version);
+  for (size_t i = 0; i < count; i++) {
+    len += (size_t)snprintf(text + len, sizeof(text) - len,
+                            "cpu%d 0 0 11 12 13 14 %llu %llu %llu\n"
+                            "domain0 00000003 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19\n"
+                            "domain1 0000000f 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19\n",
+                            cpus[i].id, (unsigned long long)cpus[i].run_ns,
+                            (unsigned long long)cpus[i].wait_ns,
+                            (unsigned long long)cpus[i].slices);
+  }
+  test_fixture_write(fx, "proc/schedstat", text);
+}
+
+static void test_version_15(void) {
+  test_fixture_t fx;
+  test_fixture_init(&fx);
+  cpu_line_t cpus[4] = {{0, 100, 1000, 10}, {1, 100, 1000, 10}, {2, 100, 1000, 10},
+                        {3, 100, 1000, 10}};
+  write_schedstat(&fx, 15, cpus, 4);
+
+  test_module_t m;
+  TEST_CHECK(test_module_create(&fx, sysmon_schedstat_module(), "per_cpu=1", &m) == SYSMON_OK);
+  sysmon_snapshot_t *s = test_module_poll(&m, SYSMON_NS_PER_SEC);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.cpu_wait_max_us"), 0.0);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.cpu.3.timeslices_per_sec"), 0.0);
+  sysmon_snapshot_destroy(s);
+
+  /* Over 2 s: cpu0 waits 10 ms in 100 slices, cpu1 20 ms in 100, cpu2 nothing, cpu3 1 s in
+   * 1000 slices. */
+  cpus[0].wait_ns += 10000000, cpus[0].slices += 100;
+  cpus[1].wait_ns += 20000000, cpus[1].slices += 100;
+  cpus[3].wait_ns += 1000000000, cpus[3].slices += 1000;
+  write_schedstat(&fx, 15, cpus, 4);
+  s = test_module_poll(&m, 3 * SYSMON_NS_PER_SEC);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.cpu.0.wait_per_timeslice_us"), 100.0);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.cpu.0.wait_percent"), 0.5);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.cpu.0.timeslices_per_sec"), 50.0);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.cpu.1.wait_per_timeslice_us"), 200.0);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.cpu.2.wait_per_timeslice_us"), 0.0);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.cpu.3.wait_per_timeslice_us"), 1000.0);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.cpu.3.wait_percent"), 50.0);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.wait_per_timeslice_us"),
+                  (10e6 + 20e6 + 1e9) / 1000.0 / 1200.0);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.waiting_tasks_avg"), 0.005 + 0.01 + 0.5);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.cpu_wait_p50_us"), 100.0);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.cpu_wait_p99_us"), 1000.0);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.cpu_wait_max_us"), 1000.0);
+  sysmon_snapshot_destroy(s);
+
+  /* cpu1 goes offline: the remaining rows restart from a fresh baseline, none mismatched. */
+  cpus[1] = cpus[2];
+  cpus[2] = cpus[3];
+  cpus[0].wait_ns += 5000000, cpus[0].slices += 50;
+  write_schedstat(&fx, 15, cpus, 3);
+  s = test_module_poll(&m, 4 * SYSMON_NS_PER_SEC);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.cpu.0.wait_per_timeslice_us"), 100.0);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.cpu.2.wait_per_timeslice_us"), 0.0);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.cpu.3.wait_per_timeslice_us"), 0.0);
+  TEST_CHECK(!test_has(s, "schedstat.cpu.1.wait_percent"));
+  sysmon_snapshot_destroy(s);
+  test_module_destroy(&m);
+  test_fixture_destroy(&fx);
+}
+
+static void test_old_version_rejected(void) {
+  test_fixture_t fx;
+  test_fixture_init(&fx);
+  const cpu_line_t cpu = {0, 1, 1, 1};
+  write_schedstat(&fx, 14, &cpu, 1);
+
+  test_module_t m;
+  TEST_CHECK(test_module_create(&fx, sysmon_schedstat_module(), NULL, &m) ==
+             SYSMON_ERR_NOT_SUPPORTED);
+  TEST_CHECK(m.error && strstr(m.error, "unsupported version"));
+  test_module_destroy(&m);
+  test_fixture_destroy(&fx);
+}
+
+/* Later versions only extend the domain lines; the cpu line keeps its v15 fields. */
+static void test_newer_version(void) {
+  test_fixture_t fx;
+  test_fixture_init(&fx);
+  cpu_line_t cpu = {0, 1, 1000, 1};
+  write_schedstat(&fx, 17, &cpu, 1);
+
+  test_module_t m;
+  TEST_CHECK(test_module_create(&fx, sysmon_schedstat_module(), NULL, &m) == SYSMON_OK);
+  sysmon_snapshot_destroy(test_module_poll(&m, SYSMON_NS_PER_SEC));
+  cpu.wait_ns += 3000, cpu.slices += 3;
+  write_schedstat(&fx, 17, &cpu, 1);
+  sysmon_snapshot_t *s = test_module_poll(&m, 2 * SYSMON_NS_PER_SEC);
+  TEST_CHECK_NEAR(test_double(s, "schedstat.wait_per_timeslice_us"), 1.0);
+  sysmon_snapshot_destroy(s);
+  test_module_destroy(&m);
+  test_fixture_destroy(&fx);
+}
+
+int main(void) {
+  test_version_15();
+  test_old_version_rejected();
+  test_newer_version();
+  return test_finish();
+}
@@ -0,0 +1,137 @@
+#include "sysmon_test.h"
+
+/* The port filter bytecode is module state, so the module is built into this test. */
+#include "modules/sockets.c"
+
+#include <arpa/inet.h>
+
+/* The kernel's inet_diag_bc_run for the port tests the module emits: each op jumps `yes` or
+ * `no` bytes ahead, and the socket is accepted only if the program ends exactly at its
+ * length. */
+static bool bytecode_accepts(const unsigned char *bc, size_t len, uint16_t sport, uint16_t dport) {
+  long rem = (long)len;
+  const unsigned char *p = bc;
+  while (rem > 0) {
+    const struct inet_diag_bc_op *op = (const struct inet_diag_bc_op *)p;
+    bool yes = true;
+    switch (op->code) {
+      case INET_DIAG_BC_S_GE: yes = sport >= op[1].no; break;
+      case INET_DIAG_BC_S_LE: yes = sport <= op[1].no; break;
+      case INET_DIAG_BC_D_GE: yes = dport >= op[1].no; break;
+      case INET_DIAG_BC_D_LE: yes = dport <= op[1].no; break;
+      default: return false;
+    }
+    const unsigned step = yes ? op->yes : op->no;
+    if (step == 0) return false;
+    rem -= (long)step;
+    p += step;
+  }
+  return rem == 0;
+}
+
+static sockets_state_t *create(test_fixture_t *fx, const char *options, test_module_t *m) {
+  const sysmon_result_t rc = test_module_create(fx, sysmon_sockets_module(), options, m);
+  if (rc == SYSMON_ERR_NOT_SUPPORTED) {
+    fprintf(stderr, "skipped: %s\n", m->error ? m->error : "sock_diag unavailable");
+    test_module_destroy(m);
+    test_fixture_destroy(fx);
+    exit(TEST_SKIP);
+  }
+  TEST_CHECK(rc == SYSMON_OK);
+  return (sockets_state_t *)m->state;
+}
+
+static void test_bytecode(void) {
+  test_fixture_t fx;
+  test_fixture_init(&fx);
+  test_module_t m;
+
+  sockets_state_t *st = create(&fx, NULL, &m);
+  TEST_CHECK(st && st->bytecode_len == 0);
+  test_module_destroy(&m);
+
+  st = create(&fx, "sport=8000-8080", &m);
+  TEST_CHECK(st && st->bytecode_len == 16);
+  if (st) {
+    TEST_CHECK(bytecode_accepts(st->bytecode, st->bytecode_len, 8000, 1));
+    TEST_CHECK(bytecode_accepts(st->bytecode, st->bytecode_len, 8080, 65535));
+    TEST_CHECK(!bytecode_accepts(st->bytecode, st->bytecode_len, 7999, 8000));
+    TEST_CHECK(!bytecode_accepts(st->bytecode, st->bytecode_len, 8081, 8000));
+  }
+  test_module_destroy(&m);
+
+  st = create(&fx, "dport=443", &m);
+  TEST_CHECK(st && st->bytecode_len == 16);
+  if (st) {
+    TEST_CHECK(bytecode_accepts(st->bytecode, st->bytecode_len, 50000, 443));
+    TEST_CHECK(!bytecode_accepts(st->bytecode, st->bytecode_len, 443, 442));
+    TEST_CHECK(!bytecode_accepts(st->bytecode, st->bytecode_len, 443, 444));
+  }
+  test_module_destroy(&m);
+
+  st = create(&fx, "sport=1024-2048\ndport=22", &m);
+  TEST_CHECK(st && st->bytecode_len == 32);
+  if (st) {
+    TEST_CHECK(bytecode_accepts(st->bytecode, st->bytecode_len, 1500, 22));
+    TEST_CHECK(bytecode_accepts(st->bytecode, st->bytecode_len, 1024, 22));
+    TEST_CHECK(!bytecode_accepts(st->bytecode, st->bytecode_len, 1023, 22));
+    TEST_CHECK(!bytecode_accepts(st->bytecode, st->bytecode_len, 2049, 22));
+    TEST_CHECK(!bytecode_accepts(st->bytecode, st->bytecode_len, 1500, 23));
+    TEST_CHECK(!bytecode_accepts(st->bytecode, st->bytecode_len, 1500, 21));
+  }
+  test_module_destroy(&m);
+
+  TEST_CHECK(test_module_create(&fx, sysmon_sockets_module(), "sport=90-80", &m) ==
+             SYSMON_ERR_PARSE);
+  test_module_destroy(&m);
+  TEST_CHECK(test_module_create(&fx, sysmon_sockets_module(), "dport=70000", &m) ==
+             SYSMON_ERR_PARSE);
+  test_module_destroy(&m);
+  test_fixture_destroy(&fx);
+}
+
+/* The kernel verifies the bytecode (inet_diag_bc_audit) and rejects the dump otherwise; a
+ * loopback listener and connection check that it filters as intended. */
+static void test_kernel_filter(void) {
+  const int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  struct sockaddr_in addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+  socklen_t addr_len = sizeof(addr);
+  if (listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(listener, 4) != 0 || getsockname(listener, (struct sockaddr *)&addr, &addr_len) != 0) {
+    fprintf(stderr, "no loopback TCP, kernel filter not checked\n");
+    if (listener >= 0) close(listener);
+    return;
+  }
+  const int client = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  TEST_CHECK(client >= 0 && connect(client, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+  const unsigned port = ntohs(addr.sin_port);
+
+  test_fixture_t fx;
+  test_fixture_init(&fx);
+  test_module_t m;
+  char options[128];
+  snprintf(options, sizeof(options), "families=inet4\nstates=listen\nsport=%u", port);
+  create(&fx, options, &m);
+  sysmon_snapshot_t *s = test_module_poll(&m, SYSMON_NS_PER_SEC);
+  TEST_CHECK(test_u64(s, "sockets.tcp.listen") == 1);
+  sysmon_snapshot_destroy(s);
+  test_module_destroy(&m);
+
+  snprintf(options, sizeof(options), "families=inet4\nstates=established\ndport=%u-%u", port,
+           port);
+  create(&fx, options, &m);
+  s = test_module_poll(&m, SYSMON_NS_PER_SEC);
+  TEST_CHECK(test_u64(s, "sockets.tcp.established") == 1);
+  sysmon_snapshot_destroy(s);
+  test_module_destroy(&m);
+
+  test_fixture_destroy(&fx);
+  close(client);
+  close(listener);
+}
+
+int main(void) {
+  test_bytecode();
+  test_kernel_filter();
+  return test_finish();
+}
@@ -0,0 +1,203 @@
+#include "sysmon_test.h"
+
+const sysmon_module_vtable_t *sysmon_vmstat_module(void);
+
+/* Every key of a 6.x /proc/vmstat, in kernel order: the perfect hash must pick out the
+ * selected ones and ignore the ~170 others, including those longer than 24 characters. */
+static const char *const kernel_keys[] = {
+    "nr_free_pages", "nr_free_pages_blocks", "nr_zone_inactive_anon", "nr_zone_active_anon",
+    "nr_zone_inactive_file", "nr_zone_active_file", "nr_zone_unevictable",
+    "nr_zone_write_pending", "nr_mlock", "nr_zspages", "nr_free_cma", "numa_hit", "numa_miss",
+    "numa_foreign", "numa_interleave", "numa_local", "numa_other", "nr_inactive_anon",
+    "nr_active_anon", "nr_inactive_file", "nr_active_file", "nr_unevictable",
+    "nr_slab_reclaimable", "nr_slab_unreclaimable", "nr_isolated_anon", "nr_isolated_file",
+    "workingset_nodes", "workingset_refault_anon", "workingset_refault_file",
+    "workingset_activate_anon", "workingset_activate_file", "workingset_restore_anon",
+    "workingset_restore_file", "workingset_nodereclaim", "nr_anon_pages", "nr_mapped",
+    "nr_file_pages", "nr_dirty", "nr_writeback", "nr_shmem", "nr_shmem_hugepages",
+    "nr_shmem_pmdmapped", "nr_file_hugepages", "nr_file_pmdmapped",
+    "nr_anon_transparent_hugepages", "nr_vmscan_write", "nr_vmscan_immediate_reclaim",
+    "nr_dirtied", "nr_written", "nr_throttled_written", "nr_kernel_misc_reclaimable",
+    "nr_foll_pin_acquired", "nr_foll_pin_released", "nr_kernel_stack", "nr_page_table_pages",
+    "nr_sec_page_table_pages", "nr_iommu_pages", "nr_swapcached", "pgpromote_success",
+    "pgpromote_candidate", "pgpromote_candidate_nrl", "pgdemote_kswapd", "pgdemote_direct",
+    "pgdemote_khugepaged", "pgdemote_proactive", "nr_hugetlb", "nr_balloon_pages",
+    "nr_kernel_file_pages", "nr_dirty_threshold", "nr_dirty_background_threshold",
+    "nr_memmap_pages", "nr_memmap_boot_pages", "pgpgin", "pgpgout", "pswpin", "pswpout",
+    "pgalloc_dma", "pgalloc_dma32", "pgalloc_normal", "pgalloc_movable", "pgalloc_device",
+    "allocstall_dma", "allocstall_dma32", "allocstall_normal", "allocstall_movable",
+    "allocstall_device", "pgskip_dma", "pgskip_dma32", "pgskip_normal", "pgskip_movable",
+    "pgskip_device", "pgfree", "pgactivate", "pgdeactivate", "pglazyfree", "pgfault",
+    "pgmajfault", "pglazyfreed", "pgrefill", "pgreuse", "pgsteal_kswapd", "pgsteal_direct",
+    "pgsteal_khugepaged", "pgsteal_proactive", "pgscan_kswapd", "pgscan_direct",
+    "pgscan_khugepaged", "pgscan_proactive", "pgscan_direct_throttle", "pgscan_anon",
+    "pgscan_file", "pgsteal_anon", "pgsteal_file", "zone_reclaim_success",
+    "zone_reclaim_failed", "pginodesteal", "slabs_scanned", "kswapd_inodesteal",
+    "kswapd_low_wmark_hit_quickly", "kswapd_high_wmark_hit_quickly", "pageoutrun", "pgrotated",
+    "drop_pagecache", "drop_slab", "oom_kill", "numa_pte_updates", "numa_huge_pte_updates",
+    "numa_hint_faults", "numa_hint_faults_local", "numa_pages_migrated", "pgmigrate_success",
+    "pgmigrate_fail", "thp_migration_success", "thp_migration_fail", "thp_migration_split",
+    "compact_migrate_scanned", "compact_free_scanned", "compact_isolated", "compact_stall",
+    "compact_fail", "compact_success", "compact_daemon_wake", "compact_daemon_migrate_scanned",
+    "compact_daemon_free_scanned", "htlb_buddy_alloc_success", "htlb_buddy_alloc_fail",
+    "unevictable_pgs_culled", "unevictable_pgs_scanned", "unevictable_pgs_rescued",
+    "unevictable_pgs_mlocked", "unevictable_pgs_munlocked", "unevictable_pgs_cleared",
+    "unevictable_pgs_stranded", "thp_fault_alloc", "thp_fault_fallback",
+    "thp_fault_fallback_charge", "thp_collapse_alloc", "thp_collapse_alloc_failed",
+    "thp_file_alloc", "thp_file_fallback", "thp_file_fallback_charge", "thp_file_mapped",
+    "thp_split_page", "thp_split_page_failed", "thp_deferred_split_page",
+    "thp_underused_split_page", "thp_split_pmd", "thp_scan_exceed_none_pte",
+    "thp_scan_exceed_swap_pte", "thp_scan_exceed_share_pte", "thp_split_pud",
+    "thp_zero_page_alloc", "thp_zero_page_alloc_failed", "thp_swpout", "thp_swpout_fallback",
+    "balloon_inflate", "balloon_deflate", "balloon_migrate", "swap_ra", "swap_ra_hit",
+    "swpin_zero", "swpout_zero", "ksm_swpin_copy", "cow_ksm", "zswpin", "zswpout", "zswpwb",
+    "direct_map_level2_splits", "direct_map_level3_splits", "direct_map_level2_collapses",
+    "direct_map_level3_collapses", "nr_unstable",
+    /* near misses of selected keys */
+    "pgfaults", "pgfaul", "pgscan", "pgsteal", "oom_kill_", "nr_dirty_", "pswpin_x",
+};
+
+#define KEY_COUNT (sizeof(kernel_keys) / sizeof(kernel_keys[0]))
+
+/* Per-key increments between the two polls; each selected key gets its own bit and every
+ * other key a large odd step, so a key routed to the wrong counter shows in the rates. */
+typedef struct key_delta {
+  const char *key;
+  uint64_t delta;
+} key_delta_t;
+
+static const key_delta_t deltas[] = {
+    {"pgfault", 1u << 0},           {"pgmajfault", 1u << 1},
+    {"pswpin", 1u << 2},            {"pswpout", 1u << 3},
+    {"allocstall_dma", 1u << 4},    {"allocstall_dma32", 1u << 5},
+    {"allocstall_normal", 1u << 6}, {"allocstall_movable", 1u << 7},
+    {"allocstall_device", 1u << 8}, {"pgscan_kswapd", 1u << 9},
+    {"pgscan_direct", 1u << 10},    {"pgscan_khugepaged", 1u << 11},
+    {"pgscan_proactive", 1u << 12}, {"pgsteal_kswapd", 1u << 13},
+    {"pgsteal_direct", 1u << 14},   {"pgsteal_khugepaged", 1u << 15},
+    {"pgsteal_proactive", 1u << 16}, {"oom_kill", 1u << 17},
+    {"workingset_refault_anon", 1u << 18}, {"workingset_refault_file", 1u << 19},
+    {"thp_fault_alloc", 1u << 20},  {"compact_stall", 1u << 21},
+    {"pgrefill", 1u << 22},         {"nr_dirty", 1u << 23},
+};
+
+static uint64_t delta_of(const char *key, size_t index) {
+  for (size_t i = 0; i < sizeof(deltas) / sizeof(deltas[0]); i++) {
+    if (strcmp(deltas[i].key, key) == 0) return deltas[i].delta;
+  }
+  return (1ull << 32) + 2 * index + 1;
+}
+
+static void write_vmstat(const test_fixture_t *fx, const char *const *keys, size_t count,
+                         bool advanced) {
+  static char text[16384];
+  size_t len = 0;
+  for (size_t i = 0; i < count; i++) {
+    const uint64_t v = 1000000 + i * 1000 + (advanced ? delta_of(keys[i], i) : 0);
+    len += (size_t)snprintf(text + len, sizeof(text) - len, "%s %llu\n", keys[i],
+                            (unsigned long long)v);
+  }
+  test_fixture_write(fx, "proc/vmstat", text);
+}
+
+static size_t index_of(const char *key) {
+  for (size_t i = 0; i < KEY_COUNT; i++) {
+    if (strcmp(kernel_keys[i], key) == 0) return i;
+  }
+  return SIZE_MAX;
+}
+
+static void test_all_counters(void) {
+  test_fixture_t fx;
+  test_fixture_init(&fx);
+  write_vmstat(&fx, kernel_keys, KEY_COUNT, false);
+
+  test_module_t m;
+  TEST_CHECK(test_module_create(&fx, sysmon_vmstat_module(),
+                                "counters=pgfault,pgmajfault,pgpgin,pgpgout,pswpin,pswpout,"
+                                "allocstall,pgscan,pgscan_kswapd,pgscan_direct,pgsteal,"
+                                "pgsteal_kswapd,pgsteal_direct,pgrefill,oom_kill,compact_stall,"
+                                "thp_fault_alloc,thp_fault_fallback,workingset_refault,nr_dirty,"
+                                "nr_writeback",
+                                &m) == SYSMON_OK);
+  sysmon_snapshot_destroy(test_module_poll(&m, SYSMON_NS_PER_SEC));
+  write_vmstat(&fx, kernel_keys, KEY_COUNT, true);
+  sysmon_snapshot_t *s = test_module_poll(&m, 2 * SYSMON_NS_PER_SEC);
+
+  TEST_CHECK_NEAR(test_double(s, "vmstat.pgfault_per_sec"), 1u << 0);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.pgmajfault_per_sec"), 1u << 1);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.pswpin_per_sec"), 1u << 2);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.pswpout_per_sec"), 1u << 3);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.allocstall_per_sec"), 0x1f0);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.pgscan_kswapd_per_sec"), 1u << 9);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.pgscan_direct_per_sec"), 1u << 10);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.pgscan_per_sec"), 0x1e00);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.pgsteal_kswapd_per_sec"), 1u << 13);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.pgsteal_direct_per_sec"), 1u << 14);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.pgsteal_per_sec"), 0x1e000);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.oom_kill_per_sec"), 1u << 17);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.workingset_refault_per_sec"), 0xc0000);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.thp_fault_alloc_per_sec"), 1u << 20);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.compact_stall_per_sec"), 1u << 21);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.pgrefill_per_sec"), 1u << 22);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.pgpgin_per_sec"), delta_of("pgpgin", index_of("pgpgin")));
+  TEST_CHECK_NEAR(test_double(s, "vmstat.thp_fault_fallback_per_sec"),
+                  delta_of("thp_fault_fallback", index_of("thp_fault_fallback")));
+  TEST_CHECK(test_u64(s, "vmstat.nr_dirty") == 1000000 + index_of("nr_dirty") * 1000 + (1u << 23));
+  const size_t wb = index_of("nr_writeback");
+  TEST_CHECK(test_u64(s, "vmstat.nr_writeback") == 1000000 + wb * 1000 + delta_of("nr_writeback", wb));
+  TEST_CHECK_NEAR(test_double(s, "vmstat.reclaim_efficiency_percent"),
+                  (double)0x1e000 * 100.0 / (double)0x1e00);
+  sysmon_snapshot_destroy(s);
+  test_module_destroy(&m);
+  test_fixture_destroy(&fx);
+}
+
+/* The default selection builds a different table; kernels before 4.8 / 5.9 report a single
+ * allocstall / workingset_refault key. */
+static void test_default_selection_old_kernel(void) {
+  static const char *const old_keys[] = {"nr_dirty", "pgpgin", "pgfault", "pgmajfault",
+                                         "allocstall", "pgscan_kswapd_normal", "pgscan_kswapd",
+                                         "pgscan_direct", "pgsteal_kswapd", "pgsteal_direct",
+                                         "workingset_refault", "oom_kill"};
+  const size_t count = sizeof(old_keys) / sizeof(old_keys[0]);
+  test_fixture_t fx;
+  test_fixture_init(&fx);
+  write_vmstat(&fx, old_keys, count, false);
+
+  test_module_t m;
+  TEST_CHECK(test_module_create(&fx, sysmon_vmstat_module(), NULL, &m) == SYSMON_OK);
+  sysmon_snapshot_destroy(test_module_poll(&m, SYSMON_NS_PER_SEC));
+  write_vmstat(&fx, old_keys, count, true);
+  sysmon_snapshot_t *s = test_module_poll(&m, 3 * SYSMON_NS_PER_SEC);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.pgfault_per_sec"), 0.5);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.allocstall_per_sec"), (double)delta_of("allocstall", 4) / 2);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.pgscan_per_sec"), (double)((1u << 9) + (1u << 10)) / 2);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.pgsteal_per_sec"), (double)((1u << 13) + (1u << 14)) / 2);
+  TEST_CHECK_NEAR(test_double(s, "vmstat.oom_kill_per_sec"), (double)(1u << 17) / 2);
+  TEST_CHECK(!test_has(s, "vmstat.pgpgin_per_sec"));
+  TEST_CHECK(!test_has(s, "vmstat.workingset_refault_per_sec"));
+  sysmon_snapshot_destroy(s);
+  test_module_destroy(&m);
+  test_fixture_destroy(&fx);
+}
+
+static void test_unknown_counter(void) {
+  test_fixture_t fx;
+  test_fixture_init(&fx);
+  write_vmstat(&fx, kernel_keys, KEY_COUNT, false);
+
+  test_module_t m;
+  TEST_CHECK(test_module_create(&fx, sysmon_vmstat_module(), "counters=pgfault,pgfaults", &m) ==
+             SYSMON_ERR_PARSE);
+  TEST_CHECK(m.error && strstr(m.error, "unknown vmstat counter 'pgfaults'"));
+  test_module_destroy(&m);
+  test_fixture_destroy(&fx);
+}
+
+int main(void) {
+  test_all_counters();
+  test_default_selection_old_kernel();
+  test_unknown_counter();
+  return test_finish();
+}
@@ -0,0 +1,46 @@
+#!/bin/sh
+# Capture the procfs/sysfs files read by sysmon into a fixture tree usable with
+# `sysmon-cli --proc-root <dir>/proc --sys-root <dir>/sys`.
+set -eu
+
+if [ $# -ne 1 ]; then
+  echo "Usage: $0 <output-dir>" >&2
+  exit 2
+fi
+
+out="$1"
+mkdir -p "$out/proc/net" "$out/proc/self" "$out/sys/class/power_supply"
+
+cp /proc/stat "$out/proc/stat"
+cp /proc/meminfo "$out/proc/meminfo"
+cp /proc/net/dev "$out/proc/net/dev"
+cp /proc/self/mountinfo "$out/proc/self/mountinfo"
+cp /proc/diskstats "$out/proc/diskstats"
+
+for dev in /sys/class/block/*; do
+  [ -e "$dev/partition" ] || continue
+  name=$(basename "$dev")
+  mkdir -p "$out/sys/class/block/$name"
+  cat "$dev/partition" > "$out/sys/class/block/$name/partition"
+done
+
+if [ -r /sys/devices/system/node/online ]; then
+  mkdir -p "$out/sys/devices/system/node"
+  cat /sys/devices/system/node/online > "$out/sys/devices/system/node/online"
+  for node in /sys/devices/system/node/node[0-9]*; do
+    name=$(basename "$node")
+    mkdir -p "$out/sys/devices/system/node/$name"
+    for f in meminfo numastat; do
+      [ -r "$node/$f" ] && cat "$node/$f" > "$out/sys/devices/system/node/$name/$f" || true
+    done
+  done
+fi
+
+for supply in /sys/class/power_supply/*; do
+  [ -e "$supply" ] || continue
+  name=$(basename "$supply")
+  mkdir -p "$out/sys/class/power_supply/$name"
+  for f in type capacity status; do
+    [ -r "$supply/$f" ] && cat "$supply/$f" > "$out/sys/class/power_supply/$name/$f" || true
+  done
+done
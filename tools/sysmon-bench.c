@@ -0,0 +1,582 @@
+#include <sysmon/sysmon.h>
+
+#include "sysmon_internal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* A synthetic host written in the kernel's formats. Counter files are rewritten in place
+ * (same inode, so modules holding them open see the new text) with every counter advanced
+ * between two polls; only sysmon_poll itself is timed. */
+typedef struct fixture {
+  char root[PATH_MAX];
+  unsigned cpus;
+  unsigned interfaces;
+  unsigned mounts;
+  char *buf;
+  size_t len;
+  size_t cap;
+} fixture_t;
+
+typedef bool (*fixture_writer_t)(fixture_t *fx, uint64_t tick);
+
+static void fx_printf(fixture_t *fx, const char *fmt, ...) {
+  va_list ap;
+  for (;;) {
+    va_start(ap, fmt);
+    const int n = vsnprintf(fx->buf + fx->len, fx->cap - fx->len, fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if ((size_t)n < fx->cap - fx->len) {
+      fx->len += (size_t)n;
+      return;
+    }
+    const size_t cap = (fx->cap + (size_t)n + 1) * 2;
+    char *p = (char *)realloc(fx->buf, cap);
+    if (!p) {
+      fprintf(stderr, "out of memory generating fixture\n");
+      exit(1);
+    }
+    fx->buf = p;
+    fx->cap = cap;
+  }
+}
+
+/* Truncates and rewrites rel under the fixture root with the text accumulated in fx. */
+static bool fx_flush(fixture_t *fx, const char *rel) {
+  char path[PATH_MAX];
+  if (snprintf(path, sizeof(path), "%s/%s", fx->root, rel) >= (int)sizeof(path)) return false;
+  const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    fprintf(stderr, "cannot write %s: %s\n", path, strerror(errno));
+    return false;
+  }
+  size_t off = 0;
+  while (off < fx->len) {
+    const ssize_t n = write(fd, fx->buf + off, fx->len - off);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    off += (size_t)n;
+  }
+  close(fd);
+  const bool ok = off == fx->len;
+  fx->len = 0;
+  return ok;
+}
+
+static bool fx_mkdir(const fixture_t *fx, const char *rel) {
+  char path[PATH_MAX];
+  if (snprintf(path, sizeof(path), "%s/%s", fx->root, rel) >= (int)sizeof(path)) return false;
+  return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+static bool write_stat(fixture_t *fx, uint64_t tick) {
+  uint64_t sum[7] = {0};
+  for (unsigned c = 0; c < fx->cpus; c++) {
+    const uint64_t busy = 3 + c % 5;
+    sum[0] += 91234 + c + tick * busy;
+    sum[1] += 12 + tick / 4;
+    sum[2] += 45678 + c * 3 + tick * 2;
+    sum[3] += 987654 - c + tick * (95 - busy);
+    sum[4] += 321 + c % 17 + tick % 3;
+    sum[5] += 456 + tick / 2;
+    sum[6] += 7 + tick / 8;
+  }
+  fx_printf(fx, "cpu  %llu %llu %llu %llu %llu 0 %llu %llu 0 0\n", (unsigned long long)sum[0],
+            (unsigned long long)sum[1], (unsigned long long)sum[2], (unsigned long long)sum[3],
+            (unsigned long long)sum[4], (unsigned long long)sum[5], (unsigned long long)sum[6]);
+  for (unsigned c = 0; c < fx->cpus; c++) {
+    const uint64_t busy = 3 + c % 5;
+    fx_printf(fx, "cpu%u %llu %llu %llu %llu %llu 0 %llu %llu 0 0\n", c,
+              (unsigned long long)(91234 + c + tick * busy), (unsigned long long)(12 + tick / 4),
+              (unsigned long long)(45678 + c * 3 + tick * 2),
+              (unsigned long long)(987654 - c + tick * (95 - busy)),
+              (unsigned long long)(321 + c % 17 + tick % 3), (unsigned long long)(456 + tick / 2),
+              (unsigned long long)(7 + tick / 8));
+  }
+  fx_printf(fx, "intr %llu", (unsigned long long)(123456789 + tick * 5000));
+  for (unsigned i = 0; i < 64; i++) fx_printf(fx, " %llu", (unsigned long long)(i * 31 + tick * i));
+  fx_printf(fx,
+            "\nctxt %llu\nbtime 1700000000\nprocesses %llu\nprocs_running 3\nprocs_blocked 0\n"
+            "softirq %llu 1 2 3 4 5 6 7 8 9 10\n",
+            (unsigned long long)(987654321 + tick * 40000), (unsigned long long)(123456 + tick * 3),
+            (unsigned long long)(55555 + tick * 900));
+  return fx_flush(fx, "proc/stat");
+}
+
+static bool write_meminfo(fixture_t *fx, uint64_t tick) {
+  const unsigned long long total = (unsigned long long)fx->cpus * 4 * 1024 * 1024;
+  const unsigned long long free_kb = total / 4 - tick % 4096;
+  fx_printf(fx, "MemTotal:       %llu kB\nMemFree:        %llu kB\nMemAvailable:   %llu kB\n",
+            total, free_kb, total / 2);
+  fx_printf(fx, "Buffers:        %llu kB\nCached:         %llu kB\nSwapCached:            0 kB\n",
+            total / 64, total / 8);
+  fx_printf(fx, "Active:         %llu kB\nInactive:       %llu kB\n", total / 4, total / 8);
+  fx_printf(fx,
+            "SwapTotal:             0 kB\nSwapFree:              0 kB\nShmem:          %llu kB\n",
+            total / 128);
+  fx_printf(fx, "Slab:           %llu kB\nSReclaimable:   %llu kB\nSUnreclaim:     %llu kB\n",
+            total / 50, total / 100, total / 100);
+  fx_printf(fx,
+            "AnonHugePages:  %llu kB\nShmemHugePages:        0 kB\nFileHugePages:         0 kB\n",
+            total / 32);
+  fx_printf(fx, "HugePages_Total:       0\nHugePages_Free:        0\nHugepagesize:       2048 kB\n");
+  return fx_flush(fx, "proc/meminfo");
+}
+
+/* lo first, then eth<i>, with some bond/vlan names mixed in to vary name lengths. */
+static bool write_net_dev(fixture_t *fx, uint64_t tick) {
+  fx_printf(fx,
+            "Inter-|   Receive                                                |  Transmit\n"
+            " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets "
+            "errs drop fifo colls carrier compressed\n");
+  fx_printf(fx, "%6s: %llu %llu 0 0 0 0 0 0 %llu %llu 0 0 0 0 0 0\n", "lo",
+            (unsigned long long)(123456 + tick * 800), (unsigned long long)(1234 + tick * 8),
+            (unsigned long long)(123456 + tick * 800), (unsigned long long)(1234 + tick * 8));
+  for (unsigned i = 0; i < fx->interfaces; i++) {
+    char name[32];
+    if (i % 10 == 9)
+      snprintf(name, sizeof(name), "bond%u.%u", i / 100, i % 100);
+    else
+      snprintf(name, sizeof(name), "eth%u", i);
+    const uint64_t rx = (uint64_t)i * 1048576 + 4096 + tick * (i % 97 + 1) * 1500;
+    const uint64_t tx = (uint64_t)i * 524288 + 2048 + tick * (i % 89 + 1) * 1200;
+    fx_printf(fx, "%6s: %llu %llu %u %u 0 0 0 %u %llu %llu %u %u 0 0 0 0\n", name,
+              (unsigned long long)rx, (unsigned long long)(rx / 1400), i % 3, i % 5, i % 7,
+              (unsigned long long)tx, (unsigned long long)(tx / 1100), i % 2, i % 4);
+  }
+  return fx_flush(fx, "proc/net/dev");
+}
+
+static bool write_diskstats(fixture_t *fx, uint64_t tick) {
+  for (unsigned d = 0; d < fx->cpus / 8 + 1; d++) {
+    const unsigned long long t = tick;
+    fx_printf(fx, "%4u %7u nvme%un1 %llu 3 %llu %llu %llu 9 %llu %llu 0 %llu %llu 0 0 0 0 0 0\n",
+              259u, d * 4, d, d * 1000ull + 17 + t * 40, d * 80000ull + 13 + t * 320,
+              512ull + d + t * 20, d * 2000ull + 5 + t * 60, d * 160000ull + 7 + t * 480,
+              1024ull + d + t * 30, d * 3ull + 1 + t * 9, 4096ull + d + t * 50);
+    fx_printf(fx, "%4u %7u nvme%un1p1 %llu 0 %llu %llu %llu 0 %llu %llu 0 %llu %llu 0 0 0 0 0 0\n",
+              259u, d * 4 + 1, d, d * 10ull + 1 + t, d * 800ull + 8 + t * 8, 5ull + d + t,
+              d * 20ull + 1 + t * 2, d * 1600ull + 16 + t * 16, 10ull + d + t, d + 1ull + t,
+              40ull + d + t * 2);
+  }
+  return fx_flush(fx, "proc/diskstats");
+}
+
+/* Mount points are directories inside the fixture tree, so statvfs is really called once per
+ * mount without touching the host's own mounts. Each line gets its own device number. */
+static bool write_mountinfo(fixture_t *fx, uint64_t tick) {
+  static const char *const fstypes[] = {"xfs", "ext4", "nfs4", "btrfs"};
+  (void)tick;
+  for (unsigned i = 0; i < fx->mounts; i++) {
+    char rel[32], point[PATH_MAX * 4];
+    snprintf(rel, sizeof(rel), "mnt/%u", i);
+    if (!fx_mkdir(fx, rel)) return false;
+    /* mountinfo escapes blanks and backslashes as \ooo. */
+    size_t n = 0;
+    const char *full[] = {fx->root, "/", rel};
+    for (size_t k = 0; k < 3; k++) {
+      for (const char *p = full[k]; *p && n + 5 < sizeof(point); p++) {
+        if (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\\')
+          n += (size_t)snprintf(point + n, sizeof(point) - n, "\\%03o", (unsigned char)*p);
+        else
+          point[n++] = *p;
+      }
+    }
+    point[n] = '\0';
+    const char *fstype = fstypes[i % 4];
+    fx_printf(fx, "%u 1 %u:%u / %s rw,relatime shared:%u - %s /dev/fx%u rw\n", i + 10,
+              i % 4 == 2 ? 0u : 259u, i + 16, point, i + 10, fstype, i);
+  }
+  return fx_flush(fx, "proc/self/mountinfo");
+}
+
+static void write_cpu_header(fixture_t *fx) {
+  for (unsigned c = 0; c < fx->cpus; c++) {
+    char col[16];
+    snprintf(col, sizeof(col), "CPU%u", c);
+    fx_printf(fx, " %10s", col);
+  }
+  fx_printf(fx, "\n");
+}
+
+static bool write_interrupts(fixture_t *fx, uint64_t tick) {
+  fx_printf(fx, "%10s", "");
+  write_cpu_header(fx);
+  for (unsigned irq = 0; irq < 512; irq++) {
+    fx_printf(fx, "%4u:", irq);
+    for (unsigned c = 0; c < fx->cpus; c++)
+      fx_printf(fx, " %10llu",
+                (unsigned long long)((irq * 131 + c * 7) % 100000 + tick * ((irq + c) % 7)));
+    fx_printf(fx, "  PCI-MSIX-0000:%02x:00.0 %u-edge      mlx5_comp%u@pci:0000:%02x:00.0\n",
+              irq % 256, irq, irq, irq % 256);
+  }
+  static const char *const names[] = {"NMI", "LOC", "SPU", "PMI", "IWI", "RTR", "RES",
+                                      "CAL", "TLB", "TRM", "THR", "DFR", "MCE", "MCP"};
+  static const char *const descs[] = {
+      "Non-maskable interrupts",   "Local timer interrupts",   "Spurious interrupts",
+      "Performance monitoring interrupts", "IRQ work interrupts", "APIC ICR read retries",
+      "Rescheduling interrupts",   "Function call interrupts", "TLB shootdowns",
+      "Thermal event interrupts",  "Threshold APIC interrupts", "Deferred Error APIC interrupts",
+      "Machine check exceptions",  "Machine check polls"};
+  for (unsigned k = 0; k < sizeof(names) / sizeof(names[0]); k++) {
+    fx_printf(fx, "%s:", names[k]);
+    for (unsigned c = 0; c < fx->cpus; c++)
+      fx_printf(fx, " %10llu",
+                (unsigned long long)(((k + 1) * 977 + c * 13) % 1000000 + tick * (k == 1 ? 250 : k)));
+    fx_printf(fx, "   %s\n", descs[k]);
+  }
+  fx_printf(fx, "ERR:          0\nMIS:          0\n");
+  return fx_flush(fx, "proc/interrupts");
+}
+
+static bool write_softirqs(fixture_t *fx, uint64_t tick) {
+  static const char *const names[] = {"HI",       "TIMER", "NET_TX", "NET_RX",  "BLOCK",
+                                      "IRQ_POLL", "TASKLET", "SCHED", "HRTIMER", "RCU"};
+  fx_printf(fx, "%20s", "");
+  write_cpu_header(fx);
+  for (unsigned k = 0; k < sizeof(names) / sizeof(names[0]); k++) {
+    fx_printf(fx, "%12s:", names[k]);
+    for (unsigned c = 0; c < fx->cpus; c++)
+      fx_printf(fx, " %10llu",
+                (unsigned long long)(((k + 1) * 4099 + c * 17) % 10000000 + tick * (k + c % 3)));
+    fx_printf(fx, "\n");
+  }
+  return fx_flush(fx, "proc/softirqs");
+}
+
+static bool write_vmstat(fixture_t *fx, uint64_t tick) {
+  static const char *const keys[] = {
+      "nr_free_pages", "nr_zone_inactive_anon", "nr_zone_active_anon", "nr_zone_inactive_file",
+      "nr_zone_active_file", "nr_mlock", "nr_bounce", "nr_free_cma", "numa_hit", "numa_miss",
+      "numa_foreign", "numa_interleave", "numa_local", "numa_other", "nr_inactive_anon",
+      "nr_active_anon", "nr_inactive_file", "nr_active_file", "nr_unevictable",
+      "nr_slab_reclaimable", "nr_slab_unreclaimable", "nr_isolated_anon", "nr_isolated_file",
+      "nr_dirty", "nr_writeback", "pgpgin", "pgpgout", "pswpin", "pswpout", "pgalloc_dma",
+      "pgalloc_dma32", "pgalloc_normal", "pgalloc_movable", "allocstall_dma", "allocstall_dma32",
+      "allocstall_normal", "allocstall_movable", "pgfree", "pgactivate", "pgdeactivate",
+      "pglazyfree", "pgfault", "pgmajfault", "pglazyfreed", "pgrefill", "pgreuse",
+      "pgsteal_kswapd", "pgsteal_direct", "pgsteal_khugepaged", "pgscan_kswapd", "pgscan_direct",
+      "pgscan_khugepaged", "pgscan_direct_throttle", "pgscan_anon", "pgscan_file", "pgsteal_anon",
+      "pgsteal_file", "zone_reclaim_failed", "pginodesteal", "slabs_scanned", "kswapd_inodesteal",
+      "pageoutrun", "pgrotated", "drop_pagecache", "drop_slab", "oom_kill", "numa_pte_updates",
+      "numa_hint_faults", "pgmigrate_success", "pgmigrate_fail", "compact_stall", "compact_fail",
+      "compact_success", "htlb_buddy_alloc_success", "unevictable_pgs_culled", "thp_fault_alloc",
+      "thp_fault_fallback", "thp_collapse_alloc", "thp_split_page", "thp_zero_page_alloc",
+      "balloon_inflate", "swap_ra", "swap_ra_hit"};
+  for (unsigned k = 0; k < sizeof(keys) / sizeof(keys[0]); k++)
+    fx_printf(fx, "%s %llu\n", keys[k], (unsigned long long)((k + 1) * 104729 + tick * (k % 13)));
+  return fx_flush(fx, "proc/vmstat");
+}
+
+static bool write_schedstat(fixture_t *fx, uint64_t tick) {
+  fx_printf(fx, "version 15\ntimestamp %llu\n", (unsigned long long)(4295000000ull + tick * 250));
+  for (unsigned c = 0; c < fx->cpus; c++) {
+    fx_printf(fx, "cpu%u 0 0 0 0 0 0 %llu %llu %llu\n", c,
+              (unsigned long long)(1000000000ull + c * 1000 + tick * 9000000),
+              (unsigned long long)(50000000ull + c * 100 + tick * (c % 11) * 100000),
+              (unsigned long long)(100000ull + c + tick * (20 + c % 7)));
+    fx_printf(fx, "domain0 ff");
+    for (unsigned i = 0; i < 45; i++) fx_printf(fx, " 0");
+    fx_printf(fx, "\n");
+  }
+  return fx_flush(fx, "proc/schedstat");
+}
+
+static bool write_snmp(fixture_t *fx, uint64_t tick) {
+  const unsigned long long t = tick;
+  fx_printf(fx,
+            "Ip: Forwarding DefaultTTL InReceives InHdrErrors InAddrErrors ForwDatagrams "
+            "InUnknownProtos InDiscards InDelivers OutRequests OutDiscards OutNoRoutes ReasmTimeout "
+            "ReasmReqds ReasmOKs ReasmFails FragOKs FragFails FragCreates OutTransmits\n"
+            "Ip: 1 64 %llu 12 3 0 0 0 %llu %llu 6 0 0 40 20 %llu 0 %llu 0 %llu\n",
+            982374234ull + t * 9000, 982370000ull + t * 9000, 871234123ull + t * 8000, 3 + t / 50,
+            1 + t / 90, 871234123ull + t * 8000);
+  fx_printf(fx,
+            "Icmp: InMsgs InErrors InCsumErrors InDestUnreachs InTimeExcds InParmProbs "
+            "InSrcQuenchs InRedirects InEchos InEchoReps InTimestamps InTimestampReps InAddrMasks "
+            "InAddrMaskReps OutMsgs OutErrors OutRateLimitGlobal OutRateLimitHost OutDestUnreachs "
+            "OutTimeExcds OutParmProbs OutSrcQuenchs OutRedirects OutEchos OutEchoReps "
+            "OutTimestamps OutTimestampReps OutAddrMasks OutAddrMaskReps\n"
+            "Icmp: 15 0 0 15 0 0 0 0 0 0 0 0 0 0 12 0 0 0 12 0 0 0 0 0 0 0 0 0 0\n");
+  fx_printf(fx,
+            "Tcp: RtoAlgorithm RtoMin RtoMax MaxConn ActiveOpens PassiveOpens AttemptFails "
+            "EstabResets CurrEstab InSegs OutSegs RetransSegs InErrs OutRsts InCsumErrors\n"
+            "Tcp: 1 200 120000 -1 %llu %llu %llu %llu %llu %llu %llu %llu 12 %llu 0\n",
+            7300000ull + t * 30, 2200000ull + t * 20, 53000ull + t, 22000ull + t / 2,
+            41234ull + t % 100, 912837123ull + t * 7000, 901234567ull + t * 6500,
+            123456ull + t * 13, 61000ull + t * 3);
+  fx_printf(fx,
+            "Udp: InDatagrams NoPorts InErrors OutDatagrams RcvbufErrors SndbufErrors InCsumErrors "
+            "IgnoredMulti MemErrors\n"
+            "Udp: %llu 1234 %llu %llu %llu 0 0 0 0\n"
+            "UdpLite: InDatagrams NoPorts InErrors OutDatagrams RcvbufErrors SndbufErrors "
+            "InCsumErrors IgnoredMulti MemErrors\n"
+            "UdpLite: 0 0 0 0 0 0 0 0 0\n",
+            81234567ull + t * 500, 56 + t / 20, 80123456ull + t * 480, 50 + t / 40);
+  return fx_flush(fx, "proc/net/snmp");
+}
+
+static bool write_netstat(fixture_t *fx, uint64_t tick) {
+  static const char *const fields[] = {
+      "SyncookiesSent", "SyncookiesRecv", "SyncookiesFailed", "EmbryonicRsts", "PruneCalled",
+      "RcvPruned", "OfoPruned", "OutOfWindowIcmps", "LockDroppedIcmps", "ArpFilter", "TW",
+      "TWRecycled", "TWKilled", "PAWSActive", "PAWSEstab", "DelayedACKs", "DelayedACKLocked",
+      "DelayedACKLost", "ListenOverflows", "ListenDrops", "TCPHPHits", "TCPPureAcks", "TCPHPAcks",
+      "TCPRenoRecovery", "TCPSackRecovery", "TCPSACKReneging", "TCPTimeouts", "TCPLossProbes",
+      "TCPBacklogDrop", "TCPOFOQueue", "TCPOrigDataSent", "TCPDelivered"};
+  const unsigned n = sizeof(fields) / sizeof(fields[0]);
+  fx_printf(fx, "TcpExt:");
+  for (unsigned k = 0; k < n; k++) fx_printf(fx, " %s", fields[k]);
+  fx_printf(fx, "\nTcpExt:");
+  for (unsigned k = 0; k < n; k++)
+    fx_printf(fx, " %llu", (unsigned long long)((k + 1) * 7919 + tick * (k % 5)));
+  fx_printf(fx,
+            "\nIpExt: InNoRoutes InTruncatedPkts InMcastPkts OutMcastPkts InBcastPkts OutBcastPkts "
+            "InOctets OutOctets\n"
+            "IpExt: 0 0 1234 567 89 0 %llu %llu\n",
+            (unsigned long long)(912837123456ull + tick * 1500000),
+            (unsigned long long)(812345678901ull + tick * 1400000));
+  return fx_flush(fx, "proc/net/netstat");
+}
+
+/* Each module with the settings that make it parse everything its input holds, and the
+ * fixture files it reads (rewritten before every timed poll). */
+typedef struct bench_case {
+  const char *module;
+  const char *settings;
+  fixture_writer_t writers[3];
+} bench_case_t;
+
+static const bench_case_t default_cases[] = {
+    {"cpu", "per_core=1\n", {write_stat}},
+    {"ram", "", {write_meminfo}},
+    {"network", "interface=*\ninclude_loopback=1\n", {write_net_dev}},
+    {"storage", "mode=mounts\nfstypes=*\nexclude_fstypes=\n", {NULL}},
+    {"disk", "partitions=1\n", {write_diskstats}},
+    {"irq", "per_cpu=1\ntop_n=5\n", {write_interrupts, write_softirqs}},
+    {"vmstat", "", {write_vmstat}},
+    {"schedstat", "per_cpu=1\n", {write_schedstat}},
+    {"memdetail", "", {write_meminfo, write_vmstat}},
+    {"netstat", "", {write_snmp, write_netstat}},
+};
+
+#define CASE_COUNT (sizeof(default_cases) / sizeof(default_cases[0]))
+
+static void usage(const char *argv0) {
+  fprintf(stderr,
+          "Usage: %s [-n iterations] [-o dir] [--cpus n] [--interfaces n]"
+          " [--mounts n]"
+          " [module...]\n"
+          "  Writes a synthetic large-host procfs tree (default 256 CPUs, 2000 interfaces"
+          ",\n  500 mounts"
+          ") and times sysmon_poll for each module alone against it.\n"
+          "  -o <dir>   Keep the generated tree in <dir> instead of a temporary directory\n"
+          "  Modules: ",
+          argv0);
+  for (size_t i = 0; i < CASE_COUNT; i++)
+    fprintf(stderr, "%s%s", i ? " " : "", default_cases[i].module);
+  fprintf(stderr, "\n");
+}
+
+static uint64_t monotonic_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+  const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static bool write_fixture(fixture_t *fx) {
+  static const char *const dirs[] = {"proc", "proc/net", "proc/self", "sys"};
+  for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+    if (!fx_mkdir(fx, dirs[i])) {
+      fprintf(stderr, "cannot create %s/%s: %s\n", fx->root, dirs[i], strerror(errno));
+      return false;
+    }
+  }
+  if (!fx_mkdir(fx, "mnt") || !write_mountinfo(fx, 0)) return false;
+  for (size_t i = 0; i < CASE_COUNT; i++) {
+    for (size_t w = 0; w < 3 && default_cases[i].writers[w]; w++) {
+      if (!default_cases[i].writers[w](fx, 0)) return false;
+    }
+  }
+  return true;
+}
+
+static bool write_config(const char *path, const bench_case_t *c) {
+  FILE *f = fopen(path, "w");
+  if (!f) return false;
+  size_t count = 0;
+  const sysmon_module_vtable_t *modules = sysmon_builtin_modules(&count);
+  fprintf(f, "[sysmon]\ninterval_ms=1000\n\n");
+  for (size_t i = 0; i < count; i++) {
+    const bool on = strcmp(modules[i].name, c->module) == 0;
+    fprintf(f, "[module.%s]\nenabled=%d\nrefresh_ms=0\n%s\n", modules[i].name, on ? 1 : 0,
+            on ? c->settings : "");
+  }
+  return fclose(f) == 0;
+}
+
+static bool run_case(fixture_t *fx, const bench_case_t *c, const char *ini_path, long iterations,
+                     uint64_t *samples) {
+  if (!write_config(ini_path, c)) {
+    fprintf(stderr, "failed to write %s\n", ini_path);
+    return false;
+  }
+  char proc_root[PATH_MAX + 8], sys_root[PATH_MAX + 8];
+  snprintf(proc_root, sizeof(proc_root), "%s/proc", fx->root);
+  snprintf(sys_root, sizeof(sys_root), "%s/sys", fx->root);
+  sysmon_create_options_t options = {
+      .ini_path = ini_path, .proc_root = proc_root, .sys_root = sys_root};
+  sysmon_t *sysmon = NULL;
+  sysmon_result_t rc = sysmon_create(&options, &sysmon);
+  if (rc != SYSMON_OK) {
+    fprintf(stderr, "%-10s sysmon_create failed (%d)\n", c->module, (int)rc);
+    return false;
+  }
+
+  /* The first poll sizes buffers and tables and has no previous sample; only the steady-state
+   * polls after it, each on freshly advanced counters, are timed. */
+  size_t metrics = 0;
+  char error_name[64];
+  snprintf(error_name, sizeof(error_name), "module.%s.error", c->module);
+  for (long i = -1; i < iterations; i++) {
+    for (size_t w = 0; i >= 0 && w < 3 && c->writers[w]; w++) {
+      if (!c->writers[w](fx, (uint64_t)i + 1)) {
+        sysmon_destroy(sysmon);
+        return false;
+      }
+    }
+    sysmon_snapshot_t *snapshot = NULL;
+    const uint64_t t0 = monotonic_ns();
+    rc = sysmon_poll(sysmon, &snapshot);
+    const uint64_t t1 = monotonic_ns();
+    if (rc != SYSMON_OK) {
+      fprintf(stderr, "%-10s sysmon_poll failed (%d)\n", c->module, (int)rc);
+      sysmon_destroy(sysmon);
+      return false;
+    }
+    if (i >= 0) samples[i] = t1 - t0;
+    if (i + 1 == iterations) {
+      metrics = sysmon_snapshot_metric_count(snapshot);
+      const sysmon_metric_t *m = sysmon_snapshot_find(snapshot, error_name);
+      if (m && m->type == SYSMON_METRIC_STRING) fprintf(stderr, "%-10s %s\n", c->module, m->value.str);
+    }
+    sysmon_snapshot_destroy(snapshot);
+  }
+  sysmon_destroy(sysmon);
+
+  qsort(samples, (size_t)iterations, sizeof(*samples), cmp_u64);
+  uint64_t sum = 0;
+  for (long i = 0; i < iterations; i++) sum += samples[i];
+  printf("%-10s %8zu %12.1f %12.1f %12.1f %12.1f\n", c->module, metrics,
+         (double)samples[0] / 1000.0, (double)samples[iterations / 2] / 1000.0,
+         (double)samples[iterations * 99 / 100] / 1000.0, (double)sum / (double)iterations / 1000.0);
+  return true;
+}
+
+static int remove_entry(const char *path, const struct stat *sb, int flag, struct FTW *ftw) {
+  (void)sb;
+  (void)flag;
+  (void)ftw;
+  return remove(path);
+}
+
+static bool parse_count(const char *s, unsigned *out) {
+  char *end = NULL;
+  const unsigned long v = strtoul(s, &end, 10);
+  if (end == s || *end || v == 0 || v > 1000000) return false;
+  *out = (unsigned)v;
+  return true;
+}
+
+int main(int argc, char **argv) {
+  fixture_t fx = {.cpus = 256, .interfaces = 2000};
+  fx.mounts = 500;
+  const char *keep_dir = NULL;
+  long iterations = 200;
+  const char **selected = (const char **)calloc((size_t)argc, sizeof(*selected));
+  size_t selected_count = 0;
+  if (!selected) return 1;
+
+  bool ok = true;
+  for (int i = 1; i < argc && ok; i++) {
+    const bool has_value = i + 1 < argc;
+    if (strcmp(argv[i], "-n") == 0 && has_value) {
+      iterations = strtol(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "-o") == 0 && has_value) {
+      keep_dir = argv[++i];
+    } else if (strcmp(argv[i], "--cpus") == 0 && has_value) {
+      ok = parse_count(argv[++i], &fx.cpus);
+    } else if (strcmp(argv[i], "--interfaces") == 0 && has_value) {
+      ok = parse_count(argv[++i], &fx.interfaces);
+    } else if (strcmp(argv[i], "--mounts") == 0 && has_value) {
+      ok = parse_count(argv[++i], &fx.mounts);
+    } else if (argv[i][0] == '-') {
+      ok = false;
+    } else {
+      selected[selected_count++] = argv[i];
+    }
+  }
+  for (size_t s = 0; s < selected_count && ok; s++) {
+    bool known = false;
+    for (size_t i = 0; i < CASE_COUNT; i++) known |= strcmp(default_cases[i].module, selected[s]) == 0;
+    ok = known;
+  }
+  if (!ok || iterations <= 0) {
+    usage(argv[0]);
+    free(selected);
+    return 2;
+  }
+
+  if (keep_dir) {
+    if ((mkdir(keep_dir, 0755) != 0 && errno != EEXIST) || !realpath(keep_dir, fx.root)) {
+      fprintf(stderr, "cannot use %s: %s\n", keep_dir, strerror(errno));
+      free(selected);
+      return 1;
+    }
+  } else {
+    snprintf(fx.root, sizeof(fx.root), "%s", "/tmp/sysmon-bench-XXXXXX");
+    if (!mkdtemp(fx.root)) {
+      fprintf(stderr, "cannot create a temporary directory: %s\n", strerror(errno));
+      free(selected);
+      return 1;
+    }
+  }
+
+  char ini_path[PATH_MAX + 16];
+  snprintf(ini_path, sizeof(ini_path), "%s/bench.ini", fx.root);
+  uint64_t *samples = (uint64_t *)malloc((size_t)iterations * sizeof(*samples));
+  ok = samples && write_fixture(&fx);
+  if (ok) {
+    printf("%-10s %8s %12s %12s %12s %12s\n", "module", "metrics", "min_us", "p50_us", "p99_us",
+           "mean_us");
+    for (size_t i = 0; i < CASE_COUNT; i++) {
+      bool wanted = selected_count == 0;
+      for (size_t s = 0; s < selected_count; s++)
+        wanted |= strcmp(default_cases[i].module, selected[s]) == 0;
+      if (wanted) ok &= run_case(&fx, &default_cases[i], ini_path, iterations, samples);
+    }
+  }
+
+  unlink(ini_path);
+  if (!keep_dir) nftw(fx.root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+  free(fx.buf);
+  free(samples);
+  free(selected);
+  return ok ? 0 : 1;
+}
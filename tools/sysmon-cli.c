@@ -1,5 +1,7 @@
 #include <sysmon/sysmon.h>
 
+#include "sysmon-record.h"
+
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -12,18 +14,23 @@
 
 static void usage(const char *argv0) {
   fprintf(stderr,
-          "Usage: %s [-c config.ini] [-n iterations] [--json]\n"
-          "  -c <path>     Path to ini config (default: sysmon.ini)\n"
-          "  -n <count>    Number of iterations (default: infinite)\n"
-          "  --json        Print one JSON object per line\n",
+          "Usage: %s [-c config.ini] [-n iterations] [--json] [--proc-root dir] [--sys-root dir]\n"
+          "       [--record file | --replay file [--speed Nx|max] [--loop]]\n"
+          "  -c <path>           Path to ini config (default: sysmon.ini)\n"
+          "  -n <count>          Number of iterations (default: infinite)\n"
+          "  --json              Print one JSON object per line\n"
+          "  --proc-root <dir>   Read procfs files from <dir> (default: /proc)\n"
+          "  --sys-root <dir>    Read sysfs files from <dir> (default: /sys)\n"
+          "  --record <file>     Also append every snapshot to <file>\n"
+          "  --replay <file>     Print snapshots from <file> instead of polling\n"
+          "  --speed <Nx|max>    Replay speed factor (default: 1x, max = no sleeping)\n"
+          "  --loop              Restart the replay at end of file\n",
           argv0);
 }
 
-static void print_human(const sysmon_snapshot_t *snapshot) {
-  const size_t count = sysmon_snapshot_metric_count(snapshot);
+static void print_human(const sysmon_metric_t *metrics, size_t count) {
   for (size_t i = 0; i < count; i++) {
-    const sysmon_metric_t *m = sysmon_snapshot_metric_at(snapshot, i);
-    if (!m) continue;
+    const sysmon_metric_t *m = &metrics[i];
     printf("%s=", m->name ? m->name : "(null)");
     switch (m->type) {
       case SYSMON_METRIC_DOUBLE:
@@ -70,12 +77,11 @@ static void json_escape(const char *s) {
   }
 }
 
-static void print_json(const sysmon_snapshot_t *snapshot) {
-  const size_t count = sysmon_snapshot_metric_count(snapshot);
+static void print_json(const sysmon_metric_t *metrics, size_t count) {
   fputc('{', stdout);
   for (size_t i = 0; i < count; i++) {
-    const sysmon_metric_t *m = sysmon_snapshot_metric_at(snapshot, i);
-    if (!m || !m->name) continue;
+    const sysmon_metric_t *m = &metrics[i];
+    if (!m->name) continue;
     if (i != 0) fputc(',', stdout);
     fputc('"', stdout);
     json_escape(m->name);
@@ -101,19 +107,119 @@ static void print_json(const sysmon_snapshot_t *snapshot) {
   fputs("}\n", stdout);
 }
 
-static void sleep_ms(uint32_t ms) {
+static void print_metrics(const sysmon_metric_t *metrics, size_t count, bool json) {
+  if (json) {
+    print_json(metrics, count);
+  } else {
+    print_human(metrics, count);
+  }
+}
+
+static void sleep_ns(uint64_t ns) {
 #if defined(_WIN32)
-  Sleep(ms);
+  Sleep((DWORD)(ns / 1000000u));
 #else
   struct timespec ts;
-  ts.tv_sec = (time_t)(ms / 1000u);
-  ts.tv_nsec = (long)((ms % 1000u) * 1000000u);
+  ts.tv_sec = (time_t)(ns / 1000000000u);
+  ts.tv_nsec = (long)(ns % 1000000000u);
   nanosleep(&ts, NULL);
 #endif
 }
 
+static uint64_t monotonic_ns(void) {
+#if defined(_WIN32)
+  return (uint64_t)GetTickCount64() * 1000000u;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* Sleeps until the interval ends, or earlier when a module reports an event that changes
+ * its metrics; events a module ignores (other uevents, unrelated inotify) only resume the
+ * wait for the time left. */
+static void wait_interval(sysmon_t *sysmon, uint32_t interval_ms) {
+  const uint64_t deadline = monotonic_ns() + (uint64_t)interval_ms * 1000000u;
+  for (uint64_t now = monotonic_ns(); now < deadline; now = monotonic_ns()) {
+    const uint64_t left_ms = (deadline - now + 999999u) / 1000000u;
+    bool changed = false;
+    if (sysmon_wait(sysmon, (uint32_t)left_ms, &changed) != SYSMON_OK) {
+      sleep_ns(deadline - now);
+      return;
+    }
+    if (changed) return;
+  }
+}
+
+static uint64_t wall_clock_ns(void) {
+  struct timespec ts;
+  if (timespec_get(&ts, TIME_UTC) != TIME_UTC) return 0;
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool parse_speed(const char *s, double *out_speed) {
+  if (strcmp(s, "max") == 0) {
+    *out_speed = 0.0;
+    return true;
+  }
+  char *end = NULL;
+  double v = strtod(s, &end);
+  if (end == s || v <= 0.0) return false;
+  if (*end == 'x' || *end == 'X') end++;
+  if (*end != '\0') return false;
+  *out_speed = v;
+  return true;
+}
+
+static int replay(const char *path, long iterations, double speed, bool loop, bool json) {
+  sysmon_replay_t *rp = sysmon_replay_open(path);
+  if (!rp) {
+    fprintf(stderr, "failed to open recording: %s\n", path);
+    return 1;
+  }
+  static char out_buf[1 << 16];
+  setvbuf(stdout, out_buf, _IOFBF, sizeof(out_buf));
+
+  int status = 0;
+  uint64_t prev_ts = 0;
+  for (long n = 0; iterations < 0 || n < iterations;) {
+    uint64_t ts = 0;
+    const sysmon_metric_t *metrics = NULL;
+    size_t count = 0;
+    int rc = sysmon_replay_next(rp, &ts, &metrics, &count);
+    if (rc == 0) {
+      if (!loop || n == 0 || !sysmon_replay_rewind(rp)) break;
+      prev_ts = 0;
+      continue;
+    }
+    if (rc < 0) {
+      fprintf(stderr, "malformed recording: %s\n", path);
+      status = 1;
+      break;
+    }
+    if (speed > 0.0 && prev_ts != 0 && ts > prev_ts) {
+      fflush(stdout);
+      sleep_ns((uint64_t)((double)(ts - prev_ts) / speed));
+    }
+    prev_ts = ts;
+    print_metrics(metrics, count, json);
+    n++;
+  }
+
+  fflush(stdout);
+  sysmon_replay_close(rp);
+  return status;
+}
+
 int main(int argc, char **argv) {
   const char *config_path = "sysmon.ini";
+  const char *proc_root = NULL;
+  const char *sys_root = NULL;
+  const char *record_path = NULL;
+  const char *replay_path = NULL;
+  double speed = 1.0;
+  bool loop = false;
   long iterations = -1;
   bool json = false;
 
@@ -138,11 +244,62 @@ int main(int argc, char **argv) {
       json = true;
       continue;
     }
+    if (strcmp(argv[i], "--proc-root") == 0) {
+      if (i + 1 >= argc) {
+        usage(argv[0]);
+        return 2;
+      }
+      proc_root = argv[++i];
+      continue;
+    }
+    if (strcmp(argv[i], "--sys-root") == 0) {
+      if (i + 1 >= argc) {
+        usage(argv[0]);
+        return 2;
+      }
+      sys_root = argv[++i];
+      continue;
+    }
+    if (strcmp(argv[i], "--record") == 0) {
+      if (i + 1 >= argc) {
+        usage(argv[0]);
+        return 2;
+      }
+      record_path = argv[++i];
+      continue;
+    }
+    if (strcmp(argv[i], "--replay") == 0) {
+      if (i + 1 >= argc) {
+        usage(argv[0]);
+        return 2;
+      }
+      replay_path = argv[++i];
+      continue;
+    }
+    if (strcmp(argv[i], "--speed") == 0) {
+      if (i + 1 >= argc || !parse_speed(argv[i + 1], &speed)) {
+        usage(argv[0]);
+        return 2;
+      }
+      i++;
+      continue;
+    }
+    if (strcmp(argv[i], "--loop") == 0) {
+      loop = true;
+      continue;
+    }
     usage(argv[0]);
     return 2;
   }
 
-  sysmon_create_options_t options = {.ini_path = config_path};
+  if (replay_path && record_path) {
+    usage(argv[0]);
+    return 2;
+  }
+  if (replay_path) return replay(replay_path, iterations, speed, loop, json);
+
+  sysmon_create_options_t options = {
+      .ini_path = config_path, .proc_root = proc_root, .sys_root = sys_root};
   sysmon_t *sysmon = NULL;
   sysmon_result_t rc = sysmon_create(&options, &sysmon);
   if (rc != SYSMON_OK) {
@@ -150,6 +307,16 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  sysmon_recorder_t *recorder = NULL;
+  if (record_path) {
+    recorder = sysmon_recorder_open(record_path, wall_clock_ns(), monotonic_ns());
+    if (!recorder) {
+      fprintf(stderr, "failed to open recording: %s\n", record_path);
+      sysmon_destroy(sysmon);
+      return 1;
+    }
+  }
+
   const uint32_t interval_ms = sysmon_interval_ms(sysmon);
   for (long n = 0; iterations < 0 || n < iterations; n++) {
     sysmon_snapshot_t *snapshot = NULL;
@@ -159,15 +326,25 @@ int main(int argc, char **argv) {
               sysmon_last_error(sysmon) ? sysmon_last_error(sysmon) : "");
       break;
     }
-    if (json) {
-      print_json(snapshot);
-    } else {
-      print_human(snapshot);
+    size_t count = 0;
+    const sysmon_metric_t *metrics = sysmon_snapshot_metrics(snapshot, &count);
+    print_metrics(metrics, count, json);
+    if (recorder && !sysmon_recorder_write(recorder, sysmon_snapshot_timestamp_ns(snapshot), metrics,
+                                           count)) {
+      fprintf(stderr, "failed to write recording: %s\n", record_path);
+      sysmon_snapshot_destroy(snapshot);
+      rc = SYSMON_ERR_IO;
+      break;
     }
     sysmon_snapshot_destroy(snapshot);
-    sleep_ms(interval_ms);
+    fflush(stdout);
+    wait_interval(sysmon, interval_ms);
   }
 
+  if (recorder && !sysmon_recorder_close(recorder) && rc == SYSMON_OK) {
+    fprintf(stderr, "failed to write recording: %s\n", record_path);
+    rc = SYSMON_ERR_IO;
+  }
   sysmon_destroy(sysmon);
   return rc == SYSMON_OK ? 0 : 1;
 }
@@ -0,0 +1,411 @@
+#include "sysmon-record.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RECORD_MAGIC "SYSMONR2"
+#define RECORD_MAGIC_LEN 8
+
+typedef struct record_key {
+  char *name;
+  char *unit;
+  sysmon_metric_type_t type;
+} record_key_t;
+
+typedef struct record_buf {
+  unsigned char *data;
+  size_t len;
+  size_t cap;
+} record_buf_t;
+
+struct sysmon_recorder {
+  FILE *f;
+  record_key_t *keys;
+  size_t key_count;
+  size_t key_cap;
+  uint32_t *prev_ids;
+  size_t prev_count;
+  uint64_t last_ts_ns;
+  record_buf_t frame;
+  record_buf_t defs;
+  bool ok;
+};
+
+struct sysmon_replay {
+  FILE *f;
+  record_key_t *keys;
+  size_t key_cap;
+  unsigned char *payload;
+  size_t payload_cap;
+  sysmon_metric_t *metrics;
+  size_t metric_cap;
+  uint64_t ts_ns;
+  uint64_t anchor_wall_ns;
+  uint64_t anchor_mono_ns;
+  long data_offset;
+};
+
+static bool buf_reserve(record_buf_t *b, size_t extra) {
+  if (b->len + extra <= b->cap) return true;
+  size_t cap = b->cap ? b->cap : 256;
+  while (cap < b->len + extra) cap *= 2;
+  void *p = realloc(b->data, cap);
+  if (!p) return false;
+  b->data = (unsigned char *)p;
+  b->cap = cap;
+  return true;
+}
+
+static bool buf_put(record_buf_t *b, const void *data, size_t n) {
+  if (!buf_reserve(b, n)) return false;
+  memcpy(b->data + b->len, data, n);
+  b->len += n;
+  return true;
+}
+
+static bool buf_put_varint(record_buf_t *b, uint64_t v) {
+  if (!buf_reserve(b, 10)) return false;
+  while (v >= 0x80) {
+    b->data[b->len++] = (unsigned char)(v | 0x80);
+    v >>= 7;
+  }
+  b->data[b->len++] = (unsigned char)v;
+  return true;
+}
+
+static bool buf_put_str(record_buf_t *b, const char *s, size_t n) {
+  return buf_put_varint(b, n) && buf_put(b, s, n);
+}
+
+static void free_keys(record_key_t *keys, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    free(keys[i].name);
+    free(keys[i].unit);
+  }
+  free(keys);
+}
+
+sysmon_recorder_t *sysmon_recorder_open(const char *path, uint64_t wall_clock_ns,
+                                        uint64_t monotonic_ns) {
+  if (!path) return NULL;
+  sysmon_recorder_t *rec = (sysmon_recorder_t *)calloc(1, sizeof(*rec));
+  if (!rec) return NULL;
+  record_buf_t header = {0};
+  bool ok = buf_put(&header, RECORD_MAGIC, RECORD_MAGIC_LEN) &&
+            buf_put_varint(&header, wall_clock_ns) && buf_put_varint(&header, monotonic_ns);
+  rec->f = ok ? fopen(path, "wb") : NULL;
+  ok = rec->f && fwrite(header.data, 1, header.len, rec->f) == header.len;
+  free(header.data);
+  if (!ok) {
+    if (rec->f) fclose(rec->f);
+    free(rec);
+    return NULL;
+  }
+  rec->ok = true;
+  return rec;
+}
+
+static bool key_matches(const record_key_t *k, const sysmon_metric_t *m) {
+  if (k->type != m->type || strcmp(k->name, m->name) != 0) return false;
+  if (!k->unit || !m->unit) return k->unit == m->unit;
+  return strcmp(k->unit, m->unit) == 0;
+}
+
+static bool lookup_or_define_key(sysmon_recorder_t *rec, size_t position,
+                                 const sysmon_metric_t *m, uint32_t *out_id) {
+  if (position < rec->prev_count && rec->prev_ids[position] < rec->key_count &&
+      key_matches(&rec->keys[rec->prev_ids[position]], m)) {
+    *out_id = rec->prev_ids[position];
+    return true;
+  }
+  for (size_t i = 0; i < rec->key_count; i++) {
+    if (key_matches(&rec->keys[i], m)) {
+      *out_id = (uint32_t)i;
+      return true;
+    }
+  }
+
+  if (rec->key_count == rec->key_cap) {
+    size_t cap = rec->key_cap ? rec->key_cap * 2 : 64;
+    void *p = realloc(rec->keys, cap * sizeof(*rec->keys));
+    if (!p) return false;
+    rec->keys = (record_key_t *)p;
+    rec->key_cap = cap;
+  }
+  record_key_t *k = &rec->keys[rec->key_count];
+  k->name = strdup(m->name);
+  k->unit = m->unit ? strdup(m->unit) : NULL;
+  k->type = m->type;
+  if (!k->name || (m->unit && !k->unit)) {
+    free(k->name);
+    free(k->unit);
+    return false;
+  }
+  *out_id = (uint32_t)rec->key_count++;
+
+  const unsigned char tag = 'K', type = (unsigned char)m->type;
+  const size_t unit_len = m->unit ? strlen(m->unit) : 0;
+  return buf_put(&rec->defs, &tag, 1) && buf_put_varint(&rec->defs, *out_id) &&
+         buf_put(&rec->defs, &type, 1) && buf_put_str(&rec->defs, m->name, strlen(m->name)) &&
+         buf_put_varint(&rec->defs, m->unit ? unit_len + 1 : 0) &&
+         buf_put(&rec->defs, m->unit ? m->unit : "", unit_len);
+}
+
+static bool put_value(record_buf_t *b, const sysmon_metric_t *m) {
+  switch (m->type) {
+    case SYSMON_METRIC_DOUBLE: {
+      uint64_t bits = 0;
+      memcpy(&bits, &m->value.f64, sizeof(bits));
+      unsigned char raw[8];
+      for (int i = 0; i < 8; i++) raw[i] = (unsigned char)(bits >> (8 * i));
+      return buf_put(b, raw, sizeof(raw));
+    }
+    case SYSMON_METRIC_INT64: {
+      const uint64_t u = (uint64_t)m->value.i64;
+      return buf_put_varint(b, (u << 1) ^ (m->value.i64 < 0 ? ~(uint64_t)0 : 0));
+    }
+    case SYSMON_METRIC_UINT64:
+      return buf_put_varint(b, m->value.u64);
+    case SYSMON_METRIC_STRING: {
+      const char *s = m->value.str ? m->value.str : "";
+      const size_t n = strlen(s);
+      return buf_put_varint(b, n) && buf_put(b, s, n + 1);
+    }
+  }
+  return false;
+}
+
+bool sysmon_recorder_write(sysmon_recorder_t *rec, uint64_t timestamp_ns,
+                           const sysmon_metric_t *metrics, size_t count) {
+  if (!rec || !rec->ok) return false;
+  if (count > rec->prev_count) {
+    void *p = realloc(rec->prev_ids, count * sizeof(*rec->prev_ids));
+    if (!p) return rec->ok = false;
+    rec->prev_ids = (uint32_t *)p;
+  }
+
+  rec->frame.len = 0;
+  rec->defs.len = 0;
+  const uint64_t dt = timestamp_ns > rec->last_ts_ns ? timestamp_ns - rec->last_ts_ns : 0;
+  bool ok = buf_put_varint(&rec->frame, dt) && buf_put_varint(&rec->frame, count);
+  for (size_t i = 0; ok && i < count; i++) {
+    const sysmon_metric_t *m = &metrics[i];
+    uint32_t id = 0;
+    const uint64_t age =
+        m->sample_ns && m->sample_ns <= timestamp_ns ? timestamp_ns - m->sample_ns : 0;
+    ok = m->name && lookup_or_define_key(rec, i, m, &id) && buf_put_varint(&rec->frame, id) &&
+         put_value(&rec->frame, m) && buf_put_varint(&rec->frame, age);
+    if (ok) rec->prev_ids[i] = id;
+  }
+  if (!ok) return rec->ok = false;
+  rec->prev_count = count > rec->prev_count ? count : rec->prev_count;
+  rec->last_ts_ns = timestamp_ns;
+
+  record_buf_t header = {0};
+  const unsigned char tag = 'F';
+  ok = buf_put(&header, &tag, 1) && buf_put_varint(&header, rec->frame.len);
+  ok = ok && fwrite(rec->defs.data ? rec->defs.data : (unsigned char *)"", 1, rec->defs.len,
+                    rec->f) == rec->defs.len;
+  ok = ok && fwrite(header.data, 1, header.len, rec->f) == header.len &&
+       fwrite(rec->frame.data, 1, rec->frame.len, rec->f) == rec->frame.len;
+  free(header.data);
+  return rec->ok = ok;
+}
+
+bool sysmon_recorder_close(sysmon_recorder_t *rec) {
+  if (!rec) return false;
+  bool ok = rec->ok;
+  if (fclose(rec->f) != 0) ok = false;
+  free_keys(rec->keys, rec->key_count);
+  free(rec->prev_ids);
+  free(rec->frame.data);
+  free(rec->defs.data);
+  free(rec);
+  return ok;
+}
+
+static bool read_varint(FILE *f, uint64_t *out) {
+  uint64_t v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int c = fgetc(f);
+    if (c == EOF) return false;
+    v |= (uint64_t)(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      *out = v;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool read_str(FILE *f, size_t len, char **out) {
+  char *s = (char *)malloc(len + 1);
+  if (!s) return false;
+  if (len && fread(s, 1, len, f) != len) {
+    free(s);
+    return false;
+  }
+  s[len] = '\0';
+  *out = s;
+  return true;
+}
+
+static bool decode_varint(const unsigned char **p, const unsigned char *end, uint64_t *out) {
+  uint64_t v = 0;
+  for (int shift = 0; shift < 64 && *p < end; shift += 7) {
+    const unsigned char c = *(*p)++;
+    v |= (uint64_t)(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      *out = v;
+      return true;
+    }
+  }
+  return false;
+}
+
+sysmon_replay_t *sysmon_replay_open(const char *path) {
+  if (!path) return NULL;
+  sysmon_replay_t *rp = (sysmon_replay_t *)calloc(1, sizeof(*rp));
+  if (!rp) return NULL;
+  rp->f = fopen(path, "rb");
+  char magic[RECORD_MAGIC_LEN];
+  if (!rp->f || fread(magic, 1, sizeof(magic), rp->f) != sizeof(magic) ||
+      memcmp(magic, RECORD_MAGIC, RECORD_MAGIC_LEN) != 0 ||
+      !read_varint(rp->f, &rp->anchor_wall_ns) || !read_varint(rp->f, &rp->anchor_mono_ns) ||
+      (rp->data_offset = ftell(rp->f)) < 0) {
+    sysmon_replay_close(rp);
+    return NULL;
+  }
+  return rp;
+}
+
+static bool read_key(sysmon_replay_t *rp) {
+  uint64_t id = 0, name_len = 0, unit_len = 0;
+  int type = 0;
+  if (!read_varint(rp->f, &id) || id > 0xffffffu || (type = fgetc(rp->f)) == EOF ||
+      type > SYSMON_METRIC_STRING || !read_varint(rp->f, &name_len))
+    return false;
+  if (id >= rp->key_cap) {
+    size_t cap = rp->key_cap ? rp->key_cap : 64;
+    while (cap <= id) cap *= 2;
+    void *p = realloc(rp->keys, cap * sizeof(*rp->keys));
+    if (!p) return false;
+    rp->keys = (record_key_t *)p;
+    memset(rp->keys + rp->key_cap, 0, (cap - rp->key_cap) * sizeof(*rp->keys));
+    rp->key_cap = cap;
+  }
+  record_key_t *k = &rp->keys[id];
+  free(k->name);
+  free(k->unit);
+  k->name = NULL;
+  k->unit = NULL;
+  k->type = (sysmon_metric_type_t)type;
+  if (!read_str(rp->f, (size_t)name_len, &k->name) || !read_varint(rp->f, &unit_len)) return false;
+  return unit_len == 0 || read_str(rp->f, (size_t)(unit_len - 1), &k->unit);
+}
+
+static int decode_frame(sysmon_replay_t *rp, size_t len, const sysmon_metric_t **out_metrics,
+                        size_t *out_count) {
+  const unsigned char *p = rp->payload, *end = rp->payload + len;
+  uint64_t dt = 0, count = 0;
+  if (!decode_varint(&p, end, &dt) || !decode_varint(&p, end, &count) || count > len) return -1;
+  const uint64_t ts = rp->ts_ns + dt;
+  if (count > rp->metric_cap) {
+    void *mem = realloc(rp->metrics, (size_t)count * sizeof(*rp->metrics));
+    if (!mem) return -1;
+    rp->metrics = (sysmon_metric_t *)mem;
+    rp->metric_cap = (size_t)count;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    uint64_t id = 0;
+    if (!decode_varint(&p, end, &id) || id >= rp->key_cap || !rp->keys[id].name) return -1;
+    const record_key_t *k = &rp->keys[id];
+    sysmon_metric_t *m = &rp->metrics[i];
+    m->name = k->name;
+    m->unit = k->unit;
+    m->type = k->type;
+    uint64_t v = 0;
+    switch (k->type) {
+      case SYSMON_METRIC_DOUBLE:
+        if (end - p < 8) return -1;
+        for (int b = 0; b < 8; b++) v |= (uint64_t)p[b] << (8 * b);
+        p += 8;
+        memcpy(&m->value.f64, &v, sizeof(v));
+        break;
+      case SYSMON_METRIC_INT64:
+        if (!decode_varint(&p, end, &v)) return -1;
+        m->value.i64 = (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+        break;
+      case SYSMON_METRIC_UINT64:
+        if (!decode_varint(&p, end, &v)) return -1;
+        m->value.u64 = v;
+        break;
+      case SYSMON_METRIC_STRING:
+        if (!decode_varint(&p, end, &v) || v >= (uint64_t)(end - p) || p[v] != '\0') return -1;
+        m->value.str = (const char *)p;
+        p += v + 1;
+        break;
+    }
+    if (!decode_varint(&p, end, &v)) return -1;
+    m->sample_ns = v <= ts ? ts - v : 0;
+  }
+  rp->ts_ns = ts;
+  *out_metrics = rp->metrics;
+  *out_count = (size_t)count;
+  return 1;
+}
+
+/* A record cut short by the end of the file is what a recorder killed mid-write leaves behind:
+ * end of stream rather than corruption. */
+static int read_failed(const sysmon_replay_t *rp) { return feof(rp->f) ? 0 : -1; }
+
+int sysmon_replay_next(sysmon_replay_t *rp, uint64_t *out_timestamp_ns,
+                       const sysmon_metric_t **out_metrics, size_t *out_count) {
+  if (!rp || !out_metrics || !out_count) return -1;
+  for (;;) {
+    int tag = fgetc(rp->f);
+    if (tag == EOF) return 0;
+    if (tag == 'K') {
+      if (!read_key(rp)) return read_failed(rp);
+      continue;
+    }
+    if (tag != 'F') return -1;
+
+    uint64_t len = 0;
+    if (!read_varint(rp->f, &len)) return read_failed(rp);
+    if (len > (1u << 30)) return -1;
+    if (len > rp->payload_cap) {
+      void *p = realloc(rp->payload, (size_t)len);
+      if (!p) return -1;
+      rp->payload = (unsigned char *)p;
+      rp->payload_cap = (size_t)len;
+    }
+    if (len && fread(rp->payload, 1, (size_t)len, rp->f) != len) return read_failed(rp);
+    int rc = decode_frame(rp, (size_t)len, out_metrics, out_count);
+    if (rc == 1 && out_timestamp_ns) *out_timestamp_ns = rp->ts_ns;
+    return rc;
+  }
+}
+
+bool sysmon_replay_rewind(sysmon_replay_t *rp) {
+  if (!rp) return false;
+  rp->ts_ns = 0;
+  return fseek(rp->f, rp->data_offset, SEEK_SET) == 0;
+}
+
+uint64_t sysmon_replay_wall_clock_ns(const sysmon_replay_t *rp, uint64_t timestamp_ns) {
+  if (!rp) return 0;
+  return timestamp_ns >= rp->anchor_mono_ns ? rp->anchor_wall_ns + (timestamp_ns - rp->anchor_mono_ns)
+                                            : rp->anchor_wall_ns - (rp->anchor_mono_ns - timestamp_ns);
+}
+
+void sysmon_replay_close(sysmon_replay_t *rp) {
+  if (!rp) return;
+  if (rp->f) fclose(rp->f);
+  free_keys(rp->keys, rp->key_cap);
+  free(rp->payload);
+  free(rp->metrics);
+  free(rp);
+}
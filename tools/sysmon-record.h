@@ -0,0 +1,42 @@
+#pragma once
+
+#include <sysmon/sysmon.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Compact snapshot stream used by `sysmon-cli --record/--replay`.
+ *
+ * Layout: "SYSMONR2" magic, varint wall_clock_ns, varint monotonic_ns (the same instant on
+ * both clocks), then a sequence of tagged records:
+ *   'K' varint id, u8 type, varint name_len, name, varint unit_len+1 (0 = no unit), unit
+ *   'F' varint payload_len, payload = varint dt_ns, varint count,
+ *       count x (varint id, value, varint age_ns)
+ * Values are varints (uint64), zigzag varints (int64), 8 little-endian bytes (double) or
+ * varint length + bytes + NUL (string). Keys are defined once, the first time they are seen.
+ * Frame timestamps are the snapshot's monotonic capture time; the first frame's dt_ns is its
+ * absolute timestamp. age_ns is how long before it the metric was sampled (sample_ns).
+ * A frame cut short at the end of the file (writer killed mid-write) reads as end of stream.
+ */
+
+typedef struct sysmon_recorder sysmon_recorder_t;
+typedef struct sysmon_replay sysmon_replay_t;
+
+/* wall_clock_ns and monotonic_ns anchor the monotonic frame timestamps to calendar time. */
+sysmon_recorder_t *sysmon_recorder_open(const char *path, uint64_t wall_clock_ns,
+                                        uint64_t monotonic_ns);
+bool sysmon_recorder_write(sysmon_recorder_t *rec, uint64_t timestamp_ns,
+                           const sysmon_metric_t *metrics, size_t count);
+bool sysmon_recorder_close(sysmon_recorder_t *rec);
+
+sysmon_replay_t *sysmon_replay_open(const char *path);
+/* Returns 1 when a frame was decoded, 0 at end of stream, -1 on a malformed stream.
+ * The returned metrics stay valid until the next call. */
+int sysmon_replay_next(sysmon_replay_t *rp, uint64_t *out_timestamp_ns,
+                       const sysmon_metric_t **out_metrics, size_t *out_count);
+bool sysmon_replay_rewind(sysmon_replay_t *rp);
+/* Calendar time of a frame timestamp, from the header anchor. */
+uint64_t sysmon_replay_wall_clock_ns(const sysmon_replay_t *rp, uint64_t timestamp_ns);
+void sysmon_replay_close(sysmon_replay_t *rp);